@@ -21,6 +21,7 @@ find_path(XRT_INCDIR "xclbin.h" PATHS ${XRT_POSSIBLE_ROOT_DIRS} PATH_SUFFIXES ${
 find_path(XRT_INCDIR_OCL "cl_ext_xilinx.h" PATHS ${XRT_POSSIBLE_ROOT_DIRS} PATH_SUFFIXES ${XRT_INCDIR_SUFFIXES} NO_CMAKE_FIND_ROOT_PATH)
 
 find_library(LIBXRT_CORE_LIBRARY NAMES xrt_core PATHS ${XRT_POSSIBLE_ROOT_DIRS} PATH_SUFFIXES ${XRT_LIBDIR_SUFFIXES})
+find_library(LIBXRT_COREUTIL_LIBRARY NAMES xrt_coreutil PATHS ${XRT_POSSIBLE_ROOT_DIRS} PATH_SUFFIXES ${XRT_LIBDIR_SUFFIXES})
 find_library(LIBXRT_XILOCL_LIBRARY NAMES xilinxopencl PATHS ${XRT_POSSIBLE_ROOT_DIRS} PATH_SUFFIXES ${XRT_LIBDIR_SUFFIXES})
 
 set(XRT_INCLUDE_DIR ${XRT_INCDIR} ${XRT_INCDIR_OCL})
@@ -34,6 +35,6 @@ else(EXISTS ${XRT_INCDIR} AND EXISTS ${XRT_INCDIR_OCL})
 endif(EXISTS ${XRT_INCDIR} AND EXISTS ${XRT_INCDIR_OCL})
 
 set(XRT_INCLUDE_DIRS ${XRT_INCLUDE_DIR})
-set(XRT_LIBS ${LIBXRT_CORE_LIBRARY} ${LIBXRT_XILOCL_LIBRARY})
+set(XRT_LIBS ${LIBXRT_CORE_LIBRARY} ${LIBXRT_COREUTIL_LIBRARY} ${LIBXRT_XILOCL_LIBRARY})
 message(STATUS "XRT_INCLUDE_DIRS = ${XRT_INCLUDE_DIRS}")
 message(STATUS "XRT_LIBS         = ${XRT_LIBS}")
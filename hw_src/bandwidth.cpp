@@ -0,0 +1,108 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+/*******************************************************************************
+Description:
+    Memory bandwidth probe. Streams 512-bit words between device memory and
+    the kernel with long bursts and no computation, so its throughput is the
+    ceiling that the bank it is connected to allows a single kernel:
+
+    BANDWIDTH_READ   reads in[0, words), folds it with XOR and writes the
+                     one-word result to out[0] so the reads are not removed
+    BANDWIDTH_WRITE  writes out[0, words) with a pattern derived from the
+                     word index
+    BANDWIDTH_COPY   copies in[0, words) to out[0, words)
+
+    The connectivity files instantiate one compute unit per memory bank
+    (bandwidth_1, bandwidth_2, ...), with both ports of a unit on the same
+    bank.
+*******************************************************************************/
+
+#include <ap_int.h>
+
+#define DATAWIDTH 512
+typedef ap_uint<DATAWIDTH> uint512_dt;
+
+#define BANDWIDTH_READ 0
+#define BANDWIDTH_WRITE 1
+#define BANDWIDTH_COPY 2
+
+/*
+    Memory Bandwidth Kernel
+    Arguments:
+        in     (input)   --> Source words for READ and COPY
+        out    (output)  --> Destination words for WRITE and COPY
+        words  (input)   --> Number of 512-bit words to move
+        mode   (input)   --> BANDWIDTH_READ, BANDWIDTH_WRITE or BANDWIDTH_COPY
+   */
+extern "C"
+{
+    void bandwidth(
+        const uint512_dt *in,     // Source
+        uint512_dt *out,          // Destination
+        unsigned long long words, // Words to move
+        int mode                  // Access pattern
+    )
+    {
+#pragma HLS INTERFACE m_axi port = in max_read_burst_length = 64 num_read_outstanding = 32 offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = out max_write_burst_length = 64 num_write_outstanding = 32 offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = in bundle = control
+#pragma HLS INTERFACE s_axilite port = out bundle = control
+#pragma HLS INTERFACE s_axilite port = words bundle = control
+#pragma HLS INTERFACE s_axilite port = mode bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+        if (mode == BANDWIDTH_READ) {
+            uint512_dt acc = 0;
+        rd:
+            for (unsigned long long i = 0; i < words; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 4194304
+                acc ^= in[i];
+            }
+            out[0] = acc;
+        }
+        else if (mode == BANDWIDTH_WRITE) {
+        wr:
+            for (unsigned long long i = 0; i < words; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 4194304
+                out[i] = uint512_dt(i);
+            }
+        }
+        else if (mode == BANDWIDTH_COPY) {
+        cp:
+            for (unsigned long long i = 0; i < words; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 4194304
+                out[i] = in[i];
+            }
+        }
+    }
+}
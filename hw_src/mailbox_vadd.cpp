@@ -0,0 +1,202 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+/*******************************************************************************
+Description:
+    Persistent variant of wide_vadd. Instead of being started once per job
+    through its s_axilite control registers, the kernel is started once and
+    polls a ring of job descriptors in device memory. The host writes a
+    descriptor per job; the kernel adds the requested range of the in1/in2
+    buffers into out and writes a completion record to a second ring. A STOP
+    descriptor makes the kernel return.
+
+    Both rings hold 'ring_entries' records of one 512-bit word each:
+
+    Descriptor  bits  31:0    sequence number (1, 2, 3, ... skipping 0)
+                bits  63:32   opcode (MAILBOX_OP_*)
+                bits 127:64   first element (a multiple of 16)
+                bits 191:128  element count
+                bits 511:480  sequence number again
+
+    Completion  bits  31:0    sequence number of the job
+                bits  63:32   status (MAILBOX_STATUS_*)
+
+    A descriptor is only accepted once both copies of its sequence number
+    match the one expected next, so a record that is still being written by
+    the host's DMA is never acted on.
+*******************************************************************************/
+
+#include <ap_int.h>
+
+#define BUFFER_SIZE 64
+#define DATAWIDTH 512
+#define VECTOR_SIZE (DATAWIDTH / 32) // vector size is 16 (512/32 = 16)
+typedef ap_uint<DATAWIDTH> uint512_dt;
+
+#define MAILBOX_OP_VADD 1
+#define MAILBOX_OP_STOP 2
+
+#define MAILBOX_STATUS_OK 0
+#define MAILBOX_STATUS_BAD_RANGE 1
+#define MAILBOX_STATUS_BAD_OP 2
+
+// Element-wise addition of the sixteen 32-bit lanes, as in wide_vadd
+static uint512_dt add_lanes(uint512_dt a, uint512_dt b)
+{
+#pragma HLS INLINE
+    uint512_dt sum;
+    for (int k = 0; k < VECTOR_SIZE; k++) {
+#pragma HLS UNROLL
+        sum.range(32 * k + 31, 32 * k) = (ap_uint<32>)a.range(32 * k + 31, 32 * k) + (ap_uint<32>)b.range(32 * k + 31, 32 * k);
+    }
+    return sum;
+}
+
+// Adds words [first, first + count) of in1 and in2 into out, in the same
+// chunked dataflow form as wide_vadd
+static void add_range(const uint512_dt *in1,
+                      const uint512_dt *in2,
+                      uint512_dt *out,
+                      unsigned long long first,
+                      unsigned long long count)
+{
+    uint512_dt v1_local[BUFFER_SIZE];
+    uint512_dt v2_local[BUFFER_SIZE];
+
+    for (unsigned long long i = first; i < first + count; i += BUFFER_SIZE) {
+#pragma HLS DATAFLOW
+#pragma HLS stream variable = v1_local depth = 64
+#pragma HLS stream variable = v2_local depth = 64
+
+        int chunk_size = BUFFER_SIZE;
+        if ((i + BUFFER_SIZE) > first + count)
+            chunk_size = first + count - i;
+
+    v1_rd:
+        for (int j = 0; j < chunk_size; j++) {
+#pragma HLS pipeline
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 64
+            v1_local[j] = in1[i + j];
+            v2_local[j] = in2[i + j];
+        }
+
+    v2_rd_add:
+        for (int j = 0; j < chunk_size; j++) {
+#pragma HLS pipeline
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 64
+            out[i + j] = add_lanes(v1_local[j], v2_local[j]);
+        }
+    }
+}
+
+/*
+    Persistent Vector Addition Kernel
+    Arguments:
+        in1          (input)     --> Input Vector1
+        in2          (input)     --> Input Vector2
+        out          (output)    --> Output Vector
+        cmd_ring     (input)     --> Job descriptors written by the host
+        cpl_ring     (output)    --> Completion records read by the host
+        ring_entries (input)     --> Records in each ring
+        capacity     (input)     --> Size of in1/in2/out in integers
+
+    Jobs start on a word boundary and are processed in whole 512-bit words,
+    so the lanes after a job's last element in its last word are overwritten.
+    No other job can own them, and a job whose last word would pass
+    'capacity' is rejected.
+   */
+extern "C"
+{
+    void mailbox_vadd(const uint512_dt *in1,
+                      const uint512_dt *in2,
+                      uint512_dt *out,
+                      volatile uint512_dt *cmd_ring,
+                      volatile uint512_dt *cpl_ring,
+                      unsigned int ring_entries,
+                      unsigned long long capacity)
+    {
+#pragma HLS INTERFACE m_axi port = in1 max_read_burst_length = 32 offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = in2 max_read_burst_length = 32 offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out max_write_burst_length = 32 offset = slave bundle = gmem2
+#pragma HLS INTERFACE m_axi port = cmd_ring offset = slave bundle = gmem3
+#pragma HLS INTERFACE m_axi port = cpl_ring offset = slave bundle = gmem3
+#pragma HLS INTERFACE s_axilite port = in1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out bundle = control
+#pragma HLS INTERFACE s_axilite port = cmd_ring bundle = control
+#pragma HLS INTERFACE s_axilite port = cpl_ring bundle = control
+#pragma HLS INTERFACE s_axilite port = ring_entries bundle = control
+#pragma HLS INTERFACE s_axilite port = capacity bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+        unsigned int head     = 0;
+        unsigned int expected = 1;
+        bool running          = true;
+
+    poll:
+        while (running) {
+            // Volatile single-beat reads, so every iteration goes to memory
+            uint512_dt desc = cmd_ring[head];
+            if (desc.range(31, 0) != expected || desc.range(511, 480) != expected) {
+                continue;
+            }
+
+            unsigned int op          = desc.range(63, 32);
+            unsigned long long first = desc.range(127, 64);
+            unsigned long long count = desc.range(191, 128);
+            unsigned int status      = MAILBOX_STATUS_OK;
+
+            if (op == MAILBOX_OP_STOP) {
+                running = false;
+            }
+            else if (op != MAILBOX_OP_VADD) {
+                status = MAILBOX_STATUS_BAD_OP;
+            }
+            else if (first % VECTOR_SIZE != 0 || first > capacity ||
+                     (count + VECTOR_SIZE - 1) / VECTOR_SIZE > (capacity - first) / VECTOR_SIZE) {
+                status = MAILBOX_STATUS_BAD_RANGE;
+            }
+            else if (count > 0) {
+                // The bursts to out complete before add_range() returns, so
+                // the results are in memory before the completion record
+                add_range(in1, in2, out, first / VECTOR_SIZE, (count + VECTOR_SIZE - 1) / VECTOR_SIZE);
+            }
+
+            uint512_dt cpl    = 0;
+            cpl.range(31, 0)  = expected;
+            cpl.range(63, 32) = status;
+            cpl_ring[head]    = cpl;
+
+            head = (head + 1 == ring_entries) ? 0 : head + 1;
+            if (++expected == 0) {
+                expected = 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,174 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+/*******************************************************************************
+Description:
+    Striped variant of wide_vadd for HBM cards. Each operand is split into
+    four contiguous stripes held in separate buffers, and every stripe of
+    every operand has an AXI master of its own, so the connectivity file can
+    put each one on a different HBM pseudo-channel. The stripes are added by
+    four concurrent dataflow processes, so the kernel draws on the bandwidth
+    of twelve channels at once instead of one channel per operand.
+
+    Element i of the logical vector lives in stripe i / stripe_size, at offset
+    i % stripe_size. Addition is element-wise, so no stripe needs data from
+    any other.
+*******************************************************************************/
+
+#include <ap_int.h>
+
+#define BUFFER_SIZE 64
+#define DATAWIDTH 512
+#define VECTOR_SIZE (DATAWIDTH / 32) // vector size is 16 (512/32 = 16)
+typedef ap_uint<DATAWIDTH> uint512_dt;
+
+// Element-wise addition of the sixteen 32-bit lanes, as in wide_vadd
+static uint512_dt add_lanes(uint512_dt a, uint512_dt b)
+{
+#pragma HLS INLINE
+    uint512_dt sum;
+    for (int k = 0; k < VECTOR_SIZE; k++) {
+#pragma HLS UNROLL
+        sum.range(32 * k + 31, 32 * k) = (ap_uint<32>)a.range(32 * k + 31, 32 * k) + (ap_uint<32>)b.range(32 * k + 31, 32 * k);
+    }
+    return sum;
+}
+
+// Words of the stripe 'stripe' holds of a 'size' element vector. A partial
+// last word is processed whole: stripes are padded to whole pages, so the
+// lanes past 'size' are padding that nothing else uses.
+static unsigned long long stripe_words(unsigned long long size, unsigned long long stripe_size, int stripe)
+{
+    unsigned long long first = stripe * stripe_size;
+    if (size <= first)
+        return 0;
+    unsigned long long count = (size - first < stripe_size) ? size - first : stripe_size;
+    return (count + VECTOR_SIZE - 1) / VECTOR_SIZE;
+}
+
+// wide_vadd's loop over one stripe
+static void add_stripe(const uint512_dt *in1,
+                       const uint512_dt *in2,
+                       uint512_dt *out,
+                       unsigned long long size,
+                       unsigned long long stripe_size,
+                       int stripe)
+{
+    unsigned long long size_in16 = stripe_words(size, stripe_size, stripe);
+    uint512_dt v1_local[BUFFER_SIZE];
+    uint512_dt v2_local[BUFFER_SIZE];
+
+    for (unsigned long long i = 0; i < size_in16; i += BUFFER_SIZE) {
+#pragma HLS DATAFLOW
+#pragma HLS stream variable = v1_local depth = 64
+#pragma HLS stream variable = v2_local depth = 64
+
+        int chunk_size = BUFFER_SIZE;
+        if ((i + BUFFER_SIZE) > size_in16)
+            chunk_size = size_in16 - i;
+
+    v1_rd:
+        for (int j = 0; j < chunk_size; j++) {
+#pragma HLS pipeline
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 64
+            v1_local[j] = in1[i + j];
+            v2_local[j] = in2[i + j];
+        }
+
+    v2_rd_add:
+        for (int j = 0; j < chunk_size; j++) {
+#pragma HLS pipeline
+#pragma HLS LOOP_TRIPCOUNT min = 1 max = 64
+            out[i + j] = add_lanes(v1_local[j], v2_local[j]);
+        }
+    }
+}
+
+/*
+    Striped Vector Addition Kernel
+    Arguments:
+        in1_N        (input)     --> Stripe N of Input Vector1
+        in2_N        (input)     --> Stripe N of Input Vector2
+        out_N        (output)    --> Stripe N of Output Vector
+        size         (input)     --> Size of Vector in Integer
+        stripe_size  (input)     --> Integers per stripe, a multiple of 16
+   */
+extern "C"
+{
+    void striped_vadd(const uint512_dt *in1_0,
+                      const uint512_dt *in1_1,
+                      const uint512_dt *in1_2,
+                      const uint512_dt *in1_3,
+                      const uint512_dt *in2_0,
+                      const uint512_dt *in2_1,
+                      const uint512_dt *in2_2,
+                      const uint512_dt *in2_3,
+                      uint512_dt *out_0,
+                      uint512_dt *out_1,
+                      uint512_dt *out_2,
+                      uint512_dt *out_3,
+                      unsigned long long size,
+                      unsigned long long stripe_size)
+    {
+#pragma HLS INTERFACE m_axi port = in1_0 max_read_burst_length = 32 offset = slave bundle = gmem_in1_0
+#pragma HLS INTERFACE m_axi port = in1_1 max_read_burst_length = 32 offset = slave bundle = gmem_in1_1
+#pragma HLS INTERFACE m_axi port = in1_2 max_read_burst_length = 32 offset = slave bundle = gmem_in1_2
+#pragma HLS INTERFACE m_axi port = in1_3 max_read_burst_length = 32 offset = slave bundle = gmem_in1_3
+#pragma HLS INTERFACE m_axi port = in2_0 max_read_burst_length = 32 offset = slave bundle = gmem_in2_0
+#pragma HLS INTERFACE m_axi port = in2_1 max_read_burst_length = 32 offset = slave bundle = gmem_in2_1
+#pragma HLS INTERFACE m_axi port = in2_2 max_read_burst_length = 32 offset = slave bundle = gmem_in2_2
+#pragma HLS INTERFACE m_axi port = in2_3 max_read_burst_length = 32 offset = slave bundle = gmem_in2_3
+#pragma HLS INTERFACE m_axi port = out_0 max_write_burst_length = 32 offset = slave bundle = gmem_out_0
+#pragma HLS INTERFACE m_axi port = out_1 max_write_burst_length = 32 offset = slave bundle = gmem_out_1
+#pragma HLS INTERFACE m_axi port = out_2 max_write_burst_length = 32 offset = slave bundle = gmem_out_2
+#pragma HLS INTERFACE m_axi port = out_3 max_write_burst_length = 32 offset = slave bundle = gmem_out_3
+#pragma HLS INTERFACE s_axilite port = in1_0 bundle = control
+#pragma HLS INTERFACE s_axilite port = in1_1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in1_2 bundle = control
+#pragma HLS INTERFACE s_axilite port = in1_3 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2_0 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2_1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2_2 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2_3 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_0 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_1 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_3 bundle = control
+#pragma HLS INTERFACE s_axilite port = size bundle = control
+#pragma HLS INTERFACE s_axilite port = stripe_size bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+        // Independent processes on disjoint ports run concurrently
+#pragma HLS DATAFLOW
+        add_stripe(in1_0, in2_0, out_0, size, stripe_size, 0);
+        add_stripe(in1_1, in2_1, out_1, size, stripe_size, 1);
+        add_stripe(in1_2, in2_2, out_2, size, stripe_size, 2);
+        add_stripe(in1_3, in2_3, out_3, size, stripe_size, 3);
+    }
+}
@@ -50,7 +50,7 @@ extern "C"
         const unsigned int *in1, // Read-Only Vector 1
         const unsigned int *in2, // Read-Only Vector 2
         unsigned int *out,       // Output Result
-        int size                 // Size in integer
+        unsigned long long size  // Size in integer
     )
     {
 // SDAccel kernel must have one and only one s_axilite interface which will be used by host application to configure the kernel.
@@ -75,7 +75,7 @@ extern "C"
         unsigned int vout_buffer[BUFFER_SIZE]; // Local Memory to store result
 
         //Per iteration of this loop perform BUFFER_SIZE vector addition
-        for (int i = 0; i < size; i += BUFFER_SIZE) {
+        for (unsigned long long i = 0; i < size; i += BUFFER_SIZE) {
             int chunk_size = BUFFER_SIZE;
             //boundary checks
             if ((i + BUFFER_SIZE) > size)
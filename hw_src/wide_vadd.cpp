@@ -49,21 +49,38 @@ typedef ap_uint<DATAWIDTH> uint512_dt;
 const unsigned int c_chunk_sz = BUFFER_SIZE;
 const unsigned int c_size     = VECTOR_SIZE;
 
+// Element-wise addition of the sixteen 32-bit lanes. A plain 512-bit add
+// would carry out of each element into the next one.
+static uint512_dt add_lanes(uint512_dt a, uint512_dt b)
+{
+#pragma HLS INLINE
+    uint512_dt sum;
+    for (int k = 0; k < VECTOR_SIZE; k++) {
+#pragma HLS UNROLL
+        sum.range(32 * k + 31, 32 * k) = (ap_uint<32>)a.range(32 * k + 31, 32 * k) + (ap_uint<32>)b.range(32 * k + 31, 32 * k);
+    }
+    return sum;
+}
+
 /*
     Vector Addition Kernel Implementation using uint512_dt datatype
     Arguments:
         in1   (input)     --> Input Vector1
         in2   (input)     --> Input Vector2
         out   (output)    --> Output Vector
-        size  (input)     --> Size of Vector in Integer
+        size  (input)     --> Size of Vector in Integer, any length
+
+    The vectors are accessed in whole 512-bit words, so in1, in2 and out must
+    each be padded to a multiple of 64 bytes. When size is not a multiple of
+    16, the lanes after it in the last word of out are overwritten.
    */
 extern "C"
 {
     void wide_vadd(
-        const uint512_dt *in1, // Read-Only Vector 1
-        const uint512_dt *in2, // Read-Only Vector 2
-        uint512_dt *out,       // Output Result
-        int size               // Size in integer
+        const uint512_dt *in1,  // Read-Only Vector 1
+        const uint512_dt *in2,  // Read-Only Vector 2
+        uint512_dt *out,        // Output Result
+        unsigned long long size // Size in integer
     )
     {
 #pragma HLS INTERFACE m_axi port = in1 max_write_burst_length = 32 max_read_burst_length = 32 offset = slave bundle = gmem
@@ -80,12 +97,12 @@ extern "C"
         uint512_dt result_local[BUFFER_SIZE]; // Local Memory to store result
 
         // Input vector size for integer vectors. However kernel is directly
-        // accessing 512bit data (total 16 elements). So total number of read
-        // from global memory is calculated here:
-        int size_in16 = (size - 1) / VECTOR_SIZE + 1;
+        // accessing 512bit data (total 16 elements). A partial last word is
+        // processed whole, which the padding described above allows.
+        unsigned long long size_in16 = (size + VECTOR_SIZE - 1) / VECTOR_SIZE;
 
         //Per iteration of this loop perform BUFFER_SIZE vector addition
-        for (int i = 0; i < size_in16; i += BUFFER_SIZE) {
+        for (unsigned long long i = 0; i < size_in16; i += BUFFER_SIZE) {
 //#pragma HLS PIPELINE
 #pragma HLS DATAFLOW
 #pragma HLS stream variable = v1_local depth = 64
@@ -113,7 +130,7 @@ extern "C"
 #pragma HLS LOOP_TRIPCOUNT min = 1 max = 64
                 uint512_dt tmpV1 = v1_local[j];
                 uint512_dt tmpV2 = v2_local[j];
-                out[i + j]       = tmpV1 + tmpV2; // Vector Addition Operation
+                out[i + j]       = add_lanes(tmpV1, tmpV2); // Vector Addition Operation
             }
         }
     }
@@ -30,6 +30,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "event_timer.hpp"
 
+#include <future>
 #include <iostream>
 #include <string>
 
@@ -38,9 +39,9 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define BUFSIZE (1024 * 1024 * 6)
 
-void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t size)
+void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, size_t size)
 {
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         c[i] = a[i] + b[i];
     }
 }
@@ -53,19 +54,14 @@ int main(int argc, char *argv[])
     std::cout << "-- Example 1: Vector Add with Malloc() --" << std::endl
               << std::endl;
 
-    // Initialize the runtime (including a command queue) and load the
-    // FPGA image
+    // Initialize the runtime and load the FPGA image in the background while
+    // the host buffers are filled and the software reference is computed
     std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
               << std::endl;
-    et.add("OpenCL Initialization");
 
     // This application will use the first Xilinx device found in the system
     xilinx::example_utils::XilinxOclHelper xocl;
-    xocl.initialize("alveo_examples.xclbin");
-
-    cl::CommandQueue q = xocl.get_command_queue();
-    cl::Kernel krnl    = xocl.get_kernel("vadd");
-    et.finish();
+    std::shared_future<void> ocl_ready = xocl.initialize_async("alveo_examples.xclbin");
 
     /// New code for example 01
     std::cout << "Running kernel test with malloc()ed buffers" << std::endl;
@@ -89,6 +85,13 @@ int main(int argc, char *argv[])
     vadd_sw(a, b, d, BUFSIZE);
     et.finish();
 
+    et.add("Wait for OpenCL initialization");
+    ocl_ready.get();
+
+    cl::CommandQueue q = xocl.get_command_queue();
+    cl::Kernel krnl    = xocl.get_kernel("vadd");
+    et.finish();
+
     // Map our user-allocated buffers as OpenCL buffers using a shared
     // host pointer
     et.add("Map host buffers to OpenCL buffers");
@@ -117,7 +120,7 @@ int main(int argc, char *argv[])
     krnl.setArg(0, a_to_device);
     krnl.setArg(1, b_to_device);
     krnl.setArg(2, c_from_device);
-    krnl.setArg(3, BUFSIZE);
+    krnl.setArg(3, (uint64_t)BUFSIZE);
 
     // Send the buffers down to the Alveo card
     et.add("Memory object migration enqueue");
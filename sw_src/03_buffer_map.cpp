@@ -39,9 +39,9 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define BUFSIZE (1024 * 1024 * 6)
 
-void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t size)
+void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, size_t size)
 {
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         c[i] = a[i] + b[i];
     }
 }
@@ -113,7 +113,7 @@ int main(int argc, char *argv[])
     krnl.setArg(0, a_buf);
     krnl.setArg(1, b_buf);
     krnl.setArg(2, c_buf);
-    krnl.setArg(3, BUFSIZE);
+    krnl.setArg(3, (uint64_t)BUFSIZE);
 
     et.add("Map buffers to userspace pointers");
     uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_buf,
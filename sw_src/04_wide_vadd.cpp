@@ -30,21 +30,20 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "event_timer.hpp"
 
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
 
 // Xilinx OpenCL and XRT includes
+#include "verify.hpp"
 #include "xilinx_ocl_helper.hpp"
 
 #define BUFSIZE (1024 * 1024 * 32)
 
-void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t size)
-{
-    for (int i = 0; i < size; i++) {
-        c[i] = a[i] + b[i];
-    }
-}
+// hash_buffer() of the BUFSIZE-element output of a known-good run, used by
+// --hash. Re-record it from this example's output if BUFSIZE changes.
+#define VADD_DIGEST 0xb784bb4fd97eb272ULL
 
 int main(int argc, char *argv[])
 {
@@ -54,6 +53,15 @@ int main(int argc, char *argv[])
     std::cout << "-- Example 4: Parallelizing the Data Path --" << std::endl
               << std::endl;
 
+    // With --hash the output is checked against a recorded digest instead of
+    // element by element. That is a single read-only pass over the buffer, but
+    // only says whether the result is right, not where it is wrong.
+    bool use_hash = (argc == 2 && std::string(argv[1]) == "--hash");
+    if (argc > 2 || (argc == 2 && !use_hash)) {
+        std::cout << "Usage: " << argv[0] << " [--hash]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     // Initialize the runtime (including a command queue) and load the
     // FPGA image
     std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
@@ -75,10 +83,6 @@ int main(int argc, char *argv[])
     // Map our user-allocated buffers as OpenCL buffers using a shared
     // host pointer
     et.add("Allocate contiguous OpenCL buffers");
-    cl_mem_ext_ptr_t bank_ext;
-    bank_ext.flags = 0 | XCL_MEM_TOPOLOGY;
-    bank_ext.obj   = NULL;
-    bank_ext.param = 0;
     cl::Buffer a_buf(xocl.get_context(),
                      static_cast<cl_mem_flags>(CL_MEM_READ_ONLY),
                      BUFSIZE * sizeof(uint32_t),
@@ -94,24 +98,16 @@ int main(int argc, char *argv[])
                      BUFSIZE * sizeof(uint32_t),
                      NULL,
                      NULL);
-    cl::Buffer d_buf(xocl.get_context(),
-                     static_cast<cl_mem_flags>(CL_MEM_READ_WRITE |
-                                               CL_MEM_ALLOC_HOST_PTR |
-                                               CL_MEM_EXT_PTR_XILINX),
-                     BUFSIZE * sizeof(uint32_t),
-                     &bank_ext,
-                     NULL);
     et.finish();
 
     // Set vadd kernel arguments. We do this before mapping the buffers to allow XRT
     // to allocate the buffers in the appropriate memory banks for the selected
-    // kernels. For buffer 'd' we explicitly set a bank above, but this buffer is
-    // never migrated to the Alveo card so this mapping is theoretical.
+    // kernels.
     et.add("Set kernel arguments");
     krnl.setArg(0, a_buf);
     krnl.setArg(1, b_buf);
     krnl.setArg(2, c_buf);
-    krnl.setArg(3, BUFSIZE);
+    krnl.setArg(3, (uint64_t)BUFSIZE);
 
     et.add("Map buffers to userspace pointers");
     uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_buf,
@@ -124,11 +120,6 @@ int main(int argc, char *argv[])
                                                  CL_MAP_WRITE,
                                                  0,
                                                  BUFSIZE * sizeof(uint32_t));
-    uint32_t *d = (uint32_t *)q.enqueueMapBuffer(d_buf,
-                                                 CL_TRUE,
-                                                 CL_MAP_WRITE | CL_MAP_READ,
-                                                 0,
-                                                 BUFSIZE * sizeof(uint32_t));
     et.finish();
 
     et.add("Populating buffer inputs");
@@ -138,11 +129,6 @@ int main(int argc, char *argv[])
     }
     et.finish();
 
-    // For comparison, let's have the CPU calculate the result
-    et.add("Software VADD run");
-    vadd_sw(a, b, d, BUFSIZE);
-    et.finish();
-
     // Send the buffers down to the Alveo card
     et.add("Memory object migration enqueue");
     cl::Event event_sp;
@@ -166,13 +152,26 @@ int main(int argc, char *argv[])
 
 
     // Verify the results
-    bool verified = true;
-    for (int i = 0; i < BUFSIZE; i++) {
-        if (c[i] != d[i]) {
-            verified = false;
-            std::cout << "ERROR: software and hardware vadd do not match: "
-                      << c[i] << "!=" << d[i] << " at position " << i << std::endl;
-            break;
+    bool verified;
+    if (use_hash) {
+        et.add("Verify results (digest)");
+        uint64_t digest = xilinx::example_utils::hash_buffer(c, BUFSIZE);
+        et.finish();
+        verified = (digest == VADD_DIGEST);
+        if (!verified) {
+            std::cout << "ERROR: result digest 0x" << std::hex << digest << " does not match the recorded 0x"
+                      << VADD_DIGEST << std::dec << std::endl;
+        }
+    }
+    else {
+        et.add("Verify results");
+        xilinx::example_utils::VerifyResult result =
+            xilinx::example_utils::verify_buffer(c, BUFSIZE, xilinx::example_utils::vadd_expected);
+        et.finish();
+        verified = result.ok();
+        if (!verified) {
+            std::cout << "ERROR: software and hardware vadd do not match: ";
+            xilinx::example_utils::print_verify_result(std::cout, result);
         }
     }
 
@@ -197,7 +196,6 @@ int main(int argc, char *argv[])
     q.enqueueUnmapMemObject(a_buf, a);
     q.enqueueUnmapMemObject(b_buf, b);
     q.enqueueUnmapMemObject(c_buf, c);
-    q.enqueueUnmapMemObject(d_buf, d);
     q.finish();
 
 
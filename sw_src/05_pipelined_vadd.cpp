@@ -36,18 +36,12 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 
 // Xilinx OpenCL and XRT includes
+#include "verify.hpp"
 #include "xilinx_ocl_helper.hpp"
 
 #define BUFSIZE (1024 * 1024 * 32)
 #define NUM_BUFS 10
 
-void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t size)
-{
-    for (int i = 0; i < size; i++) {
-        c[i] = a[i] + b[i];
-    }
-}
-
 int subdivide_buffer(std::vector<cl::Buffer> &divided,
                      cl::Buffer buf_in,
                      cl_mem_flags flags,
@@ -67,16 +61,18 @@ int subdivide_buffer(std::vector<cl::Buffer> &divided,
     region.origin = 0;
     region.size   = size / num_divisions;
 
-    // Round region size up to nearest 4k for efficient burst behavior
-    if (region.size % 4096 != 0) {
-        region.size += (4096 - (region.size % 4096));
+    // Sub-buffer origins must be 4k aligned, so round the region size down
+    // and let the last region take the remainder. wide_vadd reads and writes
+    // whole 64-byte words, so that remainder must be whole words too, which
+    // holds as long as the parent buffer is.
+    if (size % 64 != 0) {
+        return -1;
     }
+    region.size -= region.size % 4096;
 
     for (int i = 0; i < num_divisions; i++) {
         if (i == num_divisions - 1) {
-            if ((region.origin + region.size) > size) {
-                region.size = size - region.origin;
-            }
+            region.size = size - region.origin;
         }
         cl::Buffer buf = buf_in.createSubBuffer(flags,
                                                 CL_BUFFER_CREATE_TYPE_REGION,
@@ -123,7 +119,7 @@ int enqueue_subbuf_vadd(cl::CommandQueue &q,
     krnl.setArg(0, a);
     krnl.setArg(1, b);
     krnl.setArg(2, c);
-    krnl.setArg(3, (uint32_t)(size / sizeof(uint32_t)));
+    krnl.setArg(3, (uint64_t)(size / sizeof(uint32_t)));
 
     q.enqueueTask(krnl, &krnl_events, &k_event);
     krnl_events.push_back(k_event);
@@ -188,7 +184,6 @@ int main(int argc, char *argv[])
                          BUFSIZE * sizeof(uint32_t),
                          NULL,
                          NULL);
-        uint32_t *d = new uint32_t[BUFSIZE];
         et.finish();
 
         // Although we'll change these later, we'll set the buffers as kernel
@@ -224,11 +219,6 @@ int main(int argc, char *argv[])
         }
         et.finish();
 
-        // For comparison, let's have the CPU calculate the result
-        et.add("Software VADD run");
-        vadd_sw(a, b, d, BUFSIZE);
-        et.finish();
-
         // Send the buffers down to the Alveo card
         et.add("Memory object migration enqueue");
         q.enqueueUnmapMemObject(a_buf, a);
@@ -252,14 +242,14 @@ int main(int argc, char *argv[])
 
 
         // Verify the results
-        bool verified = true;
-        for (int i = 0; i < BUFSIZE; i++) {
-            if (c[i] != d[i]) {
-                verified = false;
-                std::cout << "ERROR: software and hardware vadd do not match: "
-                          << c[i] << "!=" << d[i] << " at position " << i << std::endl;
-                break;
-            }
+        et.add("Verify results");
+        xilinx::example_utils::VerifyResult result =
+            xilinx::example_utils::verify_buffer(c, BUFSIZE, xilinx::example_utils::vadd_expected);
+        et.finish();
+        bool verified = result.ok();
+        if (!verified) {
+            std::cout << "ERROR: software and hardware vadd do not match: ";
+            xilinx::example_utils::print_verify_result(std::cout, result);
         }
 
         if (verified) {
@@ -281,7 +271,6 @@ int main(int argc, char *argv[])
 
 
         q.enqueueUnmapMemObject(c_buf, c);
-        free(d);
         q.finish();
 
 
@@ -39,16 +39,25 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <omp.h>
 
 // Xilinx OpenCL and XRT includes
+#include "numa_utils.hpp"
+#include "verify.hpp"
 #include "xilinx_ocl_helper.hpp"
 
 #define BUFSIZE (1024 * 1024 * 32)
 #define NUM_BUFS 10
 
-void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, uint32_t size)
+// Pin the calling thread and every OpenMP worker to the CPUs of the NUMA node
+// the card is attached to. OpenMP reuses its thread team across parallel
+// regions, so this only needs to happen once.
+void pin_threads_to_node(int node)
 {
-#pragma omp parallel for
-    for (int i = 0; i < size; i++) {
-        c[i] = a[i] + b[i];
+    if (node < 0) {
+        return;
+    }
+    xilinx::example_utils::pin_thread_to_numa_node(node);
+#pragma omp parallel
+    {
+        xilinx::example_utils::pin_thread_to_numa_node(node);
     }
 }
 
@@ -68,16 +77,18 @@ int subdivide_buffer(std::vector<cl::Buffer> &divided, cl::Buffer buf_in, cl_mem
     region.origin = 0;
     region.size   = size / num_divisions;
 
-    // Round region size up to nearest 4k for efficient burst behavior
-    if (region.size % 4096 != 0) {
-        region.size += (4096 - (region.size % 4096));
+    // Sub-buffer origins must be 4k aligned, so round the region size down
+    // and let the last region take the remainder. wide_vadd reads and writes
+    // whole 64-byte words, so that remainder must be whole words too, which
+    // holds as long as the parent buffer is.
+    if (size % 64 != 0) {
+        return -1;
     }
+    region.size -= region.size % 4096;
 
     for (int i = 0; i < num_divisions; i++) {
         if (i == num_divisions - 1) {
-            if ((region.origin + region.size) > size) {
-                region.size = size - region.origin;
-            }
+            region.size = size - region.origin;
         }
         cl::Buffer buf = buf_in.createSubBuffer(flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
         if (err != CL_SUCCESS) {
@@ -116,7 +127,7 @@ int enqueue_subbuf_vadd(cl::CommandQueue &q, cl::Kernel &krnl, cl::Event &event,
     krnl.setArg(0, a);
     krnl.setArg(1, b);
     krnl.setArg(2, c);
-    krnl.setArg(3, (uint32_t)(size / sizeof(uint32_t)));
+    krnl.setArg(3, (uint64_t)(size / sizeof(uint32_t)));
 
     q.enqueueTask(krnl, &krnl_events, &k_event);
     krnl_events.push_back(k_event);
@@ -152,6 +163,15 @@ int main(int argc, char *argv[])
     cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
     et.finish();
 
+    // Keep the host threads that touch the buffers on the card's socket so
+    // that populating and DMA traffic do not cross the inter-socket link
+    int numa_node = xocl.get_numa_node();
+    if (numa_node >= 0) {
+        std::cout << "Card is attached to NUMA node " << numa_node
+                  << ", pinning host threads to it" << std::endl;
+    }
+    pin_threads_to_node(numa_node);
+
     /// New code for example 01
     std::cout << std::endl
               << std::endl;
@@ -177,7 +197,6 @@ int main(int argc, char *argv[])
                          BUFSIZE * sizeof(uint32_t),
                          NULL,
                          NULL);
-        uint32_t *d = new uint32_t[BUFSIZE];
         et.finish();
 
         // Although we'll change these later, we'll set the buffers as kernel
@@ -207,17 +226,13 @@ int main(int argc, char *argv[])
 
 
         et.add("Populating buffer inputs");
+#pragma omp parallel for
         for (int i = 0; i < BUFSIZE; i++) {
             a[i] = i;
             b[i] = 2 * i;
         }
         et.finish();
 
-        // For comparison, let's have the CPU calculate the result
-        et.add("Software VADD run");
-        vadd_sw(a, b, d, BUFSIZE);
-        et.finish();
-
         // Send the buffers down to the Alveo card
         et.add("Memory object migration enqueue");
         q.enqueueUnmapMemObject(a_buf, a);
@@ -241,14 +256,14 @@ int main(int argc, char *argv[])
 
 
         // Verify the results
-        bool verified = true;
-        for (int i = 0; i < BUFSIZE; i++) {
-            if (c[i] != d[i]) {
-                verified = false;
-                std::cout << "ERROR: software and hardware vadd do not match: "
-                          << c[i] << "!=" << d[i] << " at position " << i << std::endl;
-                break;
-            }
+        et.add("Verify results");
+        xilinx::example_utils::VerifyResult result =
+            xilinx::example_utils::verify_buffer(c, BUFSIZE, xilinx::example_utils::vadd_expected);
+        et.finish();
+        bool verified = result.ok();
+        if (!verified) {
+            std::cout << "ERROR: software and hardware vadd do not match: ";
+            xilinx::example_utils::print_verify_result(std::cout, result);
         }
 
         if (verified) {
@@ -270,7 +285,6 @@ int main(int argc, char *argv[])
 
 
         q.enqueueUnmapMemObject(c_buf, c);
-        free(d);
         q.finish();
 
 
@@ -31,6 +31,7 @@ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "event_timer.hpp"
 
 #include <chrono>
+#include <future>
 #include <iostream>
 #include <opencv2/imgproc/types_c.h>
 #include <opencv2/opencv.hpp>
@@ -64,6 +65,11 @@ int main(int argc, char *argv[])
     std::cout << "-- Example 7: OpenCV Image Resize --" << std::endl
               << std::endl;
 
+    // Program the card in the background while the image is decoded and the
+    // OpenCV reference is computed
+    xilinx::example_utils::XilinxOclHelper xocl;
+    std::shared_future<void> ocl_ready = xocl.initialize_async("alveo_examples.xclbin");
+
     cv::Mat image = cv::imread(argv[1], cv::IMREAD_COLOR);
 
     if (!image.data) {
@@ -119,9 +125,8 @@ int main(int argc, char *argv[])
 
     std::cout << "Matrix has " << image.channels() << " channels" << std::endl;
 
-    et.add("OpenCL initialization");
-    xilinx::example_utils::XilinxOclHelper xocl;
-    xocl.initialize("alveo_examples.xclbin");
+    et.add("Wait for OpenCL initialization");
+    ocl_ready.get();
 
     cl::CommandQueue q = xocl.get_command_queue();
     cl::Kernel krnl    = xocl.get_kernel("resize_accel_rgb");
@@ -0,0 +1,226 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "xilinx_ocl_helper.hpp"
+
+#define JOB_SIZE (1024 * 16)
+#define JOBS_PER_THREAD 500
+#define MAX_THREADS 32
+
+// Simple start gate so that all worker threads begin submitting at once
+class StartGate
+{
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    bool open = false;
+
+public:
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return open; });
+    }
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        open = true;
+        cv.notify_all();
+    }
+};
+
+void submit_worker(xilinx::example_utils::XilinxOclHelper &xocl,
+                   bool use_shared_queues,
+                   StartGate &gate,
+                   std::atomic<int> &failures)
+{
+    try {
+        // Kernel objects must not be shared between threads, so each worker
+        // gets its own handle to the wide_vadd compute unit
+        cl::Kernel krnl = xocl.get_kernel("wide_vadd");
+        cl::CommandQueue q;
+        if (use_shared_queues) {
+            q = xocl.get_shared_command_queue();
+        }
+        else {
+            q = xocl.get_thread_command_queue();
+        }
+
+        gate.wait();
+
+        for (int i = 0; i < JOBS_PER_THREAD; i++) {
+            cl::Buffer a = xocl.acquire_cached_buffer(JOB_SIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+            cl::Buffer b = xocl.acquire_cached_buffer(JOB_SIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+            cl::Buffer c = xocl.acquire_cached_buffer(JOB_SIZE * sizeof(uint32_t), CL_MEM_WRITE_ONLY);
+
+            krnl.setArg(0, a);
+            krnl.setArg(1, b);
+            krnl.setArg(2, c);
+            krnl.setArg(3, (uint64_t)JOB_SIZE);
+
+            // Shared queues are out of order, so chain the three commands
+            // explicitly. This is harmless on an in-order queue.
+            cl::Event m_event, k_event, r_event;
+            std::vector<cl::Event> deps;
+            q.enqueueMigrateMemObjects({a, b}, 0, NULL, &m_event);
+            deps.push_back(m_event);
+            q.enqueueTask(krnl, &deps, &k_event);
+            deps[0] = k_event;
+            q.enqueueMigrateMemObjects({c}, CL_MIGRATE_MEM_OBJECT_HOST, &deps, &r_event);
+            r_event.wait();
+
+            xocl.release_cached_buffer(a);
+            xocl.release_cached_buffer(b);
+            xocl.release_cached_buffer(c);
+        }
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        failures++;
+    }
+
+    // Failed workers must give back their queues and buffers too
+    xocl.release_thread_resources();
+}
+
+double run_submission_test(xilinx::example_utils::XilinxOclHelper &xocl,
+                           int num_threads,
+                           bool use_shared_queues,
+                           std::atomic<int> &failures)
+{
+    StartGate gate;
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < num_threads; i++) {
+        workers.emplace_back(submit_worker,
+                             std::ref(xocl),
+                             use_shared_queues,
+                             std::ref(gate),
+                             std::ref(failures));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    gate.release();
+    for (auto &t : workers) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::milli> duration = end - start;
+    return duration.count();
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    int max_threads = MAX_THREADS;
+    if (argc > 1) {
+        max_threads = atoi(argv[1]);
+        if (max_threads < 1) {
+            std::cout << "Usage: 09_multithread_submit [max threads]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "-- Example 9: Concurrent Submission from Many Host Threads --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+    et.finish();
+
+    std::cout << "Each thread submits " << JOBS_PER_THREAD << " wide_vadd jobs of "
+              << JOB_SIZE * sizeof(uint32_t) / 1024 << " KiB per vector" << std::endl
+              << std::endl;
+
+    std::atomic<int> failures(0);
+    std::ios_base::fmtflags flags(std::cout.flags());
+
+    for (int mode = 0; mode < 2; mode++) {
+        bool shared = (mode == 1);
+        std::cout << (shared ? "Sharded out-of-order queue pool" : "One in-order queue per thread")
+                  << std::endl;
+        std::cout << std::setw(8) << "Threads" << std::setw(12) << "Time (ms)"
+                  << std::setw(12) << "Jobs/s" << std::setw(10) << "Scaling" << std::endl;
+
+        double base_rate = 0;
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            double ms   = run_submission_test(xocl, threads, shared, failures);
+            double rate = (threads * JOBS_PER_THREAD) / (ms / 1000.0);
+            if (threads == 1) {
+                base_rate = rate;
+            }
+            std::cout << std::setw(8) << threads
+                      << std::setw(12) << std::fixed << std::setprecision(1) << ms
+                      << std::setw(12) << std::setprecision(0) << rate
+                      << std::setw(9) << std::setprecision(2) << rate / base_rate << "x"
+                      << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    std::cout.flags(flags);
+
+    if (failures != 0) {
+        std::cout << "Concurrent submission example complete! (with errors)" << std::endl
+                  << std::endl;
+    }
+    else {
+        std::cout << "Concurrent submission example complete!" << std::endl
+                  << std::endl;
+    }
+
+    std::cout << "--------------- Key execution times ---------------" << std::endl;
+    et.print();
+
+    return (failures != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
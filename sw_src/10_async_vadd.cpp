@@ -0,0 +1,244 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "async_runner.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define BUFSIZE (1024 * 1024 * 32)
+#define NUM_JOBS 512
+#define NUM_SUBMIT_THREADS 2
+
+int subdivide_buffer(std::vector<cl::Buffer> &divided,
+                     cl::Buffer buf_in,
+                     cl_mem_flags flags,
+                     int num_divisions)
+{
+    // Get the size of the buffer
+    size_t size;
+    size = buf_in.getInfo<CL_MEM_SIZE>();
+
+    if (size / num_divisions <= 4096) {
+        return -1;
+    }
+
+    cl_buffer_region region;
+
+    int err;
+    region.origin = 0;
+    region.size   = size / num_divisions;
+
+    // Sub-buffer origins must be 4k aligned, so round the region size down
+    // and let the last region take the remainder. wide_vadd reads and writes
+    // whole 64-byte words, so that remainder must be whole words too, which
+    // holds as long as the parent buffer is.
+    if (size % 64 != 0) {
+        return -1;
+    }
+    region.size -= region.size % 4096;
+
+    for (int i = 0; i < num_divisions; i++) {
+        if (i == num_divisions - 1) {
+            region.size = size - region.origin;
+        }
+        cl::Buffer buf = buf_in.createSubBuffer(flags,
+                                                CL_BUFFER_CREATE_TYPE_REGION,
+                                                &region,
+                                                &err);
+        if (err != CL_SUCCESS) {
+            return err;
+        }
+        divided.push_back(buf);
+        region.origin += region.size;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 10: Asynchronous Jobs with Completion Callbacks --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue();
+    et.finish();
+
+    std::cout << "Running " << NUM_JOBS << " wide_vadd jobs from " << NUM_SUBMIT_THREADS
+              << " submitting threads" << std::endl
+              << std::endl;
+
+    try {
+        et.add("Allocate contiguous OpenCL buffers");
+        cl::Buffer a_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+        cl::Buffer b_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+        cl::Buffer c_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_WRITE);
+        et.finish();
+
+        // Set the full buffers as arguments once so that XRT can resolve the
+        // memory bank in which they need to be allocated
+        cl::Kernel bank_krnl = xocl.get_kernel("wide_vadd");
+        bank_krnl.setArg(0, a_buf);
+        bank_krnl.setArg(1, b_buf);
+        bank_krnl.setArg(2, c_buf);
+
+        et.add("Map buffers to userspace pointers");
+        uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_buf,
+                                                     CL_TRUE,
+                                                     CL_MAP_WRITE,
+                                                     0,
+                                                     BUFSIZE * sizeof(uint32_t));
+        uint32_t *b = (uint32_t *)q.enqueueMapBuffer(b_buf,
+                                                     CL_TRUE,
+                                                     CL_MAP_WRITE,
+                                                     0,
+                                                     BUFSIZE * sizeof(uint32_t));
+        uint32_t *c = (uint32_t *)q.enqueueMapBuffer(c_buf,
+                                                     CL_TRUE,
+                                                     CL_MAP_READ,
+                                                     0,
+                                                     BUFSIZE * sizeof(uint32_t));
+        et.finish();
+
+        et.add("Populating buffer inputs");
+        for (int i = 0; i < BUFSIZE; i++) {
+            a[i] = i;
+            b[i] = 2 * i;
+        }
+        q.enqueueUnmapMemObject(a_buf, a);
+        q.enqueueUnmapMemObject(b_buf, b);
+        q.finish();
+        et.finish();
+
+        std::vector<cl::Buffer> a_bufs, b_bufs, c_bufs;
+        subdivide_buffer(a_bufs, a_buf, CL_MEM_READ_ONLY, NUM_JOBS);
+        subdivide_buffer(b_bufs, b_buf, CL_MEM_READ_ONLY, NUM_JOBS);
+        subdivide_buffer(c_bufs, c_buf, CL_MEM_WRITE_ONLY, NUM_JOBS);
+        size_t chunk_elems = a_bufs[0].getInfo<CL_MEM_SIZE>() / sizeof(uint32_t);
+
+        xilinx::example_utils::AsyncRunner runner(xocl, 2);
+        std::vector<xilinx::example_utils::AsyncJob> jobs(NUM_JOBS);
+        std::atomic<int> in_flight(0), max_in_flight(0), mismatches(0);
+
+        et.add("Submit jobs and verify on completion");
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < NUM_SUBMIT_THREADS; t++) {
+            submitters.emplace_back([&, t]() {
+                cl::Kernel krnl = xocl.get_kernel("wide_vadd");
+                for (int i = t; i < NUM_JOBS; i += NUM_SUBMIT_THREADS) {
+                    size_t elems = c_bufs[i].getInfo<CL_MEM_SIZE>() / sizeof(uint32_t);
+                    size_t first = i * chunk_elems;
+
+                    int now  = ++in_flight;
+                    int prev = max_in_flight.load();
+                    while (now > prev && !max_in_flight.compare_exchange_weak(prev, now)) {
+                    }
+
+                    // Check the results for this chunk as soon as its D2H
+                    // migration lands, while later chunks are still running
+                    jobs[i] = runner.run_async(krnl, a_bufs[i], b_bufs[i], c_bufs[i], (uint64_t)elems)
+                                  .then([&, first, elems]() {
+                                      for (size_t j = first; j < first + elems; j++) {
+                                          if (c[j] != (uint32_t)(3 * j)) {
+                                              mismatches++;
+                                          }
+                                      }
+                                      in_flight--;
+                                  });
+                }
+            });
+        }
+        for (auto &t : submitters) {
+            t.join();
+        }
+
+        et.add("Wait for jobs to complete");
+        for (auto &job : jobs) {
+            job.get();
+        }
+        et.finish();
+
+        std::cout << "Maximum jobs in flight: " << max_in_flight << std::endl;
+
+        if (mismatches == 0) {
+            std::cout
+                << std::endl
+                << "Asynchronous job example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "ERROR: " << mismatches << " values did not match the software result"
+                << std::endl
+                << "Asynchronous job example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+
+        q.enqueueUnmapMemObject(c_buf, c);
+        q.finish();
+
+        et.print();
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,258 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "ocl_coroutine.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define BUFSIZE (1024 * 1024 * 32)
+#define NUM_BUFS 64
+
+using xilinx::example_utils::CoroutineScheduler;
+using xilinx::example_utils::OffloadFlow;
+
+void vadd_sw(uint32_t *a, uint32_t *b, uint32_t *c, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        c[i] = a[i] + b[i];
+    }
+}
+
+int subdivide_buffer(std::vector<cl::Buffer> &divided,
+                     cl::Buffer buf_in,
+                     cl_mem_flags flags,
+                     int num_divisions)
+{
+    // Get the size of the buffer
+    size_t size;
+    size = buf_in.getInfo<CL_MEM_SIZE>();
+
+    if (size / num_divisions <= 4096) {
+        return -1;
+    }
+
+    cl_buffer_region region;
+
+    int err;
+    region.origin = 0;
+    region.size   = size / num_divisions;
+
+    // Sub-buffer origins must be 4k aligned, so round the region size down
+    // and let the last region take the remainder. wide_vadd reads and writes
+    // whole 64-byte words, so that remainder must be whole words too, which
+    // holds as long as the parent buffer is.
+    if (size % 64 != 0) {
+        return -1;
+    }
+    region.size -= region.size % 4096;
+
+    for (int i = 0; i < num_divisions; i++) {
+        if (i == num_divisions - 1) {
+            region.size = size - region.origin;
+        }
+        cl::Buffer buf = buf_in.createSubBuffer(flags,
+                                                CL_BUFFER_CREATE_TYPE_REGION,
+                                                &region,
+                                                &err);
+        if (err != CL_SUCCESS) {
+            return err;
+        }
+        divided.push_back(buf);
+        region.origin += region.size;
+    }
+
+    return 0;
+}
+
+// One offload flow per chunk. Compare with enqueue_subbuf_vadd() in example 5:
+// the migrate -> task -> migrate ordering is expressed by the code itself
+// rather than by hand-maintained event vectors.
+OffloadFlow vadd_flow(CoroutineScheduler &sched,
+                      cl::CommandQueue &q,
+                      cl::Kernel &krnl,
+                      cl::Buffer a,
+                      cl::Buffer b,
+                      cl::Buffer c)
+{
+    size_t size = a.getInfo<CL_MEM_SIZE>();
+    std::vector<cl::Memory> in_vec, out_vec;
+    in_vec.push_back(a);
+    in_vec.push_back(b);
+    out_vec.push_back(c);
+
+    co_await sched.migrate(q, in_vec, 0);
+
+    // All flows run on the scheduler thread, so the shared kernel object
+    // cannot be modified by another flow between setArg() and the enqueue
+    krnl.setArg(0, a);
+    krnl.setArg(1, b);
+    krnl.setArg(2, c);
+    krnl.setArg(3, (uint64_t)(size / sizeof(uint32_t)));
+    co_await sched.task(q, krnl);
+
+    co_await sched.migrate(q, out_vec, CL_MIGRATE_MEM_OBJECT_HOST);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 11: Coroutine Offload Flows --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue();
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    std::cout << " -- Running " << NUM_BUFS << " wide VADD flows on one scheduler thread" << std::endl;
+
+    try {
+        et.add("Allocate contiguous OpenCL buffers");
+        cl::Buffer a_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+        cl::Buffer b_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+        cl::Buffer c_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_WRITE);
+        uint32_t *d      = new uint32_t[BUFSIZE];
+        et.finish();
+
+        // Set the buffers as kernel arguments prior to mapping so that XRT
+        // can resolve the physical memory in which they need to be allocated
+        krnl.setArg(0, a_buf);
+        krnl.setArg(1, b_buf);
+        krnl.setArg(2, c_buf);
+
+        et.add("Map buffers to userspace pointers");
+        uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_buf,
+                                                     CL_TRUE,
+                                                     CL_MAP_WRITE,
+                                                     0,
+                                                     BUFSIZE * sizeof(uint32_t));
+        uint32_t *b = (uint32_t *)q.enqueueMapBuffer(b_buf,
+                                                     CL_TRUE,
+                                                     CL_MAP_WRITE,
+                                                     0,
+                                                     BUFSIZE * sizeof(uint32_t));
+        uint32_t *c = (uint32_t *)q.enqueueMapBuffer(c_buf,
+                                                     CL_TRUE,
+                                                     CL_MAP_READ,
+                                                     0,
+                                                     BUFSIZE * sizeof(uint32_t));
+        et.finish();
+
+        et.add("Populating buffer inputs");
+        for (int i = 0; i < BUFSIZE; i++) {
+            a[i] = i;
+            b[i] = 2 * i;
+        }
+        et.finish();
+
+        // For comparison, let's have the CPU calculate the result
+        et.add("Software VADD run");
+        vadd_sw(a, b, d, BUFSIZE);
+        et.finish();
+
+        et.add("Spawn offload flows");
+        q.enqueueUnmapMemObject(a_buf, a);
+        q.enqueueUnmapMemObject(b_buf, b);
+
+        std::vector<cl::Buffer> a_bufs, b_bufs, c_bufs;
+        subdivide_buffer(a_bufs, a_buf, CL_MEM_READ_ONLY, NUM_BUFS);
+        subdivide_buffer(b_bufs, b_buf, CL_MEM_READ_ONLY, NUM_BUFS);
+        subdivide_buffer(c_bufs, c_buf, CL_MEM_WRITE_ONLY, NUM_BUFS);
+
+        CoroutineScheduler sched;
+        for (int i = 0; i < NUM_BUFS; i++) {
+            sched.spawn(vadd_flow(sched, q, krnl, a_bufs[i], b_bufs[i], c_bufs[i]));
+        }
+
+        et.add("Wait for flows to complete");
+        sched.wait_all();
+        et.finish();
+
+        // Verify the results
+        bool verified = true;
+        for (int i = 0; i < BUFSIZE; i++) {
+            if (c[i] != d[i]) {
+                verified = false;
+                std::cout << "ERROR: software and hardware vadd do not match: "
+                          << c[i] << "!=" << d[i] << " at position " << i << std::endl;
+                break;
+            }
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Coroutine offload flow example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Coroutine offload flow example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+
+        q.enqueueUnmapMemObject(c_buf, c);
+        delete[] d;
+        q.finish();
+
+        et.print();
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
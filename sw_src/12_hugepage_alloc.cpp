@@ -0,0 +1,192 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "host_memory.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+using xilinx::example_utils::HostAllocPolicy;
+using xilinx::example_utils::HostBacking;
+using xilinx::example_utils::HostPageSize;
+
+#define DEFAULT_BUFSIZE_MB 1024
+
+struct PolicyCase
+{
+    const char *name;
+    HostAllocPolicy policy;
+};
+
+static PolicyCase make_case(const char *name, HostPageSize page_size, bool prefault, bool lock)
+{
+    PolicyCase pc;
+    pc.name             = name;
+    pc.policy.page_size = page_size;
+    pc.policy.prefault  = prefault;
+    pc.policy.lock      = lock;
+    return pc;
+}
+
+static double ms_since(std::chrono::high_resolution_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> d = std::chrono::high_resolution_clock::now() - start;
+    return d.count();
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    size_t size_mb = DEFAULT_BUFSIZE_MB;
+    if (argc > 1) {
+        size_mb = strtoul(argv[1], NULL, 0);
+        if (size_mb == 0) {
+            std::cout << "Usage: 12_hugepage_alloc [buffer size in MiB]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    size_t size  = size_mb * 1024 * 1024;
+    size_t count = size / sizeof(uint32_t);
+
+    std::cout << "-- Example 12: Host Allocation Policies for DMA Buffers --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    std::vector<PolicyCase> cases;
+    cases.push_back(make_case("4K", HostPageSize::Normal, false, false));
+    cases.push_back(make_case("4K prefault", HostPageSize::Normal, true, false));
+    cases.push_back(make_case("4K prefault+mlock", HostPageSize::Normal, true, true));
+    cases.push_back(make_case("2M", HostPageSize::Huge2M, false, false));
+    cases.push_back(make_case("2M prefault", HostPageSize::Huge2M, true, false));
+    cases.push_back(make_case("2M prefault+mlock", HostPageSize::Huge2M, true, true));
+    cases.push_back(make_case("1G prefault+mlock", HostPageSize::Huge1G, true, true));
+
+    std::cout << "Buffer size: " << size_mb << " MiB, all times in ms" << std::endl
+              << std::endl;
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(20) << "Policy" << std::setw(11) << "Backing"
+              << std::right << std::setw(10) << "Alloc" << std::setw(10) << "Populate"
+              << std::setw(10) << "Map" << std::setw(10) << "H2D" << std::setw(10) << "D2H"
+              << std::setw(10) << "GB/s" << std::endl;
+
+    bool errors = false;
+    for (auto &pc : cases) {
+        try {
+            HostBacking backing;
+            auto start  = std::chrono::high_resolution_clock::now();
+            uint32_t *a = reinterpret_cast<uint32_t *>(
+                xilinx::example_utils::host_alloc(size, pc.policy, &backing));
+            double t_alloc = ms_since(start);
+
+            // This is the "Populating buffer inputs" phase of the other
+            // examples; without prefaulting it absorbs the page faults
+            start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < count; i++) {
+                a[i] = i;
+            }
+            double t_populate = ms_since(start);
+
+            // Wrapping the memory pins it for DMA
+            start = std::chrono::high_resolution_clock::now();
+            cl::Buffer a_buf = xocl.create_buffer_from_host_ptr(a, size, CL_MEM_READ_WRITE);
+            krnl.setArg(0, a_buf);
+            q.enqueueMigrateMemObjects({a_buf}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED);
+            q.finish();
+            double t_map = ms_since(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            q.enqueueMigrateMemObjects({a_buf}, 0);
+            q.finish();
+            double t_h2d = ms_since(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            q.enqueueMigrateMemObjects({a_buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+            q.finish();
+            double t_d2h = ms_since(start);
+
+            std::cout << std::left << std::setw(20) << pc.name
+                      << std::setw(11) << xilinx::example_utils::host_backing_name(backing)
+                      << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << t_alloc << std::setw(10) << t_populate
+                      << std::setw(10) << t_map << std::setw(10) << t_h2d
+                      << std::setw(10) << t_d2h
+                      << std::setw(10) << (size / 1.0e6) / t_h2d << std::endl;
+
+            a_buf = cl::Buffer();
+            xilinx::example_utils::host_free(a, size, pc.policy);
+        }
+        catch (std::exception &e) {
+            std::cout << std::left << std::setw(20) << pc.name << "skipped: " << e.what() << std::endl;
+            errors = true;
+        }
+    }
+    std::cout.flags(flags);
+
+    if (!errors) {
+        std::cout
+            << std::endl
+            << "Host allocation policy example complete!"
+            << std::endl
+            << std::endl;
+    }
+    else {
+        std::cout
+            << std::endl
+            << "Host allocation policy example complete! (some policies unavailable)"
+            << std::endl
+            << std::endl;
+    }
+
+    std::cout << "--------------- Key execution times ---------------" << std::endl;
+    et.print();
+}
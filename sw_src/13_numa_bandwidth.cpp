@@ -0,0 +1,169 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Xilinx OpenCL and XRT includes
+#include "host_memory.hpp"
+#include "numa_utils.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define DEFAULT_BUFSIZE_MB 512
+#define NUM_ITERATIONS 5
+
+static double ms_since(std::chrono::high_resolution_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> d = std::chrono::high_resolution_clock::now() - start;
+    return d.count();
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    size_t size_mb = DEFAULT_BUFSIZE_MB;
+    if (argc > 1) {
+        size_mb = strtoul(argv[1], NULL, 0);
+        if (size_mb == 0) {
+            std::cout << "Usage: 13_numa_bandwidth [buffer size in MiB]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    size_t size = size_mb * 1024 * 1024;
+
+    std::cout << "-- Example 13: NUMA Placement of Host Buffers --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    int device_node = xocl.get_numa_node();
+    int num_nodes   = xilinx::example_utils::get_numa_node_count();
+    std::string bdf = xocl.get_device_bdf();
+
+    std::cout << "Device " << (bdf.empty() ? "(unknown BDF)" : bdf) << " is on NUMA node "
+              << device_node << ", system has " << num_nodes << " node(s)" << std::endl;
+    if (device_node < 0) {
+        std::cout << "WARNING: device NUMA node unknown, local/remote labels are unavailable" << std::endl;
+    }
+    std::cout << "Buffer size: " << size_mb << " MiB, best of " << NUM_ITERATIONS
+              << " migrations" << std::endl
+              << std::endl;
+
+    // Populate from the card's node in every case so only buffer placement
+    // differs between the rows
+    xilinx::example_utils::pin_thread_to_numa_node(device_node);
+
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::setw(6) << "Node" << std::setw(9) << "Place"
+              << std::setw(14) << "Touch (ms)" << std::setw(12) << "H2D GB/s"
+              << std::setw(12) << "D2H GB/s" << std::endl;
+
+    bool errors = false;
+    for (int node = 0; node < num_nodes; node++) {
+        try {
+            xilinx::example_utils::HostAllocPolicy policy;
+            policy.numa_node = node;
+
+            void *ptr  = xilinx::example_utils::host_alloc(size, policy);
+            auto start = std::chrono::high_resolution_clock::now();
+            xilinx::example_utils::parallel_first_touch(ptr, size, node);
+            double t_touch = ms_since(start);
+
+            cl::Buffer buf = xocl.create_buffer_from_host_ptr(ptr, size, CL_MEM_READ_WRITE);
+            krnl.setArg(0, buf);
+
+            double best_h2d = 1e30, best_d2h = 1e30;
+            for (int i = 0; i < NUM_ITERATIONS; i++) {
+                start = std::chrono::high_resolution_clock::now();
+                q.enqueueMigrateMemObjects({buf}, 0);
+                q.finish();
+                best_h2d = std::min(best_h2d, ms_since(start));
+
+                start = std::chrono::high_resolution_clock::now();
+                q.enqueueMigrateMemObjects({buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+                q.finish();
+                best_d2h = std::min(best_d2h, ms_since(start));
+            }
+
+            const char *place = (device_node < 0) ? "?" : (node == device_node ? "local" : "remote");
+            std::cout << std::setw(6) << node << std::setw(9) << place
+                      << std::fixed << std::setprecision(2)
+                      << std::setw(14) << t_touch
+                      << std::setw(12) << (size / 1.0e6) / best_h2d
+                      << std::setw(12) << (size / 1.0e6) / best_d2h << std::endl;
+
+            buf = cl::Buffer();
+            xilinx::example_utils::host_free(ptr, size, policy);
+        }
+        catch (std::exception &e) {
+            std::cout << std::setw(6) << node << "  skipped: " << e.what() << std::endl;
+            errors = true;
+        }
+    }
+    std::cout.flags(flags);
+
+    if (!errors) {
+        std::cout
+            << std::endl
+            << "NUMA bandwidth example complete!"
+            << std::endl
+            << std::endl;
+    }
+    else {
+        std::cout
+            << std::endl
+            << "NUMA bandwidth example complete! (with errors)"
+            << std::endl
+            << std::endl;
+    }
+
+    std::cout << "--------------- Key execution times ---------------" << std::endl;
+    et.print();
+}
@@ -0,0 +1,206 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "device_arena.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define ARENA_SIZE (1024 * 1024 * 256)
+#define NUM_REQUESTS 2000
+#define MAX_LIVE_REQUESTS 32
+#define MIN_REQUEST_BYTES (4 * 1024)
+#define MAX_REQUEST_BYTES (8 * 1024 * 1024)
+
+struct Request
+{
+    cl::Buffer a, b, c;
+};
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 14: Device Memory Arenas --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    try {
+        // One arena per wide_vadd port, so each lands in the bank that port
+        // is connected to on this platform
+        et.add("Reserve device arenas");
+        xilinx::example_utils::DeviceArena a_arena(xocl, q, krnl, 0, ARENA_SIZE, CL_MEM_READ_ONLY);
+        xilinx::example_utils::DeviceArena b_arena(xocl, q, krnl, 1, ARENA_SIZE, CL_MEM_READ_ONLY);
+        xilinx::example_utils::DeviceArena c_arena(xocl, q, krnl, 2, ARENA_SIZE, CL_MEM_READ_WRITE);
+        et.finish();
+
+        std::cout << "Running " << NUM_REQUESTS << " requests of "
+                  << MIN_REQUEST_BYTES / 1024 << " KiB to " << MAX_REQUEST_BYTES / (1024 * 1024)
+                  << " MiB with up to " << MAX_LIVE_REQUESTS << " live at once" << std::endl
+                  << std::endl;
+
+        std::ios_base::fmtflags flags(std::cout.flags());
+        bool verified = true;
+
+        for (int mode = 0; mode < 2; mode++) {
+            bool use_arena = (mode == 1);
+            std::mt19937 rng(42);
+            std::uniform_int_distribution<size_t> size_dist(MIN_REQUEST_BYTES / 64, MAX_REQUEST_BYTES / 64);
+            std::vector<Request> live;
+            double alloc_ms = 0, total_ms = 0;
+
+            for (int r = 0; r < NUM_REQUESTS; r++) {
+                // Keep a bounded but changing set of requests alive so the
+                // arena sees realistic churn
+                if (live.size() == MAX_LIVE_REQUESTS) {
+                    size_t victim = rng() % live.size();
+                    if (use_arena) {
+                        a_arena.release(live[victim].a);
+                        b_arena.release(live[victim].b);
+                        c_arena.release(live[victim].c);
+                    }
+                    live.erase(live.begin() + victim);
+                }
+
+                size_t bytes = size_dist(rng) * 64;
+                auto start   = std::chrono::high_resolution_clock::now();
+
+                Request req;
+                if (use_arena) {
+                    req.a = a_arena.allocate(bytes, CL_MEM_READ_ONLY);
+                    req.b = b_arena.allocate(bytes, CL_MEM_READ_ONLY);
+                    req.c = c_arena.allocate(bytes, CL_MEM_WRITE_ONLY);
+                }
+                else {
+                    req.a = xocl.create_buffer(bytes, CL_MEM_READ_ONLY);
+                    req.b = xocl.create_buffer(bytes, CL_MEM_READ_ONLY);
+                    req.c = xocl.create_buffer(bytes, CL_MEM_WRITE_ONLY);
+                }
+                auto allocated = std::chrono::high_resolution_clock::now();
+
+                krnl.setArg(0, req.a);
+                krnl.setArg(1, req.b);
+                krnl.setArg(2, req.c);
+                krnl.setArg(3, (uint64_t)(bytes / sizeof(uint32_t)));
+
+                uint32_t *a = (uint32_t *)q.enqueueMapBuffer(req.a, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, bytes);
+                uint32_t *b = (uint32_t *)q.enqueueMapBuffer(req.b, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, bytes);
+                for (size_t i = 0; i < bytes / sizeof(uint32_t); i++) {
+                    a[i] = i;
+                    b[i] = r;
+                }
+                q.enqueueUnmapMemObject(req.a, a);
+                q.enqueueUnmapMemObject(req.b, b);
+
+                q.enqueueMigrateMemObjects({req.a, req.b}, 0);
+                q.enqueueTask(krnl);
+                q.enqueueMigrateMemObjects({req.c}, CL_MIGRATE_MEM_OBJECT_HOST);
+                uint32_t *c = (uint32_t *)q.enqueueMapBuffer(req.c, CL_TRUE, CL_MAP_READ, 0, bytes);
+                if (c[0] != (uint32_t)r || c[bytes / sizeof(uint32_t) - 1] != (uint32_t)(bytes / sizeof(uint32_t) - 1 + r)) {
+                    verified = false;
+                }
+                q.enqueueUnmapMemObject(req.c, c);
+                q.finish();
+
+                auto end = std::chrono::high_resolution_clock::now();
+                alloc_ms += std::chrono::duration<double, std::milli>(allocated - start).count();
+                total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+                live.push_back(req);
+            }
+
+            std::cout << (use_arena ? "Arena sub-allocation" : "clCreateBuffer per request") << std::endl
+                      << std::fixed << std::setprecision(3)
+                      << "  Mean allocation latency: " << alloc_ms / NUM_REQUESTS << " ms" << std::endl
+                      << "  Mean request latency   : " << total_ms / NUM_REQUESTS << " ms" << std::endl;
+
+            if (use_arena) {
+                std::cout << "Output arena after churn:" << std::endl;
+                c_arena.print_stats();
+                for (auto &req : live) {
+                    a_arena.release(req.a);
+                    b_arena.release(req.b);
+                    c_arena.release(req.c);
+                }
+            }
+            std::cout << std::endl;
+        }
+        std::cout.flags(flags);
+
+        if (verified) {
+            std::cout
+                << "Device arena example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << "ERROR: hardware vadd results did not match"
+                << std::endl
+                << "Device arena example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,171 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Xilinx OpenCL and XRT includes
+#include "chunked_stager.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define BUFSIZE (1024 * 1024 * 32)
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 15: Pipelined Staging of Unaligned User Memory --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    xilinx::example_utils::XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    try {
+        // As in example 1, the caller's buffers come from plain new[] and are
+        // not page aligned
+        et.add("Allocating and populating user memory");
+        uint32_t *a = new uint32_t[BUFSIZE];
+        uint32_t *b = new uint32_t[BUFSIZE];
+        uint32_t *c = new uint32_t[BUFSIZE];
+        for (int i = 0; i < BUFSIZE; i++) {
+            a[i] = i;
+            b[i] = 2 * i;
+        }
+        et.finish();
+
+        // Baseline: USE_HOST_PTR on the unaligned memory. XRT must copy the
+        // whole buffer into its own pinned memory before the DMA can start.
+        et.add("Baseline: USE_HOST_PTR buffer creation + migration");
+        {
+            cl::Buffer a_host(xocl.get_context(),
+                              static_cast<cl_mem_flags>(CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR),
+                              BUFSIZE * sizeof(uint32_t),
+                              a,
+                              NULL);
+            cl::Buffer b_host(xocl.get_context(),
+                              static_cast<cl_mem_flags>(CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR),
+                              BUFSIZE * sizeof(uint32_t),
+                              b,
+                              NULL);
+            krnl.setArg(0, a_host);
+            krnl.setArg(1, b_host);
+            q.enqueueMigrateMemObjects({a_host, b_host}, 0);
+            q.finish();
+        }
+        et.finish();
+
+        et.add("Allocate device buffers");
+        cl::Buffer a_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+        cl::Buffer b_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_ONLY);
+        cl::Buffer c_buf = xocl.create_buffer(BUFSIZE * sizeof(uint32_t), CL_MEM_READ_WRITE);
+
+        // Set the buffers as kernel arguments before use so that XRT can
+        // resolve the memory banks they need to be allocated in
+        krnl.setArg(0, a_buf);
+        krnl.setArg(1, b_buf);
+        krnl.setArg(2, c_buf);
+        krnl.setArg(3, (uint64_t)BUFSIZE);
+        et.finish();
+
+        xilinx::example_utils::ChunkedStager stager(xocl);
+
+        et.add("Staged upload (copy overlapped with DMA)");
+        cl::Event a_done = stager.upload(a_buf, a, BUFSIZE * sizeof(uint32_t));
+        cl::Event b_done = stager.upload(b_buf, b, BUFSIZE * sizeof(uint32_t));
+        a_done.wait();
+        b_done.wait();
+
+        et.add("Run wide_vadd");
+        q.enqueueTask(krnl);
+        q.finish();
+
+        et.add("Staged download (DMA overlapped with copy)");
+        stager.download(c, c_buf, BUFSIZE * sizeof(uint32_t));
+        et.finish();
+
+        // Verify the results
+        bool verified = true;
+        for (int i = 0; i < BUFSIZE; i++) {
+            if (c[i] != a[i] + b[i]) {
+                verified = false;
+                std::cout << "ERROR: software and hardware vadd do not match: "
+                          << c[i] << "!=" << a[i] + b[i] << " at position " << i << std::endl;
+                break;
+            }
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Chunked staging example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Chunked staging example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+
+        delete[] a;
+        delete[] b;
+        delete[] c;
+
+        et.print();
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
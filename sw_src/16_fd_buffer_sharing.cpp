@@ -0,0 +1,387 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "fd_channel.hpp"
+#include "verify.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+using namespace xilinx::example_utils;
+
+#define SLOT_ELEMS (1024 * 1024 * 4)
+#define SLOT_BYTES (SLOT_ELEMS * sizeof(uint32_t))
+#define NUM_SLOTS 4
+#define NUM_JOBS 64
+
+// Fill pattern shared by both processes so the consumer can verify results
+static void fill_inputs(uint32_t *a, uint32_t *b, uint64_t tag)
+{
+    for (uint32_t i = 0; i < SLOT_ELEMS; i++) {
+        a[i] = i;
+        b[i] = (uint32_t)tag;
+    }
+}
+
+static bool check_result(const uint32_t *c, uint64_t tag)
+{
+    VerifyResult v = verify_buffer(c, SLOT_ELEMS, [tag](size_t first, size_t count, uint32_t *out) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = (uint32_t)(first + i + tag);
+        }
+    });
+    if (!v.ok()) {
+        std::cout << "Job " << tag << ": ";
+        print_verify_result(std::cout, v);
+    }
+    return v.ok();
+}
+
+//
+// Zero-copy mode: the producer owns the device buffers and shares them by fd
+//
+static double produce_shared(int sock)
+{
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+
+    std::vector<cl::Buffer> a_bufs, b_bufs;
+    std::vector<uint32_t *> a_ptrs, b_ptrs;
+    std::vector<int> exported;
+
+    for (uint32_t slot = 0; slot < NUM_SLOTS; slot++) {
+        cl::Buffer a = xocl.create_buffer(SLOT_BYTES, CL_MEM_READ_ONLY);
+        cl::Buffer b = xocl.create_buffer(SLOT_BYTES, CL_MEM_READ_ONLY);
+
+        // Resolve the banks wide_vadd reads from and allocate the buffers
+        // there, since the consumer will pass them straight to the kernel
+        krnl.setArg(0, a);
+        krnl.setArg(1, b);
+        q.enqueueMigrateMemObjects({a, b}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED);
+        q.finish();
+
+        std::vector<int> fds;
+        fds.push_back(xocl.get_fd_for_buffer(a));
+        fds.push_back(xocl.get_fd_for_buffer(b));
+        BufferMessage msg = {BUFFER_ANNOUNCE, slot, SLOT_BYTES, 0};
+        send_buffer_message(sock, msg, fds);
+        exported.insert(exported.end(), fds.begin(), fds.end());
+
+        a_bufs.push_back(a);
+        b_bufs.push_back(b);
+    }
+
+    std::deque<uint32_t> free_slots;
+    for (uint32_t slot = 0; slot < NUM_SLOTS; slot++) {
+        free_slots.push_back(slot);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    BufferMessage msg;
+    for (uint64_t job = 0; job < NUM_JOBS; job++) {
+        while (free_slots.empty()) {
+            if (!recv_buffer_message(sock, msg)) {
+                throw_lineexception("Consumer closed the connection");
+            }
+            if (msg.type == BUFFER_RELEASED) {
+                free_slots.push_back(msg.slot);
+            }
+        }
+        uint32_t slot = free_slots.front();
+        free_slots.pop_front();
+
+        uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_bufs[slot], CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, SLOT_BYTES);
+        uint32_t *b = (uint32_t *)q.enqueueMapBuffer(b_bufs[slot], CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, SLOT_BYTES);
+        fill_inputs(a, b, job);
+        q.enqueueUnmapMemObject(a_bufs[slot], a);
+        q.enqueueUnmapMemObject(b_bufs[slot], b);
+        q.enqueueMigrateMemObjects({a_bufs[slot], b_bufs[slot]}, 0);
+        q.finish();
+
+        // Hand the slot over; the data is already on the card
+        BufferMessage filled = {BUFFER_FILLED, slot, SLOT_BYTES, job};
+        send_buffer_message(sock, filled);
+    }
+
+    BufferMessage end = {STREAM_END, 0, 0, 0};
+    send_buffer_message(sock, end);
+    while (free_slots.size() < NUM_SLOTS && recv_buffer_message(sock, msg)) {
+        if (msg.type == BUFFER_RELEASED) {
+            free_slots.push_back(msg.slot);
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    for (int fd : exported) {
+        close(fd);
+    }
+    return elapsed.count();
+}
+
+static int consume_shared(int sock)
+{
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+
+    cl::Buffer c_buf = xocl.create_buffer(SLOT_BYTES, CL_MEM_WRITE_ONLY);
+    krnl.setArg(2, c_buf);
+
+    std::vector<cl::Buffer> a_bufs(NUM_SLOTS), b_bufs(NUM_SLOTS);
+    std::vector<int> imported;
+    int errors = 0;
+
+    BufferMessage msg;
+    size_t num_fds = 0;
+    while (recv_buffer_message(sock, msg, &imported)) {
+        // Received descriptors are kept in 'imported' so they are closed at
+        // the end whatever the message turns out to be
+        size_t new_fds = imported.size() - num_fds;
+        num_fds        = imported.size();
+        if ((msg.type == BUFFER_ANNOUNCE || msg.type == BUFFER_FILLED) && msg.slot >= NUM_SLOTS) {
+            throw_lineexception("Producer sent an invalid slot number");
+        }
+
+        if (msg.type == BUFFER_ANNOUNCE) {
+            if (new_fds != 2) {
+                throw_lineexception("Buffer announcement did not carry two descriptors");
+            }
+            a_bufs[msg.slot] = xocl.get_buffer_from_fd(imported[num_fds - 2]);
+            b_bufs[msg.slot] = xocl.get_buffer_from_fd(imported[num_fds - 1]);
+        }
+        else if (msg.type == BUFFER_FILLED) {
+            if (a_bufs[msg.slot]() == NULL) {
+                throw_lineexception("Producer filled a slot it never announced");
+            }
+            krnl.setArg(0, a_bufs[msg.slot]);
+            krnl.setArg(1, b_bufs[msg.slot]);
+            krnl.setArg(3, (uint64_t)(msg.size / sizeof(uint32_t)));
+            q.enqueueTask(krnl);
+            q.enqueueMigrateMemObjects({c_buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+            uint32_t *c = (uint32_t *)q.enqueueMapBuffer(c_buf, CL_TRUE, CL_MAP_READ, 0, SLOT_BYTES);
+            if (!check_result(c, msg.tag)) {
+                errors++;
+            }
+            q.enqueueUnmapMemObject(c_buf, c);
+            q.finish();
+
+            BufferMessage released = {BUFFER_RELEASED, msg.slot, 0, msg.tag};
+            send_buffer_message(sock, released);
+        }
+        else if (msg.type == STREAM_END) {
+            break;
+        }
+    }
+
+    for (int fd : imported) {
+        close(fd);
+    }
+    return errors;
+}
+
+//
+// Baseline: payload bytes are pushed through the socket and copied into the
+// consumer's own buffers
+//
+static double produce_copy(int sock)
+{
+    std::vector<uint32_t> a(SLOT_ELEMS), b(SLOT_ELEMS);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    BufferMessage msg;
+    for (uint64_t job = 0; job < NUM_JOBS; job++) {
+        // Allow NUM_SLOTS messages in flight, matching the zero-copy mode
+        if (job >= NUM_SLOTS) {
+            if (!recv_all(sock, &msg, sizeof(msg))) {
+                throw_lineexception("Consumer closed the connection");
+            }
+        }
+        fill_inputs(a.data(), b.data(), job);
+        BufferMessage filled = {BUFFER_FILLED, 0, SLOT_BYTES, job};
+        send_all(sock, &filled, sizeof(filled));
+        send_all(sock, a.data(), SLOT_BYTES);
+        send_all(sock, b.data(), SLOT_BYTES);
+    }
+    BufferMessage end = {STREAM_END, 0, 0, 0};
+    send_all(sock, &end, sizeof(end));
+    for (int i = 0; i < NUM_SLOTS && recv_all(sock, &msg, sizeof(msg)); i++) {
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+static int consume_copy(int sock)
+{
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+
+    cl::Buffer a_buf = xocl.create_buffer(SLOT_BYTES, CL_MEM_READ_ONLY);
+    cl::Buffer b_buf = xocl.create_buffer(SLOT_BYTES, CL_MEM_READ_ONLY);
+    cl::Buffer c_buf = xocl.create_buffer(SLOT_BYTES, CL_MEM_WRITE_ONLY);
+    krnl.setArg(0, a_buf);
+    krnl.setArg(1, b_buf);
+    krnl.setArg(2, c_buf);
+    krnl.setArg(3, (uint64_t)SLOT_ELEMS);
+    int errors = 0;
+
+    BufferMessage msg;
+    while (recv_all(sock, &msg, sizeof(msg)) && msg.type == BUFFER_FILLED) {
+        uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_buf, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, SLOT_BYTES);
+        uint32_t *b = (uint32_t *)q.enqueueMapBuffer(b_buf, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, SLOT_BYTES);
+        recv_all(sock, a, SLOT_BYTES);
+        recv_all(sock, b, SLOT_BYTES);
+        q.enqueueUnmapMemObject(a_buf, a);
+        q.enqueueUnmapMemObject(b_buf, b);
+
+        q.enqueueMigrateMemObjects({a_buf, b_buf}, 0);
+        q.enqueueTask(krnl);
+        q.enqueueMigrateMemObjects({c_buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+        uint32_t *c = (uint32_t *)q.enqueueMapBuffer(c_buf, CL_TRUE, CL_MAP_READ, 0, SLOT_BYTES);
+        if (!check_result(c, msg.tag)) {
+            errors++;
+        }
+        q.enqueueUnmapMemObject(c_buf, c);
+        q.finish();
+
+        BufferMessage released = {BUFFER_RELEASED, 0, 0, msg.tag};
+        send_all(sock, &released, sizeof(released));
+    }
+    return errors;
+}
+
+// Runs one producer/consumer pair. The processes are forked before either
+// touches OpenCL, because an initialized OpenCL runtime must not be forked.
+static bool run_pair(bool zero_copy, double &elapsed_ms)
+{
+    int sv[2];
+    int type = zero_copy ? SOCK_SEQPACKET : SOCK_STREAM;
+    if (socketpair(AF_UNIX, type, 0, sv) != 0) {
+        throw_lineexception_errno("Unable to create socket pair", errno);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw_lineexception_errno("Unable to fork consumer process", errno);
+    }
+    if (pid == 0) {
+        close(sv[0]);
+        int errors = 0;
+        try {
+            errors = zero_copy ? consume_shared(sv[1]) : consume_copy(sv[1]);
+        }
+        catch (std::exception &e) {
+            std::cout << "ERROR (consumer): " << e.what() << std::endl;
+            errors = 1;
+        }
+        close(sv[1]);
+        _exit(errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(sv[1]);
+    bool ok = true;
+    try {
+        elapsed_ms = zero_copy ? produce_shared(sv[0]) : produce_copy(sv[0]);
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR (producer): " << e.what() << std::endl;
+        ok = false;
+    }
+    close(sv[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 16: Sharing Device Buffers Between Processes --" << std::endl
+              << std::endl;
+
+    std::cout << "Streaming " << NUM_JOBS << " jobs of 2 x " << SLOT_BYTES / (1024 * 1024)
+              << " MiB from a producer process to a wide_vadd consumer process" << std::endl
+              << std::endl;
+
+    double copy_ms = 0, shared_ms = 0;
+    bool ok = true;
+
+    et.add("Socket copy baseline");
+    ok &= run_pair(false, copy_ms);
+    et.add("Zero-copy fd passing");
+    ok &= run_pair(true, shared_ms);
+    et.finish();
+
+    double bytes = (double)NUM_JOBS * 2 * SLOT_BYTES;
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::fixed << std::setprecision(2)
+              << "Socket copy : " << bytes / 1.0e6 / copy_ms << " GB/s" << std::endl
+              << "fd passing  : " << bytes / 1.0e6 / shared_ms << " GB/s" << std::endl;
+    std::cout.flags(flags);
+
+    if (ok) {
+        std::cout
+            << std::endl
+            << "Buffer sharing example complete!"
+            << std::endl
+            << std::endl;
+    }
+    else {
+        std::cout
+            << std::endl
+            << "Buffer sharing example complete! (with errors)"
+            << std::endl
+            << std::endl;
+    }
+
+    std::cout << "--------------- Key execution times ---------------" << std::endl;
+    et.print();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
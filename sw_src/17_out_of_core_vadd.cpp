@@ -0,0 +1,337 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "chunked_stager.hpp"
+#include "verify.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+// Host and device memory use is RING_DEPTH * 3 * CHUNK_BYTES regardless of
+// how large the input files are
+#define CHUNK_BYTES (64UL * 1024 * 1024)
+#define RING_DEPTH 3
+
+using xilinx::example_utils::stream_copy;
+using xilinx::example_utils::vadd_expected;
+
+struct MappedFile
+{
+    int fd      = -1;
+    void *base  = MAP_FAILED;
+    size_t size = 0;
+};
+
+static MappedFile map_input(const char *path)
+{
+    MappedFile f;
+    f.fd = open(path, O_RDONLY);
+    if (f.fd < 0) {
+        throw_lineexception_errno(std::string("Unable to open ") + path, errno);
+    }
+    struct stat st;
+    fstat(f.fd, &st);
+    f.size = st.st_size;
+    if (f.size == 0) {
+        throw_lineexception(std::string("Input file is empty: ") + path);
+    }
+    f.base = mmap(NULL, f.size, PROT_READ, MAP_PRIVATE, f.fd, 0);
+    if (f.base == MAP_FAILED) {
+        throw_lineexception_errno(std::string("Unable to map ") + path, errno);
+    }
+    madvise(f.base, f.size, MADV_SEQUENTIAL);
+    return f;
+}
+
+static MappedFile map_output(const char *path, size_t size)
+{
+    MappedFile f;
+    f.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (f.fd < 0) {
+        throw_lineexception_errno(std::string("Unable to create ") + path, errno);
+    }
+    if (ftruncate(f.fd, size) != 0) {
+        throw_lineexception_errno(std::string("Unable to size ") + path, errno);
+    }
+    f.size = size;
+    f.base = mmap(NULL, f.size, PROT_READ | PROT_WRITE, MAP_SHARED, f.fd, 0);
+    if (f.base == MAP_FAILED) {
+        throw_lineexception_errno(std::string("Unable to map ") + path, errno);
+    }
+    return f;
+}
+
+static void unmap_file(MappedFile &f)
+{
+    if (f.base != MAP_FAILED) {
+        munmap(f.base, f.size);
+    }
+    if (f.fd >= 0) {
+        close(f.fd);
+    }
+}
+
+// Drop pages of a finished range from our address space, so resident memory
+// stays bounded. Dirty pages of the output survive in the page cache.
+static void release_range(MappedFile &f, size_t offset, size_t len)
+{
+    size_t page  = 4096;
+    size_t start = offset & ~(page - 1);
+    madvise((char *)f.base + start, len + (offset - start), MADV_DONTNEED);
+}
+
+static void generate_input(const char *path, size_t bytes, uint32_t scale)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw_lineexception_errno(std::string("Unable to create ") + path, errno);
+    }
+    std::vector<uint32_t> block(CHUNK_BYTES / sizeof(uint32_t));
+    for (size_t offset = 0; offset < bytes; offset += CHUNK_BYTES) {
+        size_t len   = std::min(CHUNK_BYTES, bytes - offset);
+        size_t first = offset / sizeof(uint32_t);
+        for (size_t i = 0; i < len / sizeof(uint32_t); i++) {
+            block[i] = (uint32_t)((first + i) * scale);
+        }
+        if (write(fd, block.data(), len) != (ssize_t)len) {
+            throw_lineexception_errno(std::string("Unable to write ") + path, errno);
+        }
+    }
+    close(fd);
+}
+
+// One slot of the device-side ring
+struct Slot
+{
+    cl::Buffer a, b, c;
+    cl::Event done;
+    bool busy     = false;
+    size_t offset = 0;
+    size_t len    = 0;
+};
+
+static void usage()
+{
+    std::cout << "Usage: 17_out_of_core_vadd <a file> <b file> <output file>" << std::endl
+              << "       17_out_of_core_vadd --generate <MiB> <a file> <b file> <output file>" << std::endl
+              << std::endl
+              << "Adds two files of little-endian uint32 values element by element." << std::endl
+              << "With --generate, input files of the given size are created first and" << std::endl
+              << "the output is verified." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    bool generate = false;
+    size_t gen_mb = 0;
+    int argi      = 1;
+    if (argc == 6 && std::string(argv[1]) == "--generate") {
+        generate = true;
+        gen_mb   = strtoul(argv[2], NULL, 0);
+        argi     = 3;
+    }
+    if (argc - argi != 3 || (generate && gen_mb == 0)) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "-- Example 17: Out-of-Core Streaming VADD --" << std::endl
+              << std::endl;
+
+    try {
+        if (generate) {
+            et.add("Generate input files");
+            generate_input(argv[argi], gen_mb * 1024 * 1024, 1);
+            generate_input(argv[argi + 1], gen_mb * 1024 * 1024, 2);
+            et.finish();
+        }
+
+        // Initialize the runtime (including a command queue) and load the
+        // FPGA image
+        std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+                  << std::endl;
+        et.add("OpenCL Initialization");
+
+        // This application will use the first Xilinx device found in the system
+        xilinx::example_utils::XilinxOclHelper xocl;
+        xocl.initialize("alveo_examples.xclbin");
+
+        cl::CommandQueue q = xocl.get_command_queue();
+        cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+        et.finish();
+
+        MappedFile a_file = map_input(argv[argi]);
+        MappedFile b_file = map_input(argv[argi + 1]);
+        if (a_file.size != b_file.size || a_file.size % sizeof(uint32_t) != 0) {
+            throw_lineexception("Input files must be the same size and hold whole uint32 values");
+        }
+        size_t total      = a_file.size;
+        MappedFile c_file = map_output(argv[argi + 2], total);
+
+        std::cout << "Streaming " << total / (1024 * 1024) << " MiB per input through "
+                  << RING_DEPTH << " x " << CHUNK_BYTES / (1024 * 1024) << " MiB device slots" << std::endl
+                  << std::endl;
+
+        et.add("Allocate device ring");
+        std::vector<Slot> ring(RING_DEPTH);
+        for (auto &slot : ring) {
+            slot.a = xocl.create_buffer(CHUNK_BYTES, CL_MEM_READ_ONLY);
+            slot.b = xocl.create_buffer(CHUNK_BYTES, CL_MEM_READ_ONLY);
+            slot.c = xocl.create_buffer(CHUNK_BYTES, CL_MEM_WRITE_ONLY);
+
+            // Let XRT resolve the banks before first use
+            krnl.setArg(0, slot.a);
+            krnl.setArg(1, slot.b);
+            krnl.setArg(2, slot.c);
+        }
+        et.finish();
+
+        // Copies a finished slot's result into the output file
+        auto drain = [&](Slot &slot) {
+            slot.done.wait();
+            void *c = q.enqueueMapBuffer(slot.c, CL_TRUE, CL_MAP_READ, 0, slot.len);
+            stream_copy((char *)c_file.base + slot.offset, c, slot.len);
+            q.enqueueUnmapMemObject(slot.c, c);
+            release_range(c_file, slot.offset, slot.len);
+            slot.busy = false;
+        };
+
+        et.add("Stream all chunks");
+        size_t num_chunks = (total + CHUNK_BYTES - 1) / CHUNK_BYTES;
+        for (size_t k = 0; k < num_chunks; k++) {
+            Slot &slot = ring[k % RING_DEPTH];
+            if (slot.busy) {
+                drain(slot);
+            }
+
+            slot.offset = k * CHUNK_BYTES;
+            slot.len    = std::min(CHUNK_BYTES, total - slot.offset);
+
+            void *a = q.enqueueMapBuffer(slot.a, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, slot.len);
+            void *b = q.enqueueMapBuffer(slot.b, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, slot.len);
+            stream_copy(a, (char *)a_file.base + slot.offset, slot.len);
+            stream_copy(b, (char *)b_file.base + slot.offset, slot.len);
+            q.enqueueUnmapMemObject(slot.a, a);
+            q.enqueueUnmapMemObject(slot.b, b);
+            release_range(a_file, slot.offset, slot.len);
+            release_range(b_file, slot.offset, slot.len);
+
+            // The queue is out of order, so chain this slot's commands
+            // explicitly; different slots overlap freely
+            cl::Event m_event, k_event;
+            std::vector<cl::Event> deps;
+            q.enqueueMigrateMemObjects({slot.a, slot.b}, 0, NULL, &m_event);
+            deps.push_back(m_event);
+
+            krnl.setArg(0, slot.a);
+            krnl.setArg(1, slot.b);
+            krnl.setArg(2, slot.c);
+            krnl.setArg(3, (uint64_t)(slot.len / sizeof(uint32_t)));
+            q.enqueueTask(krnl, &deps, &k_event);
+
+            deps[0] = k_event;
+            q.enqueueMigrateMemObjects({slot.c}, CL_MIGRATE_MEM_OBJECT_HOST, &deps, &slot.done);
+            q.flush();
+            slot.busy = true;
+        }
+
+        // Drain in submission order
+        for (size_t k = num_chunks; k < num_chunks + RING_DEPTH; k++) {
+            Slot &slot = ring[k % RING_DEPTH];
+            if (slot.busy) {
+                drain(slot);
+            }
+        }
+        msync(c_file.base, c_file.size, MS_SYNC);
+        et.finish();
+
+        bool verified = true;
+        if (generate) {
+            et.add("Verify output file");
+            xilinx::example_utils::VerifyResult result =
+                xilinx::example_utils::verify_buffer((const uint32_t *)c_file.base,
+                                                     total / sizeof(uint32_t),
+                                                     vadd_expected);
+            et.finish();
+            verified = result.ok();
+            if (!verified) {
+                std::cout << "ERROR: software and hardware vadd do not match: ";
+                xilinx::example_utils::print_verify_result(std::cout, result);
+            }
+        }
+
+        unmap_file(a_file);
+        unmap_file(b_file);
+        unmap_file(c_file);
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Out-of-core vadd example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Out-of-core vadd example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,394 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "direct_reader.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define CHUNK_BYTES (8UL * 1024 * 1024)
+#define DEFAULT_QUEUE_DEPTH 8
+
+using xilinx::example_utils::DirectFileReader;
+using xilinx::example_utils::ReadRequest;
+
+static double ms_since(std::chrono::high_resolution_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> d = std::chrono::high_resolution_clock::now() - start;
+    return d.count();
+}
+
+static void generate_file(const char *path, size_t bytes)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw_lineexception_errno(std::string("Unable to create ") + path, errno);
+    }
+    std::vector<uint32_t> block(CHUNK_BYTES / sizeof(uint32_t));
+    for (size_t offset = 0; offset < bytes; offset += CHUNK_BYTES) {
+        size_t len   = std::min(CHUNK_BYTES, bytes - offset);
+        size_t first = offset / sizeof(uint32_t);
+        for (size_t i = 0; i < len / sizeof(uint32_t); i++) {
+            block[i] = (uint32_t)(first + i);
+        }
+        if (write(fd, block.data(), len) != (ssize_t)len) {
+            throw_lineexception_errno(std::string("Unable to write ") + path, errno);
+        }
+    }
+    fsync(fd);
+    close(fd);
+}
+
+// Evict the file from the page cache so both runs start from the disk
+static void drop_page_cache(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// One chunk's worth of device buffers. Both stay mapped for the whole run so
+// reads can land in 'a' directly.
+struct Slot
+{
+    cl::Buffer a_buf, c_buf;
+    uint32_t *a = nullptr;
+    uint32_t *c = nullptr;
+    cl::Event done;
+    bool busy     = false;
+    size_t offset = 0;
+    size_t len    = 0;
+};
+
+struct Pipeline
+{
+    cl::CommandQueue q;
+    cl::Kernel krnl;
+    std::vector<Slot> ring;
+    bool verified = true;
+
+    // Each chunk computes c = a + a, so no second input file is needed
+    void launch(Slot &slot)
+    {
+        cl::Event m_event, k_event;
+        std::vector<cl::Event> deps;
+
+        q.enqueueMigrateMemObjects({slot.a_buf}, 0, NULL, &m_event);
+        deps.push_back(m_event);
+
+        krnl.setArg(0, slot.a_buf);
+        krnl.setArg(1, slot.a_buf);
+        krnl.setArg(2, slot.c_buf);
+        krnl.setArg(3, (uint64_t)(slot.len / sizeof(uint32_t)));
+        q.enqueueTask(krnl, &deps, &k_event);
+
+        deps[0] = k_event;
+        q.enqueueMigrateMemObjects({slot.c_buf}, CL_MIGRATE_MEM_OBJECT_HOST, &deps, &slot.done);
+        q.flush();
+        slot.busy = true;
+    }
+
+    // Waits for a slot's results and checks them against its input
+    void recycle(Slot &slot)
+    {
+        slot.done.wait();
+        for (size_t i = 0; verified && i < slot.len / sizeof(uint32_t); i++) {
+            if (slot.c[i] != 2 * slot.a[i]) {
+                verified = false;
+                std::cout << "ERROR: software and hardware vadd do not match: "
+                          << slot.c[i] << "!=" << 2 * slot.a[i] << " at position "
+                          << slot.offset / sizeof(uint32_t) + i << std::endl;
+            }
+        }
+        slot.busy = false;
+    }
+
+    void recycle_all()
+    {
+        for (auto &slot : ring) {
+            if (slot.busy) {
+                recycle(slot);
+            }
+        }
+    }
+};
+
+static bool event_complete(cl::Event &event)
+{
+    return event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() == CL_COMPLETE;
+}
+
+// Baseline: buffered read() through the page cache into a bounce buffer,
+// then a copy into the mapped device buffer
+static void run_buffered(Pipeline &p, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw_lineexception_errno(std::string("Unable to open ") + path, errno);
+    }
+    size_t total = lseek(fd, 0, SEEK_END);
+    std::vector<char> bounce(CHUNK_BYTES);
+
+    size_t num_chunks = (total + CHUNK_BYTES - 1) / CHUNK_BYTES;
+    for (size_t k = 0; k < num_chunks; k++) {
+        Slot &slot = p.ring[k % p.ring.size()];
+        if (slot.busy) {
+            p.recycle(slot);
+        }
+        slot.offset = k * CHUNK_BYTES;
+        slot.len    = std::min(CHUNK_BYTES, total - slot.offset);
+
+        size_t done = 0;
+        while (done < slot.len) {
+            ssize_t ret = pread(fd, bounce.data() + done, slot.len - done, slot.offset + done);
+            if (ret <= 0) {
+                close(fd);
+                throw_lineexception_errno("Buffered read failed", errno);
+            }
+            done += ret;
+        }
+        memcpy(slot.a, bounce.data(), slot.len);
+        p.launch(slot);
+    }
+    p.recycle_all();
+    close(fd);
+}
+
+// Reads land in the mapped buffers with up to 'queue depth' in flight, and
+// every completed read is handed to the migrate/kernel stage right away
+static void run_direct(Pipeline &p, DirectFileReader &reader)
+{
+    size_t total       = reader.size();
+    size_t next_offset = 0;
+    std::vector<size_t> launched; // slot indices in launch order
+
+    auto start_read = [&](size_t idx) {
+        Slot &slot  = p.ring[idx];
+        slot.offset = next_offset;
+        slot.len    = std::min(CHUNK_BYTES, total - next_offset);
+        next_offset += slot.len;
+
+        ReadRequest req;
+        req.dst    = slot.a;
+        req.offset = slot.offset;
+        req.len    = CHUNK_BYTES;
+        req.tag    = idx;
+        reader.submit(req);
+    };
+
+    for (size_t idx = 0; idx < p.ring.size() && next_offset < total; idx++) {
+        start_read(idx);
+    }
+
+    while (reader.in_flight() > 0 || !launched.empty()) {
+        // Recycle slots the card has finished with and refill them
+        while (!launched.empty() &&
+               (reader.in_flight() == 0 || event_complete(p.ring[launched.front()].done))) {
+            size_t idx = launched.front();
+            launched.erase(launched.begin());
+            p.recycle(p.ring[idx]);
+            if (next_offset < total) {
+                start_read(idx);
+            }
+        }
+
+        if (reader.in_flight() > 0) {
+            ReadRequest req = reader.wait_completion();
+            Slot &slot      = p.ring[req.tag];
+            slot.len        = req.bytes;
+            p.launch(slot);
+            launched.push_back(req.tag);
+        }
+    }
+}
+
+static void usage()
+{
+    std::cout << "Usage: 18_direct_io_reader <file> [queue depth]" << std::endl
+              << "       18_direct_io_reader --generate <MiB> <file> [queue depth]" << std::endl
+              << std::endl
+              << "Streams a file of uint32 values through wide_vadd (c = a + a) twice:" << std::endl
+              << "once with buffered reads and a copy, once with O_DIRECT reads issued" << std::endl
+              << "through io_uring straight into mapped device buffers." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    int argi      = 1;
+    size_t gen_mb = 0;
+    if (argc > 1 && std::string(argv[1]) == "--generate") {
+        if (argc < 4 || (gen_mb = strtoul(argv[2], NULL, 0)) == 0) {
+            usage();
+            return EXIT_FAILURE;
+        }
+        argi = 3;
+    }
+    if (argc - argi < 1 || argc - argi > 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    const char *path         = argv[argi];
+    unsigned int queue_depth = DEFAULT_QUEUE_DEPTH;
+    if (argc - argi == 2) {
+        queue_depth = strtoul(argv[argi + 1], NULL, 0);
+        if (queue_depth == 0) {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "-- Example 18: Direct File Reads into Device Buffers --" << std::endl
+              << std::endl;
+
+    try {
+        if (gen_mb) {
+            et.add("Generate input file");
+            generate_file(path, gen_mb * 1024 * 1024);
+            et.finish();
+        }
+
+        // Initialize the runtime (including a command queue) and load the
+        // FPGA image
+        std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+                  << std::endl;
+        et.add("OpenCL Initialization");
+
+        // This application will use the first Xilinx device found in the system
+        xilinx::example_utils::XilinxOclHelper xocl;
+        xocl.initialize("alveo_examples.xclbin");
+
+        Pipeline p;
+        p.q    = xocl.get_command_queue();
+        p.krnl = xocl.get_kernel("wide_vadd");
+        et.finish();
+
+        DirectFileReader reader(path, queue_depth);
+        if (reader.size() == 0 || reader.size() % sizeof(uint32_t) != 0) {
+            throw_lineexception("Input file must be non-empty and hold whole uint32 values");
+        }
+
+        // One slot per outstanding read. Set the kernel arguments before
+        // mapping so XRT can place the buffers in the right bank.
+        et.add("Allocate and map device ring");
+        p.ring.resize(queue_depth);
+        for (auto &slot : p.ring) {
+            slot.a_buf = xocl.create_buffer(CHUNK_BYTES, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+            slot.c_buf = xocl.create_buffer(CHUNK_BYTES, CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR);
+            p.krnl.setArg(0, slot.a_buf);
+            p.krnl.setArg(1, slot.a_buf);
+            p.krnl.setArg(2, slot.c_buf);
+
+            slot.a = (uint32_t *)p.q.enqueueMapBuffer(slot.a_buf, CL_TRUE, CL_MAP_WRITE, 0, CHUNK_BYTES);
+            slot.c = (uint32_t *)p.q.enqueueMapBuffer(slot.c_buf, CL_TRUE, CL_MAP_READ, 0, CHUNK_BYTES);
+            if ((uintptr_t)slot.a % DIRECT_READ_ALIGN) {
+                throw_lineexception("XRT returned a host pointer unsuitable for O_DIRECT");
+            }
+        }
+        et.finish();
+
+        std::cout << "File: " << reader.size() / (1024 * 1024) << " MiB, "
+                  << CHUNK_BYTES / (1024 * 1024) << " MiB chunks, queue depth " << queue_depth
+                  << ", engine: " << reader.engine_name() << std::endl
+                  << std::endl;
+
+        drop_page_cache(path);
+        et.add("Buffered read + copy");
+        auto start         = std::chrono::high_resolution_clock::now();
+        run_buffered(p, path);
+        double buffered_ms = ms_since(start);
+        et.finish();
+
+        drop_page_cache(path);
+        et.add("Direct read into mapped buffers");
+        start            = std::chrono::high_resolution_clock::now();
+        run_direct(p, reader);
+        double direct_ms = ms_since(start);
+        et.finish();
+
+        std::ios_base::fmtflags flags(std::cout.flags());
+        std::cout << std::fixed << std::setprecision(1)
+                  << "Buffered read + copy: " << std::setw(9) << buffered_ms << " ms, "
+                  << reader.size() / 1.0e3 / buffered_ms << " MB/s" << std::endl
+                  << "Direct read:          " << std::setw(9) << direct_ms << " ms, "
+                  << reader.size() / 1.0e3 / direct_ms << " MB/s" << std::endl;
+        std::cout.flags(flags);
+
+        for (auto &slot : p.ring) {
+            p.q.enqueueUnmapMemObject(slot.a_buf, slot.a);
+            p.q.enqueueUnmapMemObject(slot.c_buf, slot.c);
+        }
+        p.q.finish();
+
+        if (p.verified) {
+            std::cout
+                << std::endl
+                << "Direct file read example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Direct file read example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return p.verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
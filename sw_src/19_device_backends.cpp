@@ -0,0 +1,205 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Runs on a card or, without one, on the CPU emulation backend
+#include "cpu_backend.hpp"
+#include "device_backend.hpp"
+
+#define TOTAL_ELEMS (16 * 1024 * 1024)
+#define RING_DEPTH 4
+
+using namespace xilinx::example_utils;
+
+struct Slot
+{
+    BufferHandle a, b, c;
+    EventHandle done;
+    size_t first = 0;
+    size_t count = 0;
+};
+
+static bool check_slot(Slot &slot)
+{
+    const uint32_t *c = (const uint32_t *)slot.c->host_ptr();
+    for (size_t i = 0; i < slot.count; i++) {
+        if (c[i] != (uint32_t)(3 * (slot.first + i))) {
+            std::cout << "ERROR: software and hardware vadd do not match: "
+                      << c[i] << "!=" << (uint32_t)(3 * (slot.first + i))
+                      << " at position " << slot.first + i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Example 5's pipeline with a bounded ring of buffers: while chunk k is being
+// computed, chunk k+1 is being migrated and chunk k-1 is on its way back.
+// 'submit_us' gets the mean host time spent submitting one chunk's commands.
+static bool run_pipeline(DeviceBackend &dev, size_t chunk_elems, double &submit_us)
+{
+    std::vector<Slot> ring(RING_DEPTH);
+    for (auto &slot : ring) {
+        slot.a = dev.create_buffer(chunk_elems * sizeof(uint32_t), BufferAccess::ReadOnly);
+        slot.b = dev.create_buffer(chunk_elems * sizeof(uint32_t), BufferAccess::ReadOnly);
+        slot.c = dev.create_buffer(chunk_elems * sizeof(uint32_t), BufferAccess::WriteOnly);
+        dev.bind_kernel_args("wide_vadd", KernelArgs().set(0, slot.a).set(1, slot.b).set(2, slot.c));
+    }
+
+    bool verified     = true;
+    size_t num_chunks = (TOTAL_ELEMS + chunk_elems - 1) / chunk_elems;
+    std::chrono::duration<double, std::micro> submit(0);
+    for (size_t k = 0; k < num_chunks + RING_DEPTH; k++) {
+        Slot &slot = ring[k % RING_DEPTH];
+        if (slot.done) {
+            slot.done->wait();
+            verified  = check_slot(slot) && verified;
+            slot.done = nullptr;
+        }
+        if (k >= num_chunks) {
+            continue;
+        }
+
+        slot.first  = k * chunk_elems;
+        slot.count  = std::min(chunk_elems, TOTAL_ELEMS - slot.first);
+        uint32_t *a = (uint32_t *)slot.a->host_ptr();
+        uint32_t *b = (uint32_t *)slot.b->host_ptr();
+        for (size_t i = 0; i < slot.count; i++) {
+            a[i] = (uint32_t)(slot.first + i);
+            b[i] = (uint32_t)(2 * (slot.first + i));
+        }
+
+        KernelArgs args;
+        args.set(0, slot.a).set(1, slot.b).set(2, slot.c).set(3, (uint64_t)slot.count);
+
+        auto start         = std::chrono::high_resolution_clock::now();
+        EventHandle to_dev = dev.migrate({slot.a, slot.b}, MigrateDirection::ToDevice);
+        EventHandle run    = dev.run_kernel("wide_vadd", args, {to_dev});
+        slot.done          = dev.migrate({slot.c}, MigrateDirection::ToHost, {run});
+        submit += std::chrono::high_resolution_clock::now() - start;
+    }
+    dev.finish();
+    submit_us = submit.count() / num_chunks;
+    return verified;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 19: Pluggable Device Backends --" << std::endl
+              << std::endl;
+
+    // Backends to compare, e.g. "ocl xrt"; by default XILINX_EXAMPLES_BACKEND
+    // (cpu|ocl|xrt|auto) picks one
+    std::vector<std::string> kinds(argv + 1, argv + argc);
+    if (kinds.empty()) {
+        kinds.push_back("");
+    }
+
+    try {
+        bool verified = true;
+        for (auto &kind : kinds) {
+            et.add("Backend initialization");
+            std::unique_ptr<DeviceBackend> dev = kind.empty() ? create_device_backend("alveo_examples.xclbin")
+                                                              : create_device_backend("alveo_examples.xclbin", kind);
+            et.finish();
+
+            std::cout << "Backend: " << dev->name() << std::endl;
+            CpuBackend *cpu = dynamic_cast<CpuBackend *>(dev.get());
+            if (cpu) {
+                const CpuBackendConfig &cfg = cpu->get_config();
+                std::cout << "Modelled DMA: " << cfg.h2d_gbps << " GB/s to card, " << cfg.d2h_gbps
+                          << " GB/s from card; launch latency " << cfg.launch_latency_us << " us; "
+                          << cfg.compute_units << " compute unit(s)" << std::endl;
+            }
+            std::cout << std::endl;
+
+            // Sweep the chunk size, the main knob of this pipeline. The submit
+            // column is the host cost of the backend's API per chunk.
+            std::ios_base::fmtflags flags(std::cout.flags());
+            std::cout << std::setw(12) << "Chunk (KiB)" << std::setw(12) << "Time (ms)"
+                      << std::setw(12) << "GB/s" << std::setw(20) << "Submit (us/chunk)" << std::endl;
+            for (size_t chunk_elems = 16 * 1024; chunk_elems <= TOTAL_ELEMS / 4; chunk_elems *= 4) {
+                std::string label = std::string(dev->name()) + " pipeline, " +
+                                    std::to_string(chunk_elems * 4 / 1024) + " KiB chunks";
+                double submit_us = 0;
+                et.add(label);
+                auto start = std::chrono::high_resolution_clock::now();
+                verified   = run_pipeline(*dev, chunk_elems, submit_us) && verified;
+                std::chrono::duration<double, std::milli> ms =
+                    std::chrono::high_resolution_clock::now() - start;
+                et.finish();
+
+                std::cout << std::fixed << std::setprecision(2)
+                          << std::setw(12) << chunk_elems * 4 / 1024
+                          << std::setw(12) << ms.count()
+                          << std::setw(12) << (3.0 * TOTAL_ELEMS * 4 / 1.0e6) / ms.count()
+                          << std::setw(20) << submit_us << std::endl;
+            }
+            std::cout.flags(flags);
+            std::cout << std::endl;
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Device backend example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Device backend example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
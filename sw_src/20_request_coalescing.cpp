@@ -0,0 +1,238 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs on a card or, without one, on the CPU emulation backend
+#include "coalescer.hpp"
+#include "device_backend.hpp"
+
+#define MIN_ELEMS 256
+#define MAX_ELEMS 4096
+#define DEFAULT_THREADS 8
+#define DEFAULT_REQUESTS 500
+
+using namespace xilinx::example_utils;
+
+struct RunResult
+{
+    double seconds = 0.0;
+    std::vector<double> latencies_us;
+    bool verified = true;
+};
+
+// Runs 'requests' synchronous requests of random small sizes on each of
+// 'threads' client threads; 'offload' performs one request
+template <typename Fn>
+static RunResult run_clients(unsigned int threads, unsigned int requests, Fn offload)
+{
+    RunResult result;
+    std::vector<std::vector<double>> latencies(threads);
+    std::atomic<bool> ok(true);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            std::mt19937 rng(t);
+            std::uniform_int_distribution<size_t> size_dist(MIN_ELEMS, MAX_ELEMS);
+            std::vector<uint32_t> a(MAX_ELEMS), b(MAX_ELEMS), c(MAX_ELEMS);
+
+            for (unsigned int r = 0; r < requests; r++) {
+                size_t n = size_dist(rng);
+                for (size_t i = 0; i < n; i++) {
+                    a[i] = (uint32_t)(i + r);
+                    b[i] = (uint32_t)(2 * i + t);
+                }
+
+                auto req_start = std::chrono::steady_clock::now();
+                offload(t, a.data(), b.data(), c.data(), n);
+                std::chrono::duration<double, std::micro> us = std::chrono::steady_clock::now() - req_start;
+                latencies[t].push_back(us.count());
+
+                for (size_t i = 0; i < n; i++) {
+                    if (c[i] != a[i] + b[i]) {
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &th : pool) {
+        th.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    result.seconds  = elapsed.count();
+    result.verified = ok;
+    for (auto &l : latencies) {
+        result.latencies_us.insert(result.latencies_us.end(), l.begin(), l.end());
+    }
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+static void print_row(const char *mode, const RunResult &r, double batch_size)
+{
+    double mean = 0.0;
+    for (auto l : r.latencies_us) {
+        mean += l;
+    }
+    mean /= r.latencies_us.size();
+    double p99 = r.latencies_us[(size_t)(0.99 * (r.latencies_us.size() - 1))];
+
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(12) << mode << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << r.latencies_us.size() / r.seconds
+              << std::setw(14) << mean
+              << std::setw(14) << p99
+              << std::setw(12) << batch_size << std::endl;
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    unsigned int threads  = DEFAULT_THREADS;
+    unsigned int requests = DEFAULT_REQUESTS;
+    if (argc > 1) {
+        threads = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        requests = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3 || threads == 0 || requests == 0) {
+        std::cout << "Usage: 20_request_coalescing [client threads] [requests per thread]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "-- Example 20: Coalescing Small Requests --" << std::endl
+              << std::endl;
+
+    try {
+        et.add("Backend initialization");
+        std::unique_ptr<DeviceBackend> dev = create_device_backend("alveo_examples.xclbin");
+        et.finish();
+
+        std::cout << "Backend: " << dev->name() << ", " << threads << " client thread(s), "
+                  << requests << " requests each of " << MIN_ELEMS * 4 / 1024 << "-"
+                  << MAX_ELEMS * 4 / 1024 << " KiB" << std::endl
+                  << std::endl;
+
+        // Baseline: every request does its own migrate, task and migrate
+        // using buffers private to its client thread
+        et.add("Allocate per-thread buffers");
+        std::vector<BufferHandle> a_bufs, b_bufs, c_bufs;
+        for (unsigned int t = 0; t < threads; t++) {
+            a_bufs.push_back(dev->create_buffer(MAX_ELEMS * sizeof(uint32_t), BufferAccess::ReadOnly));
+            b_bufs.push_back(dev->create_buffer(MAX_ELEMS * sizeof(uint32_t), BufferAccess::ReadOnly));
+            c_bufs.push_back(dev->create_buffer(MAX_ELEMS * sizeof(uint32_t), BufferAccess::WriteOnly));
+            dev->bind_kernel_args("wide_vadd", KernelArgs().set(0, a_bufs[t]).set(1, b_bufs[t]).set(2, c_bufs[t]));
+        }
+        et.finish();
+
+        et.add("Individual requests");
+        RunResult direct = run_clients(threads, requests, [&](unsigned int t, const uint32_t *a, const uint32_t *b, uint32_t *c, size_t n) {
+            memcpy(a_bufs[t]->host_ptr(), a, n * sizeof(uint32_t));
+            memcpy(b_bufs[t]->host_ptr(), b, n * sizeof(uint32_t));
+
+            KernelArgs args;
+            args.set(0, a_bufs[t]).set(1, b_bufs[t]).set(2, c_bufs[t]).set(3, (uint64_t)n);
+            EventHandle to_dev = dev->migrate({a_bufs[t], b_bufs[t]}, MigrateDirection::ToDevice);
+            EventHandle run    = dev->run_kernel("wide_vadd", args, {to_dev});
+            dev->migrate({c_bufs[t]}, MigrateDirection::ToHost, {run})->wait();
+
+            memcpy(c, c_bufs[t]->host_ptr(), n * sizeof(uint32_t));
+        });
+        et.finish();
+
+        et.add("Coalesced requests");
+        CoalescerStats stats;
+        RunResult coalesced;
+        {
+            VaddCoalescer coalescer(*dev);
+            coalesced = run_clients(threads, requests, [&](unsigned int /*t*/, const uint32_t *a, const uint32_t *b, uint32_t *c, size_t n) {
+                coalescer.submit(a, b, c, n).get();
+            });
+            stats = coalescer.get_stats();
+        }
+        et.finish();
+
+        std::cout << std::left << std::setw(12) << "Mode" << std::right << std::setw(12) << "Req/s"
+                  << std::setw(14) << "Mean (us)" << std::setw(14) << "p99 (us)"
+                  << std::setw(12) << "Req/batch" << std::endl;
+        print_row("Individual", direct, 1.0);
+        print_row("Coalesced", coalesced, stats.batches ? (double)stats.requests / stats.batches : 0.0);
+
+        bool verified = direct.verified && coalesced.verified;
+        if (!verified) {
+            std::cout << "ERROR: software and hardware vadd do not match" << std::endl;
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Request coalescing example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Request coalescing example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
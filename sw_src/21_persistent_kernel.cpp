@@ -0,0 +1,273 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Runs on a card or, without one, on the CPU emulation backend
+#include "device_backend.hpp"
+#include "mailbox_vadd.hpp"
+#include "verify.hpp"
+
+#define DEFAULT_JOB_ELEMS 4096
+#define DEFAULT_JOBS 2000
+#define PIPELINE_DEPTH 8
+
+using namespace xilinx::example_utils;
+
+struct RunResult
+{
+    double seconds = 0.0;
+    std::vector<double> latencies_us;
+};
+
+// Runs 'jobs' jobs with up to 'depth' in flight. submit(slot) starts a job on
+// buffer slot 'slot' and returns a handle that wait() blocks on; a slot is
+// only reused once its previous job has been waited for.
+template <typename SubmitFn, typename WaitFn>
+static RunResult run_jobs(unsigned int jobs, unsigned int depth, SubmitFn submit, WaitFn wait)
+{
+    typedef decltype(submit(0u)) Handle;
+    struct InFlight
+    {
+        Handle handle;
+        std::chrono::steady_clock::time_point start;
+    };
+    std::deque<InFlight> in_flight;
+    RunResult result;
+
+    auto retire = [&]() {
+        wait(in_flight.front().handle);
+        std::chrono::duration<double, std::micro> us = std::chrono::steady_clock::now() - in_flight.front().start;
+        result.latencies_us.push_back(us.count());
+        in_flight.pop_front();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int j = 0; j < jobs; j++) {
+        if (in_flight.size() == depth) {
+            retire();
+        }
+        auto job_start = std::chrono::steady_clock::now();
+        in_flight.push_back({submit(j % depth), job_start});
+    }
+    while (!in_flight.empty()) {
+        retire();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    result.seconds = elapsed.count();
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+static void fill_inputs(uint32_t *a, uint32_t *b, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        a[i] = (uint32_t)i;
+        b[i] = (uint32_t)(3 * i + 1);
+    }
+}
+
+// Checks the first 'job_elems' results of each of 'slots' slots
+static bool verify_slots(const uint32_t *c, unsigned int slots, size_t stride, size_t job_elems)
+{
+    for (unsigned int s = 0; s < slots; s++) {
+        size_t base     = s * stride;
+        VerifyResult vr = verify_buffer(c + base, job_elems, [base](size_t first, size_t count, uint32_t *out) {
+            for (size_t i = 0; i < count; i++) {
+                size_t idx = base + first + i;
+                out[i]     = (uint32_t)idx + (uint32_t)(3 * idx + 1);
+            }
+        });
+        if (!vr.ok()) {
+            std::cout << "Slot " << s << ": ";
+            print_verify_result(std::cout, vr);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_row(const std::string &mode, const RunResult &r)
+{
+    double mean = 0.0;
+    for (auto l : r.latencies_us) {
+        mean += l;
+    }
+    mean /= r.latencies_us.size();
+    double p99 = r.latencies_us[(size_t)(0.99 * (r.latencies_us.size() - 1))];
+
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(24) << mode << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << r.latencies_us.size() / r.seconds
+              << std::setw(14) << mean
+              << std::setw(14) << p99 << std::endl;
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    size_t job_elems  = DEFAULT_JOB_ELEMS;
+    unsigned int jobs = DEFAULT_JOBS;
+    if (argc > 1) {
+        job_elems = strtoull(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        jobs = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3 || job_elems == 0 || jobs == 0) {
+        std::cout << "Usage: 21_persistent_kernel [elements per job] [jobs]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "-- Example 21: Persistent Kernel with a Mailbox --" << std::endl
+              << std::endl;
+
+    try {
+        et.add("Backend initialization");
+        std::unique_ptr<DeviceBackend> dev = create_device_backend("alveo_examples.xclbin");
+        et.finish();
+
+        // Every job gets its own 4 KiB aligned slot in a shared set of buffers
+        size_t stride = (job_elems + MAILBOX_ALIGN_ELEMS - 1) / MAILBOX_ALIGN_ELEMS * MAILBOX_ALIGN_ELEMS;
+        size_t bytes  = PIPELINE_DEPTH * stride * sizeof(uint32_t);
+
+        std::cout << "Backend: " << dev->name() << ", " << jobs << " jobs of " << job_elems
+                  << " elements" << std::endl
+                  << std::endl;
+
+        std::vector<RunResult> results;
+        std::vector<std::string> modes;
+        bool verified = true;
+
+        // Baseline: a kernel start per job through the scheduler
+        et.add("Allocate launch-per-job buffers");
+        BufferHandle a = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+        BufferHandle b = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+        BufferHandle c = dev->create_buffer(bytes, BufferAccess::WriteOnly);
+        dev->bind_kernel_args("wide_vadd", KernelArgs().set(0, a).set(1, b).set(2, c));
+        fill_inputs((uint32_t *)a->host_ptr(), (uint32_t *)b->host_ptr(), bytes / sizeof(uint32_t));
+        et.finish();
+
+        auto launch = [&](unsigned int slot) {
+            size_t offset    = slot * stride * sizeof(uint32_t);
+            size_t sub_bytes = stride * sizeof(uint32_t);
+            BufferHandle as  = dev->create_sub_buffer(a, offset, sub_bytes);
+            BufferHandle bs  = dev->create_sub_buffer(b, offset, sub_bytes);
+            BufferHandle cs  = dev->create_sub_buffer(c, offset, sub_bytes);
+
+            KernelArgs args;
+            args.set(0, as).set(1, bs).set(2, cs).set(3, (uint64_t)job_elems);
+            EventHandle to_dev = dev->migrate({as, bs}, MigrateDirection::ToDevice);
+            EventHandle run    = dev->run_kernel("wide_vadd", args, {to_dev});
+            return dev->migrate({cs}, MigrateDirection::ToHost, {run});
+        };
+        auto launch_wait = [](EventHandle &done) { done->wait(); };
+
+        for (unsigned int depth : {1u, (unsigned int)PIPELINE_DEPTH}) {
+            et.add("Launch per job, depth " + std::to_string(depth));
+            memset(c->host_ptr(), 0, bytes);
+            results.push_back(run_jobs(jobs, depth, launch, launch_wait));
+            modes.push_back("Launch, depth " + std::to_string(depth));
+            verified = verify_slots((const uint32_t *)c->host_ptr(), depth, stride, job_elems) && verified;
+            et.finish();
+        }
+
+        // The persistent kernel holds its compute unit until stopped
+        {
+            et.add("Start mailbox kernel");
+            MailboxVadd mailbox(*dev, PIPELINE_DEPTH * stride);
+            fill_inputs(mailbox.get_a(), mailbox.get_b(), mailbox.get_capacity());
+            et.finish();
+
+            auto post      = [&](unsigned int slot) { return mailbox.submit(slot * stride, job_elems); };
+            auto post_wait = [&](uint64_t &ticket) { mailbox.wait(ticket); };
+
+            for (unsigned int depth : {1u, (unsigned int)PIPELINE_DEPTH}) {
+                et.add("Mailbox, depth " + std::to_string(depth));
+                memset(mailbox.get_c(), 0, mailbox.get_capacity() * sizeof(uint32_t));
+                results.push_back(run_jobs(jobs, depth, post, post_wait));
+                modes.push_back("Mailbox, depth " + std::to_string(depth));
+                verified = verify_slots(mailbox.get_c(), depth, stride, job_elems) && verified;
+                et.finish();
+            }
+
+            et.add("Stop mailbox kernel");
+            mailbox.stop();
+            et.finish();
+        }
+
+        std::cout << std::left << std::setw(24) << "Mode" << std::right << std::setw(12) << "Jobs/s"
+                  << std::setw(14) << "Mean (us)" << std::setw(14) << "p99 (us)" << std::endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            print_row(modes[i], results[i]);
+        }
+
+        if (!verified) {
+            std::cout << "ERROR: software and hardware vadd do not match" << std::endl;
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Persistent kernel example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Persistent kernel example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,258 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Runs on a card or, without one, on the CPU emulation backend
+#include "command_graph.hpp"
+#include "device_backend.hpp"
+#include "verify.hpp"
+
+#define TOTAL_ELEMS (16 * 1024 * 1024)
+#define CHUNK_ELEMS (64 * 1024)
+#define NUM_CHUNKS (TOTAL_ELEMS / CHUNK_ELEMS)
+
+using namespace xilinx::example_utils;
+
+// Per chunk: c = a + b and d = e + b, two wide_vadd runs that both wait for
+// the inputs and are both waited for by the read back. Each buffer is always
+// passed as the same kernel argument, so it stays in that argument's bank.
+struct Chunk
+{
+    BufferHandle a, b, c, d, e;
+};
+
+struct RunResult
+{
+    double submit_ms = 0.0;
+    double total_ms  = 0.0;
+};
+
+static RunResult run_hand_chained(DeviceBackend &dev, const std::vector<Chunk> &chunks)
+{
+    RunResult result;
+    std::vector<EventHandle> done;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto &ch : chunks) {
+        KernelArgs add_args;
+        add_args.set(0, ch.a).set(1, ch.b).set(2, ch.c).set(3, (uint64_t)CHUNK_ELEMS);
+        KernelArgs add_other_args;
+        add_other_args.set(0, ch.e).set(1, ch.b).set(2, ch.d).set(3, (uint64_t)CHUNK_ELEMS);
+
+        EventHandle to_dev    = dev.migrate({ch.a, ch.b, ch.e}, MigrateDirection::ToDevice);
+        EventHandle add       = dev.run_kernel("wide_vadd", add_args, {to_dev});
+        EventHandle add_other = dev.run_kernel("wide_vadd", add_other_args, {to_dev});
+        done.push_back(dev.migrate({ch.c, ch.d}, MigrateDirection::ToHost, {add, add_other}));
+    }
+    auto submitted = std::chrono::high_resolution_clock::now();
+    for (auto &ev : done) {
+        ev->wait();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    result.submit_ms = std::chrono::duration<double, std::milli>(submitted - start).count();
+    result.total_ms  = std::chrono::duration<double, std::milli>(end - start).count();
+    return result;
+}
+
+static RunResult run_graph(GraphExec &exec, const std::vector<Chunk> &chunks)
+{
+    RunResult result;
+    std::vector<GraphRun> runs;
+    runs.reserve(chunks.size());
+    KernelArgs bindings;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto &ch : chunks) {
+        bindings.set(0, ch.a).set(1, ch.b).set(2, ch.c).set(3, ch.d).set(4, ch.e);
+        runs.push_back(exec.replay(bindings));
+    }
+    auto submitted = std::chrono::high_resolution_clock::now();
+    for (auto &run : runs) {
+        run.wait();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    result.submit_ms = std::chrono::duration<double, std::milli>(submitted - start).count();
+    result.total_ms  = std::chrono::duration<double, std::milli>(end - start).count();
+    return result;
+}
+
+static bool verify_results(const BufferHandle &c, const BufferHandle &d)
+{
+    VerifyResult vc = verify_buffer((const uint32_t *)c->host_ptr(), TOTAL_ELEMS, vadd_expected);
+    VerifyResult vd = verify_buffer((const uint32_t *)d->host_ptr(), TOTAL_ELEMS, [](size_t first, size_t count, uint32_t *out) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = (uint32_t)(6 * (first + i));
+        }
+    });
+    if (!vc.ok()) {
+        std::cout << "c: ";
+        print_verify_result(std::cout, vc);
+    }
+    if (!vd.ok()) {
+        std::cout << "d: ";
+        print_verify_result(std::cout, vd);
+    }
+    return vc.ok() && vd.ok();
+}
+
+static void print_row(const char *mode, const RunResult &r)
+{
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(14) << mode << std::right << std::fixed << std::setprecision(2)
+              << std::setw(14) << r.submit_ms
+              << std::setw(16) << r.submit_ms * 1000.0 / NUM_CHUNKS
+              << std::setw(14) << r.total_ms << std::endl;
+    std::cout.flags(flags);
+}
+
+int main()
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::cout << "-- Example 22: Recorded Command Graphs --" << std::endl
+              << std::endl;
+
+    try {
+        et.add("Backend initialization");
+        std::unique_ptr<DeviceBackend> dev = create_device_backend("alveo_examples.xclbin");
+        et.finish();
+
+        std::cout << "Backend: " << dev->name() << ", " << NUM_CHUNKS << " chunks of "
+                  << CHUNK_ELEMS * 4 / 1024 << " KiB" << std::endl
+                  << std::endl;
+
+        et.add("Allocate and populate buffers");
+        size_t bytes   = TOTAL_ELEMS * sizeof(uint32_t);
+        BufferHandle a = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+        BufferHandle b = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+        BufferHandle c = dev->create_buffer(bytes, BufferAccess::ReadWrite);
+        BufferHandle d = dev->create_buffer(bytes, BufferAccess::WriteOnly);
+        BufferHandle e = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+        dev->bind_kernel_args("wide_vadd", KernelArgs().set(0, a).set(1, b).set(2, c));
+        dev->bind_kernel_args("wide_vadd", KernelArgs().set(0, e).set(1, b).set(2, d));
+
+        uint32_t *a_ptr = (uint32_t *)a->host_ptr();
+        uint32_t *b_ptr = (uint32_t *)b->host_ptr();
+        uint32_t *e_ptr = (uint32_t *)e->host_ptr();
+        for (size_t i = 0; i < TOTAL_ELEMS; i++) {
+            a_ptr[i] = (uint32_t)i;
+            b_ptr[i] = (uint32_t)(2 * i);
+            e_ptr[i] = (uint32_t)(4 * i);
+        }
+
+        // Make the buffers resident so neither run pays for first touch
+        dev->migrate({a, b, c, d, e}, MigrateDirection::ToDevice)->wait();
+
+        std::vector<Chunk> chunks(NUM_CHUNKS);
+        size_t chunk_bytes = CHUNK_ELEMS * sizeof(uint32_t);
+        for (size_t k = 0; k < NUM_CHUNKS; k++) {
+            chunks[k].a = dev->create_sub_buffer(a, k * chunk_bytes, chunk_bytes);
+            chunks[k].b = dev->create_sub_buffer(b, k * chunk_bytes, chunk_bytes);
+            chunks[k].c = dev->create_sub_buffer(c, k * chunk_bytes, chunk_bytes);
+            chunks[k].d = dev->create_sub_buffer(d, k * chunk_bytes, chunk_bytes);
+            chunks[k].e = dev->create_sub_buffer(e, k * chunk_bytes, chunk_bytes);
+        }
+        et.finish();
+
+        // The chunk's structure is recorded once; slots 0-4 are its a, b, c,
+        // d and e sub-buffers, and the size is fixed
+        et.add("Record and instantiate graph");
+        CommandGraph graph;
+        size_t to_dev    = graph.migrate({GraphSlot(0), GraphSlot(1), GraphSlot(4)}, MigrateDirection::ToDevice);
+        size_t add       = graph.task("wide_vadd",
+                                GraphArgs().set(0, GraphSlot(0)).set(1, GraphSlot(1)).set(2, GraphSlot(2)).set(3, (uint64_t)CHUNK_ELEMS),
+                                {to_dev});
+        size_t add_other = graph.task("wide_vadd",
+                                      GraphArgs().set(0, GraphSlot(4)).set(1, GraphSlot(1)).set(2, GraphSlot(3)).set(3, (uint64_t)CHUNK_ELEMS),
+                                      {to_dev});
+        graph.migrate({GraphSlot(2), GraphSlot(3)}, MigrateDirection::ToHost, {add, add_other});
+        GraphExec exec = graph.instantiate(*dev);
+        et.finish();
+
+        bool verified = true;
+
+        et.add("Hand-chained submission");
+        memset(c->host_ptr(), 0, bytes);
+        memset(d->host_ptr(), 0, bytes);
+        RunResult chained = run_hand_chained(*dev, chunks);
+        verified          = verify_results(c, d) && verified;
+        et.finish();
+
+        et.add("Graph replay");
+        memset(c->host_ptr(), 0, bytes);
+        memset(d->host_ptr(), 0, bytes);
+        RunResult replayed = run_graph(exec, chunks);
+        verified           = verify_results(c, d) && verified;
+        et.finish();
+
+        std::cout << std::left << std::setw(14) << "Mode" << std::right << std::setw(14) << "Submit (ms)"
+                  << std::setw(16) << "Per chunk (us)" << std::setw(14) << "Total (ms)" << std::endl;
+        print_row("Hand-chained", chained);
+        print_row("Graph replay", replayed);
+
+        if (!verified) {
+            std::cout << "ERROR: software and hardware vadd do not match" << std::endl;
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Command graph example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Command graph example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
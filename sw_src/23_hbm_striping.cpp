@@ -0,0 +1,248 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "striped_buffer.hpp"
+#include "verify.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define DEFAULT_MIB 128
+#define KERNEL_RUNS 5
+
+// The single-channel wide_vadd baseline puts each operand on one U50 HBM
+// pseudo-channel, which holds 256 MiB
+#define MAX_MIB 256
+
+using namespace xilinx::example_utils;
+
+static void fill_inputs(uint32_t *a, uint32_t *b, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        a[i] = (uint32_t)i;
+        b[i] = (uint32_t)(2 * i);
+    }
+}
+
+static bool check_output(const uint32_t *c, size_t count)
+{
+    VerifyResult vr = verify_buffer(c, count, vadd_expected);
+    if (!vr.ok()) {
+        print_verify_result(std::cout, vr);
+    }
+    return vr.ok();
+}
+
+// Best of KERNEL_RUNS runs with the data already resident on the card, so
+// only the kernel's memory traffic is timed
+static double best_kernel_ms(cl::CommandQueue &q, cl::Kernel &krnl)
+{
+    double best = 0.0;
+    for (int r = 0; r < KERNEL_RUNS; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        q.enqueueTask(krnl);
+        q.finish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if (r == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+static void print_row(const char *mode, size_t bytes, double ms)
+{
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(28) << mode << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << ms
+              << std::setw(12) << (3.0 * bytes / 1.0e6) / ms << std::endl;
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    size_t mib = DEFAULT_MIB;
+    if (argc > 1) {
+        mib = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2 || mib == 0 || mib > MAX_MIB) {
+        std::cout << "Usage: 23_hbm_striping [MiB per vector, at most " << MAX_MIB << "]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t bytes = mib * 1024 * 1024;
+    size_t count = bytes / sizeof(uint32_t);
+
+    std::cout << "-- Example 23: HBM Pseudo-Channel Striping --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    try {
+        bool verified = true;
+        std::cout << std::left << std::setw(28) << "Mode" << std::right << std::setw(12) << "Kernel (ms)"
+                  << std::setw(12) << "GB/s" << std::endl;
+
+        // Baseline: one pseudo-channel per operand
+        {
+            et.add("Allocate and populate single-channel buffers");
+            cl::Buffer a = xocl.create_buffer(bytes, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+            cl::Buffer b = xocl.create_buffer(bytes, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+            cl::Buffer c = xocl.create_buffer(bytes, CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR);
+
+            // We set the kernel args before mapping the buffers to allow the
+            // runtime to determine external memory connectivity
+            krnl.setArg(0, a);
+            krnl.setArg(1, b);
+            krnl.setArg(2, c);
+            krnl.setArg(3, (uint64_t)count);
+
+            uint32_t *a_ptr = (uint32_t *)q.enqueueMapBuffer(a, CL_TRUE, CL_MAP_WRITE, 0, bytes);
+            uint32_t *b_ptr = (uint32_t *)q.enqueueMapBuffer(b, CL_TRUE, CL_MAP_WRITE, 0, bytes);
+            fill_inputs(a_ptr, b_ptr, count);
+            q.enqueueUnmapMemObject(a, a_ptr);
+            q.enqueueUnmapMemObject(b, b_ptr);
+            q.enqueueMigrateMemObjects({a, b, c}, 0);
+            q.finish();
+            et.finish();
+
+            et.add("wide_vadd, single channel");
+            double ms = best_kernel_ms(q, krnl);
+            et.finish();
+
+            q.enqueueMigrateMemObjects({c}, CL_MIGRATE_MEM_OBJECT_HOST);
+            uint32_t *c_ptr = (uint32_t *)q.enqueueMapBuffer(c, CL_TRUE, CL_MAP_READ, 0, bytes);
+            verified        = check_output(c_ptr, count) && verified;
+            q.enqueueUnmapMemObject(c, c_ptr);
+            q.finish();
+
+            print_row("wide_vadd, 1 channel/port", bytes, ms);
+        }
+
+        // Striped: STRIPED_VADD_STRIPES pseudo-channels per operand. The
+        // kernel is only linked into the U50 build.
+        cl::Kernel striped;
+        try {
+            striped = xocl.get_kernel("striped_vadd");
+        }
+        catch (cl::Error &e) {
+            std::cout << "striped_vadd is not in this xclbin; it is only built for HBM (U50) platforms"
+                      << std::endl;
+        }
+
+        if (striped()) {
+            et.add("Allocate and populate striped buffers");
+            StripedBuffer a(xocl, bytes, STRIPED_VADD_STRIPES, CL_MEM_READ_ONLY);
+            StripedBuffer b(xocl, bytes, STRIPED_VADD_STRIPES, CL_MEM_READ_ONLY);
+            StripedBuffer c(xocl, bytes, STRIPED_VADD_STRIPES, CL_MEM_WRITE_ONLY);
+
+            // Arguments are in1 stripes, in2 stripes, out stripes, size and
+            // stripe size
+            a.bind(striped, 0);
+            b.bind(striped, STRIPED_VADD_STRIPES);
+            c.bind(striped, 2 * STRIPED_VADD_STRIPES);
+            striped.setArg(3 * STRIPED_VADD_STRIPES, (uint64_t)count);
+            striped.setArg(3 * STRIPED_VADD_STRIPES + 1, (uint64_t)(a.stripe_bytes() / sizeof(uint32_t)));
+
+            // The host sees each operand as one linear array
+            fill_inputs((uint32_t *)a.data(), (uint32_t *)b.data(), count);
+
+            std::vector<cl::Memory> to_device = a.memory_objects();
+            std::vector<cl::Memory> b_stripes = b.memory_objects();
+            std::vector<cl::Memory> c_stripes = c.memory_objects();
+            to_device.insert(to_device.end(), b_stripes.begin(), b_stripes.end());
+            to_device.insert(to_device.end(), c_stripes.begin(), c_stripes.end());
+            q.enqueueMigrateMemObjects(to_device, 0);
+            q.finish();
+            et.finish();
+
+            et.add("striped_vadd");
+            double ms = best_kernel_ms(q, striped);
+            et.finish();
+
+            q.enqueueMigrateMemObjects(c_stripes, CL_MIGRATE_MEM_OBJECT_HOST);
+            q.finish();
+            verified = check_output((const uint32_t *)c.data(), count) && verified;
+
+            std::string label = "striped_vadd, " + std::to_string(STRIPED_VADD_STRIPES) + " channels/port";
+            print_row(label.c_str(), bytes, ms);
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "HBM striping example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "ERROR: hardware vadd results did not match"
+                << std::endl
+                << "HBM striping example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,275 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "device_buffer.hpp"
+#include "verify.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define BUFSIZE (1024 * 1024 * 16)
+#define DEFAULT_STEPS 200
+#define DEFAULT_STEPS_PER_EPOCH 20
+
+using namespace xilinx::example_utils;
+
+// A model of an iterative workload: 'a' holds weights that never change,
+// the host updates 'b' once per epoch and inspects 'c' at the end of each
+// epoch, and every step runs the kernel c = a + b.
+//
+// In epoch e, b[i] = 2i + e, so c[i] = 3i + e.
+
+static bool check_epoch(const uint32_t *c, size_t count, unsigned int epoch)
+{
+    VerifyResult vr = verify_buffer(c, count, [epoch](size_t first, size_t n, uint32_t *out) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = (uint32_t)(3 * (first + i) + epoch);
+        }
+    });
+    if (!vr.ok()) {
+        std::cout << "Epoch " << epoch << ": ";
+        print_verify_result(std::cout, vr);
+    }
+    return vr.ok();
+}
+
+static void fill_b(uint32_t *b, size_t count, unsigned int epoch)
+{
+    for (size_t i = 0; i < count; i++) {
+        b[i] = (uint32_t)(2 * i + epoch);
+    }
+}
+
+// What examples 03-05 do by hand: with nothing recording which side holds
+// current data, every step migrates all inputs to the card and the output back
+static bool run_untracked(XilinxOclHelper &xocl,
+                          cl::CommandQueue &q,
+                          cl::Kernel &krnl,
+                          size_t count,
+                          unsigned int steps,
+                          unsigned int steps_per_epoch,
+                          size_t &migrated)
+{
+    size_t size      = count * sizeof(uint32_t);
+    cl::Buffer a_buf = xocl.create_buffer(size, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+    cl::Buffer b_buf = xocl.create_buffer(size, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+    cl::Buffer c_buf = xocl.create_buffer(size, CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR);
+    krnl.setArg(0, a_buf);
+    krnl.setArg(1, b_buf);
+    krnl.setArg(2, c_buf);
+    krnl.setArg(3, (uint64_t)count);
+
+    uint32_t *a = (uint32_t *)q.enqueueMapBuffer(a_buf, CL_TRUE, CL_MAP_WRITE, 0, size);
+    uint32_t *b = (uint32_t *)q.enqueueMapBuffer(b_buf, CL_TRUE, CL_MAP_WRITE, 0, size);
+    uint32_t *c = (uint32_t *)q.enqueueMapBuffer(c_buf, CL_TRUE, CL_MAP_READ, 0, size);
+    for (size_t i = 0; i < count; i++) {
+        a[i] = (uint32_t)i;
+    }
+
+    bool verified = true;
+    migrated      = 0;
+    for (unsigned int step = 0; step < steps; step++) {
+        unsigned int epoch = step / steps_per_epoch;
+        if (step % steps_per_epoch == 0) {
+            fill_b(b, count, epoch);
+        }
+
+        q.enqueueMigrateMemObjects({a_buf, b_buf}, 0);
+        q.enqueueTask(krnl);
+        q.enqueueMigrateMemObjects({c_buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+        q.finish();
+        migrated += 3 * size;
+
+        if (step % steps_per_epoch == steps_per_epoch - 1 || step == steps - 1) {
+            verified = check_epoch(c, count, epoch) && verified;
+        }
+    }
+
+    q.enqueueUnmapMemObject(a_buf, a);
+    q.enqueueUnmapMemObject(b_buf, b);
+    q.enqueueUnmapMemObject(c_buf, c);
+    q.finish();
+    return verified;
+}
+
+// The same workload with DeviceBuffer deciding what has to move
+static bool run_tracked(XilinxOclHelper &xocl,
+                        cl::CommandQueue &q,
+                        cl::Kernel &krnl,
+                        size_t count,
+                        unsigned int steps,
+                        unsigned int steps_per_epoch,
+                        size_t &migrated)
+{
+    DeviceBuffer<uint32_t> a(xocl, q, count, BufferAccess::ReadOnly);
+    DeviceBuffer<uint32_t> b(xocl, q, count, BufferAccess::ReadOnly);
+    DeviceBuffer<uint32_t> c(xocl, q, count, BufferAccess::WriteOnly);
+    a.bind(krnl, 0);
+    b.bind(krnl, 1);
+    c.bind(krnl, 2);
+    krnl.setArg(3, (uint64_t)count);
+
+    HostSpan<uint32_t> weights = a.host(HostAccess::Write);
+    for (size_t i = 0; i < weights.size(); i++) {
+        weights[i] = (uint32_t)i;
+    }
+
+    bool verified = true;
+    for (unsigned int step = 0; step < steps; step++) {
+        unsigned int epoch = step / steps_per_epoch;
+        if (step % steps_per_epoch == 0) {
+            fill_b(b.host(HostAccess::Write).data(), count, epoch);
+        }
+
+        // Only the first step uploads 'a', only the first step of an epoch
+        // uploads 'b', and 'c' is placed once without any data
+        a.to_device();
+        b.to_device();
+        c.to_device();
+        q.enqueueTask(krnl);
+        c.device_written();
+
+        if (step % steps_per_epoch == steps_per_epoch - 1 || step == steps - 1) {
+            verified = check_epoch(c.host(HostAccess::Read).data(), count, epoch) && verified;
+        }
+    }
+    q.finish();
+
+    migrated = a.get_migrated_bytes() + b.get_migrated_bytes() + c.get_migrated_bytes();
+    return verified;
+}
+
+static void print_row(const char *mode, double ms, size_t migrated)
+{
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(14) << mode << std::right << std::fixed << std::setprecision(2)
+              << std::setw(14) << ms
+              << std::setw(16) << migrated / (1024.0 * 1024.0) << std::endl;
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    unsigned int steps           = DEFAULT_STEPS;
+    unsigned int steps_per_epoch = DEFAULT_STEPS_PER_EPOCH;
+    if (argc > 1) {
+        steps = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        steps_per_epoch = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3 || steps == 0 || steps_per_epoch == 0) {
+        std::cout << "Usage: 24_residency_tracking [steps] [steps per epoch]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t count = BUFSIZE / sizeof(uint32_t);
+
+    std::cout << "-- Example 24: Buffer Residency Tracking --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    try {
+        std::cout << "Running " << steps << " steps of " << BUFSIZE / (1024 * 1024)
+                  << " MiB, the host changing 'b' and reading 'c' every " << steps_per_epoch
+                  << " steps" << std::endl
+                  << std::endl;
+
+        size_t untracked_bytes = 0;
+        et.add("Untracked buffers");
+        auto start          = std::chrono::high_resolution_clock::now();
+        bool verified       = run_untracked(xocl, q, krnl, count, steps, steps_per_epoch, untracked_bytes);
+        double untracked_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        et.finish();
+
+        size_t tracked_bytes = 0;
+        et.add("DeviceBuffer residency tracking");
+        start             = std::chrono::high_resolution_clock::now();
+        verified          = run_tracked(xocl, q, krnl, count, steps, steps_per_epoch, tracked_bytes) && verified;
+        double tracked_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        et.finish();
+
+        std::cout << std::left << std::setw(14) << "Mode" << std::right << std::setw(14) << "Total (ms)"
+                  << std::setw(16) << "Migrated (MiB)" << std::endl;
+        print_row("Untracked", untracked_ms, untracked_bytes);
+        print_row("Tracked", tracked_ms, tracked_bytes);
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Residency tracking example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "ERROR: hardware vadd results did not match"
+                << std::endl
+                << "Residency tracking example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
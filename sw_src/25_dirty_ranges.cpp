@@ -0,0 +1,232 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "device_buffer.hpp"
+#include "verify.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define DEFAULT_VECTOR_MIB 256
+#define DEFAULT_UPDATE_MIB 4
+#define UPDATES_PER_STEP 64
+#define NUM_STEPS 20
+
+using namespace xilinx::example_utils;
+
+struct RunStats
+{
+    double upload_ms;
+    size_t uploaded;
+    bool verified;
+};
+
+// Builds c = a + b once, then for NUM_STEPS steps scatters UPDATES_PER_STEP
+// small in-place updates over 'b', uploads it and reruns the kernel. With
+// 'track_ranges' the updates go through host_range(); without it the whole
+// of 'b' is marked stale, as when the examples re-migrate b_buf.
+static RunStats run_updates(XilinxOclHelper &xocl,
+                            cl::CommandQueue &q,
+                            cl::Kernel &krnl,
+                            size_t count,
+                            size_t update_elems,
+                            bool track_ranges)
+{
+    DeviceBuffer<uint32_t> a(xocl, q, count, BufferAccess::ReadOnly);
+    DeviceBuffer<uint32_t> b(xocl, q, count, BufferAccess::ReadOnly);
+    DeviceBuffer<uint32_t> c(xocl, q, count, BufferAccess::WriteOnly);
+    a.bind(krnl, 0);
+    b.bind(krnl, 1);
+    c.bind(krnl, 2);
+    krnl.setArg(3, (uint64_t)count);
+
+    HostSpan<uint32_t> a_host = a.host(HostAccess::Write);
+    HostSpan<uint32_t> b_host = b.host(HostAccess::Write);
+    for (size_t i = 0; i < count; i++) {
+        a_host[i] = (uint32_t)i;
+        b_host[i] = (uint32_t)(2 * i);
+    }
+    a.to_device();
+    b.to_device();
+    c.to_device();
+    q.enqueueTask(krnl);
+    c.device_written();
+    q.finish();
+
+    RunStats stats;
+    stats.upload_ms = 0.0;
+    size_t initial  = b.get_migrated_bytes();
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> where(0, count - update_elems);
+
+    for (unsigned int step = 0; step < NUM_STEPS; step++) {
+        for (unsigned int u = 0; u < UPDATES_PER_STEP; u++) {
+            size_t first = where(rng);
+            HostSpan<uint32_t> upd = track_ranges ? b.host_range(first, update_elems)
+                                                  : HostSpan<uint32_t>(b.host(HostAccess::ReadWrite).data() + first, update_elems);
+            for (auto &v : upd) {
+                v += step + 1;
+            }
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        b.to_device();
+        q.finish();
+        stats.upload_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        c.to_device();
+        q.enqueueTask(krnl);
+        c.device_written();
+    }
+    stats.uploaded = b.get_migrated_bytes() - initial;
+
+    // Checked against the host copies, which hold every update
+    const uint32_t *a_ptr = a.host(HostAccess::Read).data();
+    const uint32_t *b_ptr = b.host(HostAccess::Read).data();
+    auto expected         = [a_ptr, b_ptr](size_t first, size_t n, uint32_t *out) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = a_ptr[first + i] + b_ptr[first + i];
+        }
+    };
+    VerifyResult vr = verify_buffer(c.host(HostAccess::Read).data(), count, expected);
+    if (!vr.ok()) {
+        print_verify_result(std::cout, vr);
+    }
+    stats.verified = vr.ok();
+    return stats;
+}
+
+static void print_row(const char *mode, const RunStats &stats)
+{
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(16) << mode << std::right << std::fixed << std::setprecision(2)
+              << std::setw(16) << stats.upload_ms / NUM_STEPS
+              << std::setw(18) << stats.uploaded / (1024.0 * 1024.0 * NUM_STEPS) << std::endl;
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    size_t vector_mib = DEFAULT_VECTOR_MIB;
+    size_t update_mib = DEFAULT_UPDATE_MIB;
+    if (argc > 1) {
+        vector_mib = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        update_mib = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3 || vector_mib == 0 || update_mib == 0 || update_mib > vector_mib || vector_mib > 4095) {
+        std::cout << "Usage: 25_dirty_ranges [MiB per vector, below 4096] [MiB updated per step]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t count        = vector_mib * 1024 * 1024 / sizeof(uint32_t);
+    size_t update_elems = update_mib * 1024 * 1024 / sizeof(uint32_t) / UPDATES_PER_STEP;
+    if (update_elems == 0) {
+        update_elems = 1;
+    }
+
+    std::cout << "-- Example 25: Dirty-Range Migration --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue(true);
+    cl::Kernel krnl    = xocl.get_kernel("wide_vadd");
+    et.finish();
+
+    try {
+        std::cout << "Updating " << update_mib << " MiB of a " << vector_mib << " MiB vector in "
+                  << UPDATES_PER_STEP << " places per step, " << NUM_STEPS << " steps" << std::endl
+                  << std::endl;
+
+        et.add("Whole-buffer migration");
+        RunStats whole = run_updates(xocl, q, krnl, count, update_elems, false);
+        et.finish();
+
+        et.add("Dirty-range migration");
+        RunStats ranges = run_updates(xocl, q, krnl, count, update_elems, true);
+        et.finish();
+
+        std::cout << std::left << std::setw(16) << "Mode" << std::right << std::setw(16) << "Upload (ms)"
+                  << std::setw(18) << "Uploaded (MiB)" << std::endl;
+        print_row("Whole buffer", whole);
+        print_row("Dirty ranges", ranges);
+        std::cout << "(per step)" << std::endl;
+
+        bool verified = whole.verified && ranges.verified;
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Dirty-range migration example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "ERROR: hardware vadd results did not match"
+                << std::endl
+                << "Dirty-range migration example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,501 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "host_memory.hpp"
+#include "verify.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define NUM_ITERATIONS 5
+#define MAX_PROBE_UNITS 4
+#define PROBE_BUFSIZE (64 * 1024 * 1024)
+#define VADD_BUFSIZE (64 * 1024 * 1024)
+#define MAX_MIGRATE_BYTES (64 * 1024 * 1024)
+
+// Each small transfer is repeated until at least this much has moved, so the
+// rate reflects per-migration overhead rather than timer resolution
+#define MIN_BYTES_PER_SAMPLE (16 * 1024 * 1024)
+
+// Modes of hw_src/bandwidth.cpp
+#define BANDWIDTH_READ 0
+#define BANDWIDTH_WRITE 1
+#define BANDWIDTH_COPY 2
+
+using namespace xilinx::example_utils;
+
+enum class HostBufferKind {
+    UseHostPtr,
+    AllocHostPtr,
+    BankPinned
+};
+
+static const char *kind_name(HostBufferKind kind)
+{
+    switch (kind) {
+    case HostBufferKind::UseHostPtr:
+        return "USE_HOST_PTR";
+    case HostBufferKind::AllocHostPtr:
+        return "ALLOC_HOST_PTR";
+    default:
+        return "bank 0 pinned";
+    }
+}
+
+// A buffer of one of the kinds under test, freeing its host memory on
+// destruction when it owns any
+class TestBuffer
+{
+private:
+    void *host;
+    size_t size;
+    HostAllocPolicy policy;
+
+public:
+    cl::Buffer buf;
+
+    TestBuffer(XilinxOclHelper &xocl, HostBufferKind kind, size_t size) : host(nullptr), size(size)
+    {
+        if (kind == HostBufferKind::UseHostPtr) {
+            host = host_alloc(size, policy);
+            memset(host, 0, size);
+            buf = xocl.create_buffer_from_host_ptr(host, size, CL_MEM_READ_WRITE);
+        }
+        else if (kind == HostBufferKind::AllocHostPtr) {
+            buf = xocl.create_buffer(size, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR);
+        }
+        else {
+            buf = xocl.create_buffer_in_bank(0, size, CL_MEM_READ_WRITE);
+        }
+    }
+
+    ~TestBuffer()
+    {
+        buf = cl::Buffer();
+        if (host != nullptr) {
+            host_free(host, size, policy);
+        }
+    }
+
+    TestBuffer(const TestBuffer &) = delete;
+    TestBuffer &operator=(const TestBuffer &) = delete;
+};
+
+static double ms_since(std::chrono::high_resolution_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> d = std::chrono::high_resolution_clock::now() - start;
+    return d.count();
+}
+
+static double gbps(size_t bytes, double ms)
+{
+    return (bytes / 1.0e6) / ms;
+}
+
+// Best of NUM_ITERATIONS samples of 'fn', which moves 'bytes' per call, in
+// GB/s. Each sample repeats 'fn' enough times to move MIN_BYTES_PER_SAMPLE.
+template <typename F>
+static double best_rate(cl::CommandQueue &q, size_t bytes, F fn)
+{
+    size_t reps = std::max<size_t>(1, MIN_BYTES_PER_SAMPLE / bytes);
+    double best = 0.0;
+    for (int i = 0; i < NUM_ITERATIONS; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t r = 0; r < reps; r++) {
+            fn();
+        }
+        q.finish();
+        best = std::max(best, gbps(bytes * reps, ms_since(start)));
+    }
+    return best;
+}
+
+struct PcieRates
+{
+    double h2d, d2h, bidir;
+};
+
+static PcieRates measure_pcie(XilinxOclHelper &xocl, cl::CommandQueue &q, HostBufferKind kind, size_t size)
+{
+    TestBuffer x(xocl, kind, size);
+    TestBuffer y(xocl, kind, size);
+
+    // Make both resident so the first timed migration does not include the
+    // device allocation
+    q.enqueueMigrateMemObjects({x.buf, y.buf}, 0);
+    q.finish();
+
+    PcieRates rates;
+    rates.h2d = best_rate(q, size, [&]() {
+        q.enqueueMigrateMemObjects({x.buf}, 0);
+    });
+    rates.d2h = best_rate(q, size, [&]() {
+        q.enqueueMigrateMemObjects({x.buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+    });
+
+    // The queue is out of order, so the two directions overlap
+    rates.bidir = best_rate(q, 2 * size, [&]() {
+        q.enqueueMigrateMemObjects({x.buf}, 0);
+        q.enqueueMigrateMemObjects({y.buf}, CL_MIGRATE_MEM_OBJECT_HOST);
+    });
+    return rates;
+}
+
+struct BankRates
+{
+    std::string unit;
+    double read, write, copy;
+};
+
+// Runs every mode of one bandwidth compute unit against its own bank
+static BankRates measure_bank(XilinxOclHelper &xocl, cl::CommandQueue &q, cl::Kernel &krnl, const std::string &unit)
+{
+    cl::Buffer in  = xocl.create_buffer(PROBE_BUFSIZE, CL_MEM_READ_WRITE);
+    cl::Buffer out = xocl.create_buffer(PROBE_BUFSIZE, CL_MEM_READ_WRITE);
+
+    // We set the kernel args before migrating so the buffers are allocated
+    // in the bank this unit is connected to
+    krnl.setArg(0, in);
+    krnl.setArg(1, out);
+    krnl.setArg(2, (unsigned long long)(PROBE_BUFSIZE / 64));
+    q.enqueueMigrateMemObjects({in, out}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED);
+    q.finish();
+
+    BankRates rates;
+    rates.unit = unit;
+
+    krnl.setArg(3, BANDWIDTH_READ);
+    rates.read = best_rate(q, PROBE_BUFSIZE, [&]() {
+        q.enqueueTask(krnl);
+    });
+    krnl.setArg(3, BANDWIDTH_WRITE);
+    rates.write = best_rate(q, PROBE_BUFSIZE, [&]() {
+        q.enqueueTask(krnl);
+    });
+    krnl.setArg(3, BANDWIDTH_COPY);
+    rates.copy = best_rate(q, 2 * PROBE_BUFSIZE, [&]() {
+        q.enqueueTask(krnl);
+    });
+    return rates;
+}
+
+// An achieved throughput to place against one of the measured ceilings
+struct RooflinePoint
+{
+    std::string name;
+    std::string ceiling;
+    double rate;
+};
+
+// Measures wide_vadd, which moves three vectors per run, on its own and with
+// the migrations of example 04
+static bool measure_wide_vadd(XilinxOclHelper &xocl, cl::CommandQueue &q, std::vector<RooflinePoint> &points)
+{
+    size_t count = VADD_BUFSIZE / sizeof(uint32_t);
+
+    cl::Kernel krnl = xocl.get_kernel("wide_vadd");
+    cl::Buffer a    = xocl.create_buffer(VADD_BUFSIZE, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+    cl::Buffer b    = xocl.create_buffer(VADD_BUFSIZE, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+    cl::Buffer c    = xocl.create_buffer(VADD_BUFSIZE, CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR);
+    krnl.setArg(0, a);
+    krnl.setArg(1, b);
+    krnl.setArg(2, c);
+    krnl.setArg(3, (uint64_t)count);
+
+    uint32_t *a_ptr = (uint32_t *)q.enqueueMapBuffer(a, CL_TRUE, CL_MAP_WRITE, 0, VADD_BUFSIZE);
+    uint32_t *b_ptr = (uint32_t *)q.enqueueMapBuffer(b, CL_TRUE, CL_MAP_WRITE, 0, VADD_BUFSIZE);
+    for (size_t i = 0; i < count; i++) {
+        a_ptr[i] = (uint32_t)i;
+        b_ptr[i] = (uint32_t)(2 * i);
+    }
+    q.enqueueUnmapMemObject(a, a_ptr);
+    q.enqueueUnmapMemObject(b, b_ptr);
+    q.finish();
+    q.enqueueMigrateMemObjects({a, b, c}, 0);
+    q.finish();
+
+    double kernel = best_rate(q, 3 * VADD_BUFSIZE, [&]() {
+        q.enqueueTask(krnl);
+    });
+
+    // Inputs up and results down, each step (and each run) waiting for the
+    // one before, as in example 04
+    std::vector<cl::Event> prev;
+    double end_to_end = best_rate(q, 3 * VADD_BUFSIZE, [&]() {
+        cl::Event up, run, down;
+        q.enqueueMigrateMemObjects({a, b}, 0, prev.empty() ? nullptr : &prev, &up);
+        std::vector<cl::Event> after_up = {up};
+        q.enqueueTask(krnl, &after_up, &run);
+        std::vector<cl::Event> after_run = {run};
+        q.enqueueMigrateMemObjects({c}, CL_MIGRATE_MEM_OBJECT_HOST, &after_run, &down);
+        prev = {down};
+    });
+
+    // wide_vadd reads two vectors and writes one, so a bank's copy rate is
+    // its ceiling. On platforms where its ports span two banks it can exceed
+    // a single bank's rate.
+    points.push_back({"wide_vadd, kernel only", "copy", kernel});
+    points.push_back({"wide_vadd, with migrations", "bidir", end_to_end});
+
+    uint32_t *c_ptr = (uint32_t *)q.enqueueMapBuffer(c, CL_TRUE, CL_MAP_READ, 0, VADD_BUFSIZE);
+    VerifyResult vr = verify_buffer(c_ptr, count, vadd_expected);
+    q.enqueueUnmapMemObject(c, c_ptr);
+    q.finish();
+    if (!vr.ok()) {
+        print_verify_result(std::cout, vr);
+    }
+    return vr.ok();
+}
+
+static void print_size(size_t size)
+{
+    if (size >= 1024 * 1024) {
+        std::cout << std::setw(7) << size / (1024 * 1024) << " MiB";
+    }
+    else {
+        std::cout << std::setw(7) << size / 1024 << " KiB";
+    }
+}
+
+static const char *ceiling_name(const std::string &ceiling)
+{
+    if (ceiling == "h2d") {
+        return "PCIe host to card";
+    }
+    if (ceiling == "d2h") {
+        return "PCIe card to host";
+    }
+    if (ceiling == "bidir") {
+        return "PCIe bidirectional";
+    }
+    if (ceiling == "read") {
+        return "Bank read";
+    }
+    if (ceiling == "write") {
+        return "Bank write";
+    }
+    return "Bank copy";
+}
+
+static void print_roofline(const std::map<std::string, double> &ceilings, const std::vector<RooflinePoint> &points)
+{
+    const int bar_width = 40;
+
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::cout << "Measured ceilings" << std::endl;
+    for (const char *c : {"h2d", "d2h", "bidir", "read", "write", "copy"}) {
+        auto it = ceilings.find(c);
+        if (it != ceilings.end()) {
+            std::cout << "  " << std::left << std::setw(22) << ceiling_name(c) << std::right
+                      << std::setw(10) << it->second << " GB/s" << std::endl;
+        }
+    }
+    std::cout << std::endl;
+
+    std::cout << std::left << std::setw(30) << "Workload" << std::setw(22) << "Ceiling" << std::right
+              << std::setw(10) << "GB/s" << std::setw(8) << "%" << std::endl;
+    for (auto &p : points) {
+        auto it = ceilings.find(p.ceiling);
+        if (it == ceilings.end() || it->second <= 0.0) {
+            std::cout << std::left << std::setw(30) << p.name << "no '" << p.ceiling
+                      << "' ceiling was measured" << std::right << std::endl;
+            continue;
+        }
+
+        double fraction = p.rate / it->second;
+        int filled      = (int)(std::min(fraction, 1.0) * bar_width + 0.5);
+        std::cout << std::left << std::setw(30) << p.name << std::setw(22) << ceiling_name(p.ceiling) << std::right
+                  << std::setw(10) << p.rate << std::setw(8) << 100.0 * fraction << "  |"
+                  << std::string(filled, '#') << std::string(bar_width - filled, ' ') << "|"
+                  << (fraction >= 0.8 ? " bound by this ceiling" : "") << std::endl;
+    }
+    std::cout.flags(flags);
+}
+
+static bool parse_point(const std::string &arg, RooflinePoint &point)
+{
+    size_t first  = arg.find(':');
+    size_t second = arg.find(':', first == std::string::npos ? first : first + 1);
+    if (first == std::string::npos || second == std::string::npos) {
+        return false;
+    }
+    point.name    = arg.substr(0, first);
+    point.ceiling = arg.substr(first + 1, second - first - 1);
+    point.rate    = strtod(arg.c_str() + second + 1, NULL);
+
+    const std::vector<std::string> known = {"h2d", "d2h", "bidir", "read", "write", "copy"};
+    return !point.name.empty() && point.rate > 0.0 &&
+           std::find(known.begin(), known.end(), point.ceiling) != known.end();
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    // Results reported by other examples can be added to the report
+    std::vector<RooflinePoint> points;
+    for (int i = 1; i < argc; i++) {
+        RooflinePoint point;
+        if (strcmp(argv[i], "--point") != 0 || i + 1 >= argc || !parse_point(argv[i + 1], point)) {
+            std::cout << "Usage: 26_bandwidth_suite [--point name:ceiling:GB/s]..." << std::endl
+                      << "       ceiling is one of h2d, d2h, bidir, read, write, copy" << std::endl;
+            return EXIT_FAILURE;
+        }
+        points.push_back(point);
+        i++;
+    }
+
+    std::cout << "-- Example 26: PCIe and Device Memory Bandwidth --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime (including a command queue) and load the
+    // FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::CommandQueue q = xocl.get_command_queue();
+    et.finish();
+
+    try {
+        std::map<std::string, double> ceilings;
+
+        et.add("PCIe migrations");
+        std::ios_base::fmtflags flags(std::cout.flags());
+        std::cout << std::left << std::setw(16) << "Buffer" << std::right << std::setw(11) << "Size"
+                  << std::setw(12) << "H2D GB/s" << std::setw(12) << "D2H GB/s"
+                  << std::setw(12) << "Both GB/s" << std::endl;
+        for (auto kind : {HostBufferKind::UseHostPtr, HostBufferKind::AllocHostPtr, HostBufferKind::BankPinned}) {
+            for (size_t size = 4 * 1024; size <= MAX_MIGRATE_BYTES; size *= 4) {
+                PcieRates rates = measure_pcie(xocl, q, kind, size);
+                std::cout << std::left << std::setw(16) << kind_name(kind) << std::right;
+                print_size(size);
+                std::cout << std::fixed << std::setprecision(2)
+                          << std::setw(12) << rates.h2d
+                          << std::setw(12) << rates.d2h
+                          << std::setw(12) << rates.bidir << std::endl;
+                ceilings["h2d"]   = std::max(ceilings["h2d"], rates.h2d);
+                ceilings["d2h"]   = std::max(ceilings["d2h"], rates.d2h);
+                ceilings["bidir"] = std::max(ceilings["bidir"], rates.bidir);
+            }
+        }
+        std::cout.flags(flags);
+        std::cout << std::endl;
+        et.finish();
+
+        // One bandwidth compute unit per bank; platforms link fewer or none
+        et.add("Device memory bandwidth kernels");
+        std::vector<BankRates> banks;
+        for (int k = 1; k <= MAX_PROBE_UNITS; k++) {
+            std::string unit = "bandwidth_" + std::to_string(k);
+            cl::Kernel krnl;
+            try {
+                krnl = xocl.get_kernel("bandwidth:{" + unit + "}");
+            }
+            catch (cl::Error &e) {
+                break;
+            }
+            banks.push_back(measure_bank(xocl, q, krnl, unit));
+        }
+        if (banks.empty()) {
+            std::cout << "No bandwidth compute units in this xclbin, skipping device memory" << std::endl
+                      << std::endl;
+        }
+        else {
+            flags = std::cout.flags();
+            std::cout << std::left << std::setw(16) << "Compute unit" << std::right << std::setw(12) << "Read GB/s"
+                      << std::setw(12) << "Write GB/s" << std::setw(12) << "Copy GB/s" << std::endl;
+            for (auto &b : banks) {
+                std::cout << std::left << std::setw(16) << b.unit << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(12) << b.read
+                          << std::setw(12) << b.write
+                          << std::setw(12) << b.copy << std::endl;
+                ceilings["read"]  = std::max(ceilings["read"], b.read);
+                ceilings["write"] = std::max(ceilings["write"], b.write);
+                ceilings["copy"]  = std::max(ceilings["copy"], b.copy);
+            }
+            std::cout.flags(flags);
+            std::cout << std::endl;
+        }
+        et.finish();
+
+        et.add("wide_vadd throughput");
+        bool verified = measure_wide_vadd(xocl, q, points);
+        et.finish();
+
+        print_roofline(ceilings, points);
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Bandwidth suite example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "ERROR: hardware vadd results did not match"
+                << std::endl
+                << "Bandwidth suite example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
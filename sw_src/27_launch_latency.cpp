@@ -0,0 +1,267 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Xilinx OpenCL and XRT includes
+#include "latency_histogram.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#define DEFAULT_ITERATIONS 5000
+#define WARMUP_ITERATIONS 100
+
+using namespace xilinx::example_utils;
+
+enum class CompletionMode {
+    Blocking, // clWaitForEvents
+    Callback, // CL_COMPLETE callback, recorded from the runtime's thread
+    Polling   // Spinning on CL_EVENT_COMMAND_EXECUTION_STATUS
+};
+
+static const char *mode_name(CompletionMode mode)
+{
+    switch (mode) {
+    case CompletionMode::Blocking:
+        return "blocking";
+    case CompletionMode::Callback:
+        return "callback";
+    default:
+        return "polling";
+    }
+}
+
+// The phases of one run of the nop kernel, from the event's profiling
+// timestamps and the host clock
+struct LatencyPhases
+{
+    std::string name;
+    LatencyHistogram queue_to_start; // CL_PROFILING_COMMAND_QUEUED to START
+    LatencyHistogram start_to_done;  // START to END
+    LatencyHistogram done_to_host;   // END to the host learning of it
+    LatencyHistogram total;          // enqueueTask() call to the host learning of it
+};
+
+struct CallbackState
+{
+    std::atomic<uint64_t> notified_ns;
+    std::atomic<bool> done;
+};
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static void CL_CALLBACK on_complete(cl_event, cl_int, void *data)
+{
+    auto *state = static_cast<CallbackState *>(data);
+    state->notified_ns.store(now_ns(), std::memory_order_relaxed);
+    state->done.store(true, std::memory_order_release);
+}
+
+// Runs the kernel once and returns the host time at which completion was
+// observed
+static uint64_t run_once(cl::CommandQueue &q, cl::Kernel &krnl, CompletionMode mode, cl::Event &event)
+{
+    CallbackState state;
+    state.done.store(false);
+
+    q.enqueueTask(krnl, nullptr, &event);
+    if (mode == CompletionMode::Blocking) {
+        event.wait();
+        return now_ns();
+    }
+    if (mode == CompletionMode::Callback) {
+        event.setCallback(CL_COMPLETE, on_complete, &state);
+        q.flush();
+
+        // Spin rather than sleep so only the runtime's notification path is
+        // measured, not this thread's wakeup
+        while (!state.done.load(std::memory_order_acquire)) {
+        }
+        return state.notified_ns.load(std::memory_order_relaxed);
+    }
+
+    q.flush();
+    while (true) {
+        cl_int status = event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>();
+        if (status == CL_COMPLETE) {
+            return now_ns();
+        }
+        if (status < 0) {
+            throw_lineexception("nop kernel failed with status " + std::to_string(status));
+        }
+    }
+}
+
+static void measure(cl::CommandQueue &q, cl::Kernel &krnl, CompletionMode mode, unsigned int iterations, LatencyPhases &phases)
+{
+    cl::Event event;
+    for (unsigned int i = 0; i < WARMUP_ITERATIONS; i++) {
+        krnl.setArg(0, i);
+        run_once(q, krnl, mode, event);
+    }
+
+    for (unsigned int i = 0; i < iterations; i++) {
+        krnl.setArg(0, i);
+        uint64_t enqueued = now_ns();
+        uint64_t notified = run_once(q, krnl, mode, event);
+
+        // Profiling timestamps share the host clock's rate but not
+        // necessarily its epoch, so only differences are compared
+        uint64_t queued = event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+        uint64_t start  = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        uint64_t end    = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+        uint64_t total  = notified - enqueued;
+        uint64_t device = end - queued;
+        phases.queue_to_start.record(start - queued);
+        phases.start_to_done.record(end - start);
+        phases.done_to_host.record(total > device ? total - device : 0);
+        phases.total.record(total);
+    }
+}
+
+static void print_summary(const std::vector<LatencyPhases> &results)
+{
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(24) << "Queue, completion" << std::setw(16) << "Phase" << std::right
+              << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "p99.9 us"
+              << std::setw(10) << "max us" << std::endl;
+    for (auto &r : results) {
+        const std::pair<const char *, const LatencyHistogram *> rows[] = {
+            {"queue to start", &r.queue_to_start},
+            {"start to done", &r.start_to_done},
+            {"done to host", &r.done_to_host},
+            {"total", &r.total}};
+        for (auto &row : rows) {
+            std::cout << std::left << std::setw(24) << (row.second == &r.queue_to_start ? r.name : "")
+                      << std::setw(16) << row.first << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << row.second->value_at_percentile(50.0) / 1000.0
+                      << std::setw(10) << row.second->value_at_percentile(99.0) / 1000.0
+                      << std::setw(10) << row.second->value_at_percentile(99.9) / 1000.0
+                      << std::setw(10) << row.second->max() / 1000.0 << std::endl;
+        }
+    }
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    unsigned int iterations = DEFAULT_ITERATIONS;
+    if (argc > 1) {
+        iterations = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2 || iterations == 0) {
+        std::cout << "Usage: 27_launch_latency [iterations per configuration]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "-- Example 27: Kernel Launch Latency --" << std::endl
+              << std::endl;
+
+    // Initialize the runtime and load the FPGA image
+    std::cout << "Loading alveo_examples.xclbin to program the Alveo board" << std::endl
+              << std::endl;
+    et.add("OpenCL Initialization");
+
+    // This application will use the first Xilinx device found in the system
+    XilinxOclHelper xocl;
+    xocl.initialize("alveo_examples.xclbin");
+
+    cl::Kernel krnl = xocl.get_kernel("nop");
+    et.finish();
+
+    try {
+        std::vector<LatencyPhases> results;
+        for (bool in_order : {true, false}) {
+            cl::CommandQueue q = xocl.get_command_queue(in_order, true);
+            for (auto mode : {CompletionMode::Blocking, CompletionMode::Callback, CompletionMode::Polling}) {
+                LatencyPhases phases;
+                phases.name = std::string(in_order ? "in-order" : "out-of-order") + ", " + mode_name(mode);
+
+                et.add("nop runs, " + phases.name);
+                measure(q, krnl, mode, iterations, phases);
+                et.finish();
+                results.push_back(std::move(phases));
+            }
+        }
+
+        for (auto &r : results) {
+            r.total.print(std::cout, "Total offload latency, " + r.name);
+            std::cout << std::endl;
+        }
+        print_summary(results);
+
+        // The cheapest way to reach the card bounds what any offload costs
+        auto best = std::min_element(results.begin(), results.end(), [](const LatencyPhases &a, const LatencyPhases &b) {
+            return a.total.value_at_percentile(50.0) < b.total.value_at_percentile(50.0);
+        });
+        std::ios_base::fmtflags flags(std::cout.flags());
+        std::cout << std::endl
+                  << std::fixed << std::setprecision(2)
+                  << "Offload floor (" << best->name << "): " << best->total.value_at_percentile(50.0) / 1000.0
+                  << " us median, " << best->total.value_at_percentile(99.0) / 1000.0 << " us p99" << std::endl
+                  << "Work that takes the host less than this, plus its transfer time, is not worth offloading"
+                  << std::endl;
+        std::cout.flags(flags);
+
+        std::cout
+            << std::endl
+            << "Launch latency example complete!"
+            << std::endl
+            << std::endl;
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+    }
+    catch (cl::Error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,330 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Runs on a card or, without one, on the CPU emulation backend
+#include "device_backend.hpp"
+#include "line_exception.hpp"
+#include "offload_client.hpp"
+#include "offload_server.hpp"
+
+#define DEFAULT_SOCKET "/tmp/alveo_offload.sock"
+
+#define NUM_CLIENTS 4
+#define VADD_JOBS 200
+#define VADD_DEPTH 8
+#define VADD_MAX_ELEMS (64 * 1024)
+#define VADD_SLOT_BYTES (3 * VADD_MAX_ELEMS * sizeof(uint32_t))
+
+#define RESIZE_JOBS 4
+#define WIDTH_IN 1920
+#define HEIGHT_IN 1080
+#define WIDTH_OUT 640
+#define HEIGHT_OUT 360
+#define RESIZE_IN_BYTES ((size_t)WIDTH_IN * HEIGHT_IN * 3)
+#define RESIZE_OUT_BYTES ((size_t)WIDTH_OUT * HEIGHT_OUT * 3)
+
+#define REGION_BYTES (VADD_DEPTH * VADD_SLOT_BYTES + RESIZE_IN_BYTES + RESIZE_OUT_BYTES)
+
+using namespace xilinx::example_utils;
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+{
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Programs the card, then serves clients until one asks it to stop. Writes
+// a byte to 'ready_fd', if given, once the device is up.
+static int run_daemon(int listen_fd, int ready_fd)
+{
+    try {
+        auto start                         = std::chrono::high_resolution_clock::now();
+        std::unique_ptr<DeviceBackend> dev = create_device_backend("alveo_examples.xclbin");
+        OffloadServer server(*dev, listen_fd);
+        std::cout << "[daemon] " << dev->name() << " backend ready in " << std::fixed << std::setprecision(1)
+                  << elapsed_ms(start) << " ms" << std::endl;
+
+        if (ready_fd >= 0) {
+            char c = 1;
+            if (write(ready_fd, &c, 1) != 1) {
+                throw_lineexception_errno("Unable to signal readiness", errno);
+            }
+            close(ready_fd);
+        }
+
+        server.run();
+        std::cout << std::endl
+                  << "[daemon] Per-client latency, request received to reply sent:" << std::endl;
+        server.print_stats(std::cout);
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception &e) {
+        std::cout << "[daemon] ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+static bool check_vadd(const uint32_t *c, uint64_t count, uint32_t seed)
+{
+    for (uint64_t i = 0; i < count; i++) {
+        if (c[i] != (uint32_t)(3 * i + seed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Ragged-length vadds, VADD_DEPTH in flight, then optionally a few resizes
+// of a flat-colour image, whose output must be the same colour
+static int run_client(const std::string &path, unsigned int id, bool with_resize)
+{
+    std::ostringstream out;
+    std::string name = "client" + std::to_string(id);
+    try {
+        auto start = std::chrono::high_resolution_clock::now();
+        OffloadClient client(path, name, REGION_BYTES);
+        double attach_ms = elapsed_ms(start);
+        uint8_t *region  = client.region();
+
+        bool verified = true;
+        uint64_t tags[VADD_DEPTH];
+        uint64_t counts[VADD_DEPTH];
+        uint32_t seeds[VADD_DEPTH];
+        unsigned int rng = 0x9e3779b9u * (id + 1);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned int j = 0; j < VADD_JOBS + VADD_DEPTH; j++) {
+            unsigned int k = j % VADD_DEPTH;
+            size_t a_off   = k * VADD_SLOT_BYTES;
+            size_t b_off   = a_off + VADD_MAX_ELEMS * sizeof(uint32_t);
+            size_t c_off   = b_off + VADD_MAX_ELEMS * sizeof(uint32_t);
+
+            // Retire the job that last used this slot before reusing it
+            if (j >= VADD_DEPTH) {
+                client.wait(tags[k]);
+                verified = check_vadd((const uint32_t *)(region + c_off), counts[k], seeds[k]) && verified;
+            }
+            if (j >= VADD_JOBS) {
+                continue;
+            }
+
+            rng         = rng * 1103515245u + 12345u;
+            counts[k]   = 1 + (rng >> 8) % VADD_MAX_ELEMS;
+            seeds[k]    = id * 1000 + j;
+            uint32_t *a = (uint32_t *)(region + a_off);
+            uint32_t *b = (uint32_t *)(region + b_off);
+            for (uint64_t i = 0; i < counts[k]; i++) {
+                a[i] = (uint32_t)(i + seeds[k]);
+                b[i] = (uint32_t)(2 * i);
+            }
+            tags[k] = client.submit_vadd(a_off, b_off, c_off, counts[k]);
+        }
+
+        if (with_resize) {
+            size_t in_off  = VADD_DEPTH * VADD_SLOT_BYTES;
+            size_t out_off = in_off + RESIZE_IN_BYTES;
+            for (unsigned int r = 0; r < RESIZE_JOBS; r++) {
+                uint8_t bgr[3] = {(uint8_t)(40 * id + r), 100, 200};
+                for (size_t p = 0; p < RESIZE_IN_BYTES; p++) {
+                    region[in_off + p] = bgr[p % 3];
+                }
+                client.wait(client.submit_resize(in_off, WIDTH_IN, HEIGHT_IN, out_off, WIDTH_OUT, HEIGHT_OUT));
+                for (size_t p = 0; p < RESIZE_OUT_BYTES; p++) {
+                    if (std::abs((int)region[out_off + p] - (int)bgr[p % 3]) > 1) {
+                        verified = false;
+                        break;
+                    }
+                }
+            }
+        }
+        double run_ms = elapsed_ms(start);
+
+        OffloadClientStats stats = client.get_stats();
+        out << "[" << name << "] pid " << getpid() << ": attach " << std::fixed << std::setprecision(1)
+            << attach_ms << " ms, " << stats.jobs << " jobs in " << run_ms << " ms, daemon p50 "
+            << stats.p50_us << " us, p99 " << stats.p99_us << " us"
+            << (verified ? "" : " -- results do not match") << std::endl;
+        std::cout << out.str() << std::flush;
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        out << "[" << name << "] ERROR: " << e.what() << std::endl;
+        std::cout << out.str() << std::flush;
+        return EXIT_FAILURE;
+    }
+}
+
+static bool wait_child(pid_t pid)
+{
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            throw_lineexception_errno("waitpid failed", errno);
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+static pid_t fork_child()
+{
+    // Keep buffered output from being printed once per process
+    std::cout << std::flush;
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw_lineexception_errno("fork failed", errno);
+    }
+    return pid;
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    std::string mode = argc > 1 ? argv[1] : "demo";
+    std::string path = argc > 2 ? argv[2] : DEFAULT_SOCKET;
+
+    // Standalone roles, for running the daemon and its clients from
+    // separate shells
+    try {
+        if (mode == "serve") {
+            return run_daemon(offload_listen(path), -1);
+        }
+        if (mode == "client") {
+            return run_client(path, getpid() % 1000, true);
+        }
+        if (mode == "stop") {
+            OffloadClient::shutdown_daemon(path);
+            return EXIT_SUCCESS;
+        }
+        if (mode != "demo") {
+            std::cout << "Usage: " << argv[0] << " [demo|serve|client|stop] [socket]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "-- Example 28: Shared Offload Daemon --" << std::endl
+              << std::endl;
+
+    try {
+        // The daemon programs the card once; the clients only attach
+        et.add("Start daemon");
+        int listen_fd = offload_listen(path);
+        int ready[2];
+        if (pipe(ready) != 0) {
+            throw_lineexception_errno("Unable to create pipe", errno);
+        }
+        pid_t daemon = fork_child();
+        if (daemon == 0) {
+            close(ready[0]);
+            _exit(run_daemon(listen_fd, ready[1]));
+        }
+        close(listen_fd);
+        close(ready[1]);
+        char c;
+        bool started = read(ready[0], &c, 1) == 1;
+        close(ready[0]);
+        if (!started) {
+            wait_child(daemon);
+            throw_lineexception("The daemon failed to start");
+        }
+        et.finish();
+
+        et.add("Run clients");
+        std::vector<pid_t> clients;
+        for (unsigned int id = 0; id < NUM_CLIENTS; id++) {
+            pid_t pid = fork_child();
+            if (pid == 0) {
+                _exit(run_client(path, id, id % 2 == 1));
+            }
+            clients.push_back(pid);
+        }
+        bool verified = true;
+        for (auto pid : clients) {
+            verified = wait_child(pid) && verified;
+        }
+        et.finish();
+
+        et.add("Stop daemon");
+        OffloadClient::shutdown_daemon(path);
+        verified = wait_child(daemon) && verified;
+        et.finish();
+
+        // What each client would have paid to own the device itself
+        et.add("Per-process backend initialization");
+        std::unique_ptr<DeviceBackend> dev = create_device_backend("alveo_examples.xclbin");
+        et.finish();
+
+        if (!verified) {
+            std::cout << "ERROR: offloaded results do not match" << std::endl;
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Offload daemon example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Offload daemon example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,340 @@
+/**********
+Copyright (c) 2020, Xilinx, Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+may be used to endorse or promote products derived from this software
+without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********/
+
+
+#include "event_timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Runs on a card or, without one, on the CPU emulation backend
+#include "deadline_scheduler.hpp"
+#include "device_backend.hpp"
+#include "verify.hpp"
+
+#define DEFAULT_BULK_MIB 32
+#define DEFAULT_CHUNK_KIB 1024
+
+// Bulk jobs are kept queued for the whole run, each outstanding job with
+// its own set of buffers
+#define BULK_OUTSTANDING 4
+
+// Critical requests arrive at a fixed rate, each with a deadline of a few
+// times the latency it gets on an idle device. The rate is capped at a
+// quarter of what an idle device could sustain, so misses come from
+// contention with bulk work rather than from overload.
+#define NUM_CRITICAL 40
+#define CRITICAL_PERIOD_US 5000
+#define CRITICAL_SLOTS 16
+#define CALIBRATION_JOBS 20
+#define SLO_FACTOR 3
+#define LOAD_FACTOR 4
+#define WIDTH_IN 480
+#define HEIGHT_IN 272
+#define WIDTH_OUT 240
+#define HEIGHT_OUT 136
+#define SIGMA 3.0f
+
+using namespace xilinx::example_utils;
+
+struct BulkSet
+{
+    BufferHandle a, b, c;
+};
+
+struct CriticalSlot
+{
+    BufferHandle in, out;
+};
+
+struct Workload
+{
+    uint64_t bulk_elems;
+    std::vector<BulkSet> bulk;
+    std::vector<CriticalSlot> critical;
+    std::vector<uint8_t> reference;
+};
+
+struct MixResult
+{
+    ClassStats critical;
+    uint64_t bulk_jobs = 0;
+    double bulk_gbps   = 0.0;
+};
+
+static JobStep resize_blur_step(const CriticalSlot &slot)
+{
+    BufferHandle in  = slot.in;
+    BufferHandle out = slot.out;
+    return [in, out](DeviceBackend &dev) {
+        KernelArgs args;
+        args.set(0, in).set(1, out).set(2, WIDTH_IN).set(3, HEIGHT_IN).set(4, WIDTH_OUT).set(5, HEIGHT_OUT).set(6, SIGMA);
+        EventHandle to_dev = dev.migrate({in}, MigrateDirection::ToDevice);
+        EventHandle run    = dev.run_kernel("resize_blur_rgb", args, {to_dev});
+        return dev.migrate({out}, MigrateDirection::ToHost, {run});
+    };
+}
+
+static bool check_critical(const Workload &w, unsigned int slot)
+{
+    return memcmp(w.critical[slot].out->host_ptr(), w.reference.data(), w.reference.size()) == 0;
+}
+
+// Latency of a critical request with the device otherwise idle. Also
+// captures the output every later request must reproduce.
+static std::chrono::microseconds calibrate(DeviceBackend &dev, Workload &w)
+{
+    DeadlineScheduler sched(dev);
+    for (unsigned int i = 0; i < CALIBRATION_JOBS; i++) {
+        sched.submit(JobClass::Critical, std::chrono::seconds(1), {resize_blur_step(w.critical[0])}).get();
+    }
+    const uint8_t *out = (const uint8_t *)w.critical[0].out->host_ptr();
+    w.reference.assign(out, out + w.critical[0].out->size());
+
+    // The median leaves out the first run's first touch of the buffers
+    uint64_t p50_ns = sched.get_stats(JobClass::Critical).latency.value_at_percentile(50.0);
+    return std::chrono::microseconds(std::max<uint64_t>(p50_ns / 1000, 1));
+}
+
+static bool verify_bulk(const BulkSet &set, uint64_t count)
+{
+    VerifyResult v = verify_buffer((const uint32_t *)set.c->host_ptr(), count, vadd_expected);
+    if (!v.ok()) {
+        print_verify_result(std::cout, v);
+    }
+    return v.ok();
+}
+
+// Issues critical requests on a fixed period while keeping the device
+// saturated with bulk jobs, topping them up as they complete
+static MixResult run_mix(DeviceBackend &dev,
+                         Workload &w,
+                         const DeadlineSchedulerConfig &config,
+                         size_t chunk_bytes,
+                         std::chrono::microseconds period,
+                         std::chrono::microseconds slo,
+                         bool &verified)
+{
+    DeadlineScheduler sched(dev, config);
+    MixResult result;
+
+    std::deque<std::pair<unsigned int, std::future<JobOutcome>>> bulk;
+    unsigned int next_set = 0;
+    auto top_up_bulk      = [&](bool wait) {
+        while (!bulk.empty() && (wait || bulk.front().second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+            bulk.front().second.get();
+            verified = verify_bulk(w.bulk[bulk.front().first], w.bulk_elems) && verified;
+            bulk.pop_front();
+        }
+        while (!wait && bulk.size() < BULK_OUTSTANDING) {
+            BulkSet &set = w.bulk[next_set];
+            memset(set.c->host_ptr(), 0, set.c->size());
+            bulk.push_back(std::make_pair(next_set, sched.submit(JobClass::Bulk, std::chrono::seconds(60),
+                                                                 chunked_vadd_steps(set.a, set.b, set.c, w.bulk_elems, chunk_bytes))));
+            next_set = (next_set + 1) % BULK_OUTSTANDING;
+        }
+    };
+
+    std::vector<std::future<JobOutcome>> critical(CRITICAL_SLOTS);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < NUM_CRITICAL; i++) {
+        top_up_bulk(false);
+        std::this_thread::sleep_until(start + i * period);
+        unsigned int slot = i % CRITICAL_SLOTS;
+        if (critical[slot].valid()) {
+            critical[slot].get();
+            verified = check_critical(w, slot) && verified;
+        }
+        critical[slot] = sched.submit(JobClass::Critical, slo, {resize_blur_step(w.critical[slot])});
+    }
+    for (unsigned int slot = 0; slot < CRITICAL_SLOTS; slot++) {
+        if (critical[slot].valid()) {
+            critical[slot].get();
+            verified = check_critical(w, slot) && verified;
+        }
+    }
+    double seconds   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.bulk_jobs = sched.get_stats(JobClass::Bulk).jobs;
+    result.bulk_gbps = 3.0 * w.bulk_elems * sizeof(uint32_t) * result.bulk_jobs / seconds / 1e9;
+
+    // Bulk jobs still running count towards neither the time nor the total,
+    // but are checked like the rest
+    top_up_bulk(true);
+    result.critical = sched.get_stats(JobClass::Critical);
+    return result;
+}
+
+static void print_row(const char *mode, const MixResult &r)
+{
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::left << std::setw(22) << mode << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << r.critical.missed << std::setw(10) << r.critical.miss_rate() * 100.0
+              << std::setw(12) << r.critical.latency.value_at_percentile(50.0) / 1000.0
+              << std::setw(12) << r.critical.latency.value_at_percentile(99.0) / 1000.0
+              << std::setw(12) << r.critical.latency.max() / 1000.0
+              << std::setw(11) << r.bulk_jobs << std::setprecision(2) << std::setw(12) << r.bulk_gbps << std::endl;
+    std::cout.flags(flags);
+}
+
+int main(int argc, char *argv[])
+{
+    // Initialize an event timer we'll use for monitoring the application
+    EventTimer et;
+
+    size_t bulk_mib  = DEFAULT_BULK_MIB;
+    size_t chunk_kib = DEFAULT_CHUNK_KIB;
+    if (argc > 1) {
+        bulk_mib = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        chunk_kib = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3 || bulk_mib == 0 || chunk_kib < 4) {
+        std::cout << "Usage: 29_deadline_scheduling [MiB per bulk vector] [KiB per bulk chunk]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "-- Example 29: Deadline-Aware Scheduling --" << std::endl
+              << std::endl;
+
+    try {
+        et.add("Backend initialization");
+        std::unique_ptr<DeviceBackend> dev = create_device_backend("alveo_examples.xclbin");
+        et.finish();
+
+        et.add("Allocate and populate buffers");
+        Workload w;
+        w.bulk_elems = bulk_mib * 1024 * 1024 / sizeof(uint32_t);
+        size_t bytes = w.bulk_elems * sizeof(uint32_t);
+        for (unsigned int k = 0; k < BULK_OUTSTANDING; k++) {
+            BulkSet set;
+            set.a = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+            set.b = dev->create_buffer(bytes, BufferAccess::ReadOnly);
+            set.c = dev->create_buffer(bytes, BufferAccess::WriteOnly);
+            dev->bind_kernel_args("wide_vadd", KernelArgs().set(0, set.a).set(1, set.b).set(2, set.c));
+
+            uint32_t *a = (uint32_t *)set.a->host_ptr();
+            uint32_t *b = (uint32_t *)set.b->host_ptr();
+            for (size_t i = 0; i < w.bulk_elems; i++) {
+                a[i] = (uint32_t)i;
+                b[i] = (uint32_t)(2 * i);
+            }
+            w.bulk.push_back(set);
+        }
+        for (unsigned int k = 0; k < CRITICAL_SLOTS; k++) {
+            CriticalSlot slot;
+            slot.in  = dev->create_buffer((size_t)WIDTH_IN * HEIGHT_IN * 3, BufferAccess::ReadOnly);
+            slot.out = dev->create_buffer((size_t)WIDTH_OUT * HEIGHT_OUT * 3, BufferAccess::WriteOnly);
+            dev->bind_kernel_args("resize_blur_rgb", KernelArgs().set(0, slot.in).set(1, slot.out));
+
+            // Diagonal stripes, so a result taken from the wrong slot or a
+            // stale buffer shows up against the reference
+            uint8_t *in = (uint8_t *)slot.in->host_ptr();
+            for (size_t p = 0; p < slot.in->size(); p++) {
+                in[p] = (uint8_t)((p / 3 % WIDTH_IN + p / 3 / WIDTH_IN) * 7 + p % 3 * 50);
+            }
+            w.critical.push_back(slot);
+        }
+        et.finish();
+
+        et.add("Calibrate critical latency");
+        std::chrono::microseconds idle   = calibrate(*dev, w);
+        std::chrono::microseconds slo    = idle * SLO_FACTOR;
+        std::chrono::microseconds period = std::max(idle * LOAD_FACTOR, std::chrono::microseconds(CRITICAL_PERIOD_US));
+        et.finish();
+
+        std::cout << "Backend: " << dev->name() << ", bulk vadds of " << bulk_mib << " MiB per vector against "
+                  << NUM_CRITICAL << " resize_blur requests" << std::endl
+                  << "Idle request latency " << idle.count() / 1000.0 << " ms; one request every "
+                  << period.count() / 1000.0 << " ms with a " << slo.count() / 1000.0 << " ms deadline" << std::endl
+                  << std::endl;
+
+        bool verified = true;
+
+        DeadlineSchedulerConfig fifo;
+        fifo.policy = SchedulePolicy::Fifo;
+        DeadlineSchedulerConfig edf;
+        edf.policy = SchedulePolicy::Deadline;
+
+        et.add("FIFO, whole bulk jobs");
+        MixResult fifo_whole = run_mix(*dev, w, fifo, bytes, period, slo, verified);
+        et.finish();
+
+        et.add("EDF, whole bulk jobs");
+        MixResult edf_whole = run_mix(*dev, w, edf, bytes, period, slo, verified);
+        et.finish();
+
+        et.add("EDF, chunked bulk jobs");
+        MixResult edf_chunked = run_mix(*dev, w, edf, chunk_kib * 1024, period, slo, verified);
+        et.finish();
+
+        std::cout << std::left << std::setw(22) << "Mode" << std::right << std::setw(10) << "Missed"
+                  << std::setw(10) << "Miss (%)" << std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)"
+                  << std::setw(12) << "Max (us)" << std::setw(11) << "Bulk jobs" << std::setw(12) << "Bulk GB/s" << std::endl;
+        print_row("FIFO, whole jobs", fifo_whole);
+        print_row("EDF, whole jobs", edf_whole);
+        std::string chunked = "EDF, " + std::to_string(chunk_kib) + " KiB chunks";
+        print_row(chunked.c_str(), edf_chunked);
+
+        if (!verified) {
+            std::cout << "ERROR: scheduled results do not match" << std::endl;
+        }
+
+        if (verified) {
+            std::cout
+                << std::endl
+                << "Deadline scheduling example complete!"
+                << std::endl
+                << std::endl;
+        }
+        else {
+            std::cout
+                << std::endl
+                << "Deadline scheduling example complete! (with errors)"
+                << std::endl
+                << std::endl;
+        }
+
+        std::cout << "--------------- Key execution times ---------------" << std::endl;
+        et.print();
+
+        return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
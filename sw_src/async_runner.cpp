@@ -0,0 +1,264 @@
+#include "async_runner.hpp"
+
+namespace xilinx {
+namespace example_utils {
+CompletionPool::CompletionPool(unsigned int num_threads)
+{
+    if (num_threads == 0) {
+        throw_lineexception("Completion pool requires at least one thread");
+    }
+    for (unsigned int i = 0; i < num_threads; i++) {
+        threads.emplace_back(&CompletionPool::worker, this);
+    }
+}
+
+CompletionPool::~CompletionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+void CompletionPool::post(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        work.push_back(std::move(fn));
+    }
+    cv.notify_one();
+}
+
+void CompletionPool::worker()
+{
+    for (;;) {
+        std::function<void()> fn;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [this] { return stopping || !work.empty(); });
+            // Drain outstanding work before exiting so no completion is lost
+            if (work.empty()) {
+                return;
+            }
+            fn = std::move(work.front());
+            work.pop_front();
+        }
+        fn();
+    }
+}
+
+namespace detail {
+JobState::JobState(CompletionPool *pool_in) : pool(pool_in)
+{
+    future = promise.get_future().share();
+}
+
+void JobState::finish(std::exception_ptr error)
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        done = true;
+        ready.swap(continuations);
+    }
+
+    if (error) {
+        promise.set_exception(error);
+    }
+    else {
+        promise.set_value();
+    }
+
+    for (auto &fn : ready) {
+        pool->post(std::move(fn));
+    }
+}
+
+void JobState::on_complete(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (!done) {
+            continuations.push_back(std::move(fn));
+            return;
+        }
+    }
+    pool->post(std::move(fn));
+}
+} // namespace detail
+
+AsyncJob::AsyncJob()
+{
+}
+
+AsyncJob::AsyncJob(std::shared_ptr<detail::JobState> state_in) : state(state_in)
+{
+}
+
+bool AsyncJob::valid() const
+{
+    return (state != nullptr);
+}
+
+bool AsyncJob::ready() const
+{
+    if (!state) {
+        return false;
+    }
+    return state->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void AsyncJob::wait() const
+{
+    if (!state) {
+        throw_lineexception("Attempted to wait on an empty AsyncJob");
+    }
+    state->future.wait();
+}
+
+void AsyncJob::get() const
+{
+    if (!state) {
+        throw_lineexception("Attempted to wait on an empty AsyncJob");
+    }
+    state->future.get();
+}
+
+std::shared_future<void> AsyncJob::get_future() const
+{
+    if (!state) {
+        throw_lineexception("Attempted to get future of an empty AsyncJob");
+    }
+    return state->future;
+}
+
+AsyncJob AsyncJob::then(std::function<void()> fn) const
+{
+    if (!state) {
+        throw_lineexception("Attempted to chain onto an empty AsyncJob");
+    }
+
+    auto parent = state;
+    auto child  = std::make_shared<detail::JobState>(parent->pool);
+    parent->on_complete([parent, child, fn]() {
+        try {
+            parent->future.get();
+            fn();
+        }
+        catch (...) {
+            child->finish(std::current_exception());
+            return;
+        }
+        child->finish(nullptr);
+    });
+    return AsyncJob(child);
+}
+
+AsyncRunner::AsyncRunner(XilinxOclHelper &xocl, unsigned int completion_threads)
+    : outstanding(0), pool(completion_threads)
+{
+    q = xocl.get_command_queue();
+}
+
+AsyncRunner::~AsyncRunner()
+{
+    q.finish();
+
+    // Callbacks may still be in flight after clFinish returns
+    while (outstanding.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void CL_CALLBACK AsyncRunner::event_callback(cl_event event, cl_int status, void *user_data)
+{
+    auto *ctx = static_cast<std::pair<AsyncRunner *, std::shared_ptr<detail::JobState>> *>(user_data);
+    AsyncRunner *runner                      = ctx->first;
+    std::shared_ptr<detail::JobState> state = ctx->second;
+    delete ctx;
+
+    runner->pool.post([state, status]() {
+        if (status < 0) {
+            try {
+                throw_lineexception("Device command failed with status " + std::to_string(status));
+            }
+            catch (...) {
+                state->finish(std::current_exception());
+                return;
+            }
+        }
+        state->finish(nullptr);
+    });
+    runner->outstanding--;
+}
+
+void AsyncRunner::track_buffer(const cl::Buffer &buf,
+                               std::vector<cl::Memory> &inputs,
+                               std::vector<cl::Memory> &outputs)
+{
+    cl_mem_flags flags = buf.getInfo<CL_MEM_FLAGS>();
+    if (!(flags & CL_MEM_WRITE_ONLY)) {
+        inputs.push_back(buf);
+    }
+    if (!(flags & CL_MEM_READ_ONLY)) {
+        outputs.push_back(buf);
+    }
+}
+
+AsyncJob AsyncRunner::enqueue(cl::Kernel &krnl,
+                              const std::vector<cl::Memory> &inputs,
+                              const std::vector<cl::Memory> &outputs)
+{
+    cl::Event m_event, k_event, r_event;
+    std::vector<cl::Event> deps;
+
+    if (!inputs.empty()) {
+        q.enqueueMigrateMemObjects(inputs, 0, NULL, &m_event);
+        deps.push_back(m_event);
+    }
+
+    q.enqueueTask(krnl, &deps, &k_event);
+
+    if (outputs.empty()) {
+        return when_complete(k_event);
+    }
+
+    deps.clear();
+    deps.push_back(k_event);
+    q.enqueueMigrateMemObjects(outputs, CL_MIGRATE_MEM_OBJECT_HOST, &deps, &r_event);
+    return when_complete(r_event);
+}
+
+AsyncJob AsyncRunner::when_complete(const cl::Event &event)
+{
+    auto state = std::make_shared<detail::JobState>(&pool);
+    auto *ctx  = new std::pair<AsyncRunner *, std::shared_ptr<detail::JobState>>(this, state);
+
+    outstanding++;
+    cl_int err = clSetEventCallback(event(), CL_COMPLETE, &AsyncRunner::event_callback, ctx);
+    if (err != CL_SUCCESS) {
+        outstanding--;
+        delete ctx;
+        throw_lineexception("Unable to register event completion callback");
+    }
+
+    // Make sure the commands leading to this event actually get submitted
+    q.flush();
+    return AsyncJob(state);
+}
+
+cl::CommandQueue &AsyncRunner::get_command_queue()
+{
+    return q;
+}
+
+CompletionPool &AsyncRunner::get_pool()
+{
+    return pool;
+}
+} // namespace example_utils
+} // namespace xilinx
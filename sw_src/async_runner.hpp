@@ -0,0 +1,156 @@
+#ifndef ASYNC_RUNNER_HPP__
+#define ASYNC_RUNNER_HPP__
+
+#pragma once
+
+#include "xilinx_ocl_helper.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// A small fixed-size pool of threads that runs completion handlers. Event
+// callbacks only post work here, so user code never runs on the XRT callback
+// thread.
+class CompletionPool
+{
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> work;
+    std::mutex m;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void worker();
+
+public:
+    explicit CompletionPool(unsigned int num_threads = 2);
+    ~CompletionPool();
+
+    void post(std::function<void()> fn);
+};
+
+namespace detail {
+struct JobState
+{
+    std::promise<void> promise;
+    std::shared_future<void> future;
+    std::mutex m;
+    bool done = false;
+    std::vector<std::function<void()>> continuations;
+    CompletionPool *pool;
+
+    explicit JobState(CompletionPool *pool_in);
+    void finish(std::exception_ptr error);
+    void on_complete(std::function<void()> fn);
+};
+} // namespace detail
+
+// Handle to an in-flight job. Copies refer to the same job.
+class AsyncJob
+{
+private:
+    std::shared_ptr<detail::JobState> state;
+
+public:
+    AsyncJob();
+    explicit AsyncJob(std::shared_ptr<detail::JobState> state_in);
+
+    bool valid() const;
+    bool ready() const;
+
+    // Blocks until the job completes. get() also rethrows any error raised by
+    // the device or by a continuation.
+    void wait() const;
+    void get() const;
+    std::shared_future<void> get_future() const;
+
+    // Runs fn on the completion pool once this job has completed successfully.
+    // The returned job completes when fn returns. If this job failed, fn is
+    // skipped and the error propagates to the returned job.
+    AsyncJob then(std::function<void()> fn) const;
+};
+
+// Submits migrate -> task -> migrate chains without blocking the caller.
+// Completion is reported through clSetEventCallback into a CompletionPool.
+class AsyncRunner
+{
+private:
+    cl::CommandQueue q;
+    std::mutex submit_mutex;
+    std::atomic<int> outstanding;
+    CompletionPool pool;
+
+    static void CL_CALLBACK event_callback(cl_event event, cl_int status, void *user_data);
+
+    void set_args(cl::Kernel &krnl,
+                  cl_uint index,
+                  std::vector<cl::Memory> &inputs,
+                  std::vector<cl::Memory> &outputs)
+    {
+    }
+
+    template <typename T, typename... Rest>
+    void set_args(cl::Kernel &krnl,
+                  cl_uint index,
+                  std::vector<cl::Memory> &inputs,
+                  std::vector<cl::Memory> &outputs,
+                  const T &arg,
+                  const Rest &... rest)
+    {
+        krnl.setArg(index, arg);
+        track_buffer(arg, inputs, outputs);
+        set_args(krnl, index + 1, inputs, outputs, rest...);
+    }
+
+    template <typename T>
+    void track_buffer(const T &arg,
+                      std::vector<cl::Memory> &inputs,
+                      std::vector<cl::Memory> &outputs)
+    {
+    }
+
+    void track_buffer(const cl::Buffer &buf,
+                      std::vector<cl::Memory> &inputs,
+                      std::vector<cl::Memory> &outputs);
+
+    AsyncJob enqueue(cl::Kernel &krnl,
+                     const std::vector<cl::Memory> &inputs,
+                     const std::vector<cl::Memory> &outputs);
+
+public:
+    AsyncRunner(XilinxOclHelper &xocl, unsigned int completion_threads = 2);
+    ~AsyncRunner();
+
+    // Sets the kernel arguments in order, migrates every buffer argument the
+    // kernel may read to the device, runs the kernel, and migrates every
+    // buffer argument it may write back to the host. Buffers created with
+    // CL_MEM_READ_ONLY are only sent, CL_MEM_WRITE_ONLY are only returned.
+    template <typename... Args>
+    AsyncJob run_async(cl::Kernel &krnl, const Args &... args)
+    {
+        std::vector<cl::Memory> inputs, outputs;
+        std::lock_guard<std::mutex> lock(submit_mutex);
+        set_args(krnl, 0, inputs, outputs, args...);
+        return enqueue(krnl, inputs, outputs);
+    }
+
+    // Wraps any already-enqueued event in an AsyncJob
+    AsyncJob when_complete(const cl::Event &event);
+
+    cl::CommandQueue &get_command_queue();
+    CompletionPool &get_pool();
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // ASYNC_RUNNER_HPP__
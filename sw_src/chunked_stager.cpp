@@ -0,0 +1,219 @@
+#include "chunked_stager.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace xilinx {
+namespace example_utils {
+void stream_copy(void *dst, const void *src, size_t len)
+{
+#ifdef __SSE2__
+    char *d       = static_cast<char *>(dst);
+    const char *s = static_cast<const char *>(src);
+
+    // Streaming stores need an aligned destination
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15;
+    if (head > len) {
+        head = len;
+    }
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    len -= head;
+
+    size_t blocks = len / 64;
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 16));
+        __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 32));
+        __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d), v0);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d + 16), v1);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d + 32), v2);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(d + 48), v3);
+        d += 64;
+        s += 64;
+    }
+    memcpy(d, s, len - blocks * 64);
+
+    // Make the streaming stores visible before the buffer is handed to DMA
+    _mm_sfence();
+#else
+    memcpy(dst, src, len);
+#endif
+}
+
+ChunkedStager::ChunkedStager(XilinxOclHelper &xocl,
+                             size_t chunk_size_in,
+                             unsigned int window_depth_in,
+                             unsigned int copy_threads)
+    : chunk_size(chunk_size_in), window_depth(window_depth_in), copiers(copy_threads)
+{
+    if (chunk_size == 0 || chunk_size % 4096 != 0) {
+        throw_lineexception("Staging chunk size must be a non-zero multiple of 4 KiB");
+    }
+    if (window_depth == 0) {
+        throw_lineexception("Staging window must hold at least one chunk");
+    }
+
+    // In-order queue: each chunk's unmap must precede its migration
+    q = xocl.get_command_queue(true);
+}
+
+std::vector<cl::Buffer> ChunkedStager::split(cl::Buffer &buf, size_t size)
+{
+    if (size > buf.getInfo<CL_MEM_SIZE>()) {
+        throw_lineexception("Transfer is larger than the device buffer");
+    }
+
+    // A sub-buffer may not ask for more access than its parent has, so pass
+    // on only the parent's access flags
+    cl_mem_flags flags = buf.getInfo<CL_MEM_FLAGS>() & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY);
+
+    std::vector<cl::Buffer> chunks;
+    cl_buffer_region region;
+    for (region.origin = 0; region.origin < size; region.origin += chunk_size) {
+        region.size = std::min(chunk_size, size - region.origin);
+
+        cl_int err;
+        cl::Buffer chunk = buf.createSubBuffer(flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+        if (err != CL_SUCCESS) {
+            throw_lineexception("Unable to create staging sub-buffer");
+        }
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+struct PendingCopy
+{
+    size_t index;
+    void *mapped;
+    std::future<void> done;
+};
+
+static std::future<void> post_copy(CompletionPool &pool, void *dst, const void *src, size_t len)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+    pool.post([promise, dst, src, len]() {
+        stream_copy(dst, src, len);
+        promise->set_value();
+    });
+    return promise->get_future();
+}
+
+cl::Event ChunkedStager::upload(cl::Buffer &dst, const void *src, size_t size)
+{
+    std::vector<cl::Buffer> chunks = split(dst, size);
+    std::vector<cl::Event> migrations;
+    std::deque<PendingCopy> pending;
+
+    auto retire = [&]() {
+        PendingCopy &p = pending.front();
+        p.done.wait();
+
+        cl::Event ev;
+        q.enqueueUnmapMemObject(chunks[p.index], p.mapped);
+        q.enqueueMigrateMemObjects({chunks[p.index]}, 0, NULL, &ev);
+        q.flush();
+        migrations.push_back(ev);
+        pending.pop_front();
+    };
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t offset = i * chunk_size;
+        size_t len    = std::min(chunk_size, size - offset);
+
+        // Mapping an XRT buffer returns its pinned host backing, no copy
+        void *mapped = q.enqueueMapBuffer(chunks[i], CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, len);
+
+        PendingCopy p;
+        p.index  = i;
+        p.mapped = mapped;
+        p.done   = post_copy(copiers, mapped, static_cast<const char *>(src) + offset, len);
+        pending.push_back(std::move(p));
+
+        if (pending.size() >= window_depth) {
+            retire();
+        }
+    }
+    while (!pending.empty()) {
+        retire();
+    }
+
+    cl::Event done;
+    q.enqueueMarkerWithWaitList(&migrations, &done);
+    q.flush();
+    return done;
+}
+
+void ChunkedStager::download(void *dst, cl::Buffer &src, size_t size)
+{
+    std::vector<cl::Buffer> chunks = split(src, size);
+    std::deque<cl::Event> migrations;
+    std::deque<PendingCopy> pending;
+    size_t next_migrate = 0;
+
+    auto issue_migration = [&]() {
+        cl::Event ev;
+        q.enqueueMigrateMemObjects({chunks[next_migrate]}, CL_MIGRATE_MEM_OBJECT_HOST, NULL, &ev);
+        q.flush();
+        migrations.push_back(ev);
+        next_migrate++;
+    };
+
+    auto retire = [&]() {
+        PendingCopy &p = pending.front();
+        p.done.wait();
+        q.enqueueUnmapMemObject(chunks[p.index], p.mapped);
+        pending.pop_front();
+    };
+
+    // Keep up to window_depth chunks in flight on the PCIe link ahead of the
+    // chunk currently being copied out
+    while (next_migrate < chunks.size() && migrations.size() < window_depth) {
+        issue_migration();
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t offset = i * chunk_size;
+        size_t len    = std::min(chunk_size, size - offset);
+
+        migrations.front().wait();
+        migrations.pop_front();
+        if (next_migrate < chunks.size()) {
+            issue_migration();
+        }
+
+        void *mapped = q.enqueueMapBuffer(chunks[i], CL_TRUE, CL_MAP_READ, 0, len);
+
+        PendingCopy p;
+        p.index  = i;
+        p.mapped = mapped;
+        p.done   = post_copy(copiers, static_cast<char *>(dst) + offset, mapped, len);
+        pending.push_back(std::move(p));
+
+        if (pending.size() >= window_depth) {
+            retire();
+        }
+    }
+    while (!pending.empty()) {
+        retire();
+    }
+    q.finish();
+}
+
+cl::CommandQueue &ChunkedStager::get_command_queue()
+{
+    return q;
+}
+} // namespace example_utils
+} // namespace xilinx
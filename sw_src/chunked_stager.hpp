@@ -0,0 +1,58 @@
+#ifndef CHUNKED_STAGER_HPP__
+#define CHUNKED_STAGER_HPP__
+
+#pragma once
+
+#include "async_runner.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Copies with non-temporal stores where the CPU supports them, so that large
+// staging copies do not evict the caller's working set from the cache
+void stream_copy(void *dst, const void *src, size_t len);
+
+// Moves data between arbitrary (e.g. unaligned new[]) user memory and XRT
+// allocated device buffers in a pipeline of 4 KiB aligned chunks.
+//
+// Wrapping unaligned memory with CL_MEM_USE_HOST_PTR makes XRT copy the
+// whole buffer into its own pinned shadow before any DMA starts. Here there
+// are no separate staging buffers: each transfer is split into sub-buffers
+// of the device buffer itself, whose host backing XRT already pins, and up
+// to 'window_depth' of them are in flight at once. Copier threads fill chunk
+// k while chunks k-1, k-2, ... are already being migrated, so the copy
+// overlaps the transfer. Downloads run in reverse, migrating ahead of the
+// copier threads.
+class ChunkedStager
+{
+private:
+    cl::CommandQueue q;
+    size_t chunk_size;
+    unsigned int window_depth;
+    CompletionPool copiers;
+
+    std::vector<cl::Buffer> split(cl::Buffer &buf, size_t size);
+
+public:
+    ChunkedStager(XilinxOclHelper &xocl,
+                  size_t chunk_size         = 4 * 1024 * 1024,
+                  unsigned int window_depth = 4,
+                  unsigned int copy_threads = 2);
+
+    // Copies 'size' bytes from 'src' into 'dst' and migrates them to the card.
+    // 'dst' must have been allocated by XRT (no CL_MEM_USE_HOST_PTR). Returns
+    // an event that completes when the last chunk has been migrated.
+    cl::Event upload(cl::Buffer &dst, const void *src, size_t size);
+
+    // Migrates 'size' bytes of 'src' back from the card and copies them to
+    // 'dst'. Blocks until the data is in 'dst'.
+    void download(void *dst, cl::Buffer &src, size_t size);
+
+    cl::CommandQueue &get_command_queue();
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // CHUNKED_STAGER_HPP__
@@ -0,0 +1,222 @@
+#include "coalescer.hpp"
+
+#include "line_exception.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace xilinx {
+namespace example_utils {
+// Requests start on 512-bit word boundaries within a batch
+#define COALESCE_ALIGN_ELEMS 16
+
+static size_t padded(size_t n)
+{
+    return (n + COALESCE_ALIGN_ELEMS - 1) / COALESCE_ALIGN_ELEMS * COALESCE_ALIGN_ELEMS;
+}
+
+VaddCoalescer::VaddCoalescer(DeviceBackend &dev,
+                             size_t max_batch_elems,
+                             std::chrono::microseconds window,
+                             unsigned int depth)
+    : dev(dev), max_batch_elems(padded(max_batch_elems)), window(window), pending_elems(0),
+      slots(depth ? depth : 1), stopping(false), dispatcher_done(false), num_requests(0),
+      num_batches(0), num_elements(0)
+{
+    size_t bytes = this->max_batch_elems * sizeof(uint32_t);
+    for (auto &slot : slots) {
+        slot.a = dev.create_buffer(bytes, BufferAccess::ReadOnly);
+        slot.b = dev.create_buffer(bytes, BufferAccess::ReadOnly);
+        slot.c = dev.create_buffer(bytes, BufferAccess::WriteOnly);
+        dev.bind_kernel_args("wide_vadd", KernelArgs().set(0, slot.a).set(1, slot.b).set(2, slot.c));
+    }
+
+    dispatcher = std::thread(&VaddCoalescer::dispatcher_main, this);
+    completer  = std::thread(&VaddCoalescer::completer_main, this);
+}
+
+VaddCoalescer::~VaddCoalescer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pending_cv.notify_all();
+    dispatcher.join();
+    completer.join();
+}
+
+std::future<void> VaddCoalescer::submit(const uint32_t *a, const uint32_t *b, uint32_t *c, size_t n)
+{
+    if (padded(n) > max_batch_elems) {
+        throw_lineexception("Request is larger than the coalescer's batch size");
+    }
+
+    std::unique_ptr<Request> req(new Request);
+    req->a       = a;
+    req->b       = b;
+    req->c       = c;
+    req->n       = n;
+    req->arrival = std::chrono::steady_clock::now();
+    std::future<void> fut = req->done.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            throw_lineexception("Coalescer is shutting down");
+        }
+        pending_elems += padded(n);
+        pending.push_back(std::move(req));
+    }
+    pending_cv.notify_all();
+    return fut;
+}
+
+VaddCoalescer::Slot *VaddCoalescer::acquire_slot()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        for (auto &slot : slots) {
+            if (!slot.busy) {
+                slot.busy = true;
+                return &slot;
+            }
+        }
+        slot_cv.wait(lock);
+    }
+}
+
+void VaddCoalescer::dispatcher_main()
+{
+    for (;;) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pending_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                break;
+            }
+
+            // Hold the batch open until the window closes or it is full;
+            // on shutdown, flush immediately
+            auto deadline = pending.front()->arrival + window;
+            pending_cv.wait_until(lock, deadline, [this] {
+                return stopping || pending_elems >= max_batch_elems;
+            });
+
+            size_t total = 0;
+            while (!pending.empty() && total + padded(pending.front()->n) <= max_batch_elems) {
+                batch.offsets.push_back(total);
+                total += padded(pending.front()->n);
+                pending_elems -= padded(pending.front()->n);
+                batch.requests.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+        }
+
+        // Gather into the batch buffers
+        batch.slot  = acquire_slot();
+        uint32_t *a = (uint32_t *)batch.slot->a->host_ptr();
+        uint32_t *b = (uint32_t *)batch.slot->b->host_ptr();
+        size_t end  = 0;
+        for (size_t i = 0; i < batch.requests.size(); i++) {
+            Request &r = *batch.requests[i];
+            memcpy(a + batch.offsets[i], r.a, r.n * sizeof(uint32_t));
+            memcpy(b + batch.offsets[i], r.b, r.n * sizeof(uint32_t));
+            end = batch.offsets[i] + r.n;
+        }
+
+        try {
+            // Only move the whole pages of the batch buffers in use
+            size_t bytes       = std::max<size_t>(4096, (end * sizeof(uint32_t) + 4095) / 4096 * 4096);
+            bytes              = std::min(bytes, batch.slot->a->size());
+            BufferHandle a_sub = dev.create_sub_buffer(batch.slot->a, 0, bytes);
+            BufferHandle b_sub = dev.create_sub_buffer(batch.slot->b, 0, bytes);
+            BufferHandle c_sub = dev.create_sub_buffer(batch.slot->c, 0, bytes);
+
+            KernelArgs args;
+            args.set(0, a_sub).set(1, b_sub).set(2, c_sub).set(3, (uint64_t)end);
+
+            EventHandle to_dev = dev.migrate({a_sub, b_sub}, MigrateDirection::ToDevice);
+            EventHandle run    = dev.run_kernel("wide_vadd", args, {to_dev});
+            batch.done         = dev.migrate({c_sub}, MigrateDirection::ToHost, {run});
+        }
+        catch (...) {
+            for (auto &r : batch.requests) {
+                r->done.set_exception(std::current_exception());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.slot->busy = false;
+            continue;
+        }
+
+        num_requests += batch.requests.size();
+        num_batches++;
+        num_elements += end;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            in_flight.push_back(std::move(batch));
+        }
+        in_flight_cv.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dispatcher_done = true;
+    }
+    in_flight_cv.notify_one();
+}
+
+// Waits for batches in order and scatters the results back to the callers
+void VaddCoalescer::completer_main()
+{
+    for (;;) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            in_flight_cv.wait(lock, [this] { return dispatcher_done || !in_flight.empty(); });
+            if (in_flight.empty()) {
+                return;
+            }
+            batch = std::move(in_flight.front());
+            in_flight.pop_front();
+        }
+
+        std::exception_ptr err;
+        try {
+            batch.done->wait();
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+
+        const uint32_t *c = (const uint32_t *)batch.slot->c->host_ptr();
+        for (size_t i = 0; i < batch.requests.size(); i++) {
+            Request &r = *batch.requests[i];
+            if (err) {
+                r.done.set_exception(err);
+                continue;
+            }
+            memcpy(r.c, c + batch.offsets[i], r.n * sizeof(uint32_t));
+            r.done.set_value();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.slot->busy = false;
+        }
+        slot_cv.notify_one();
+    }
+}
+
+CoalescerStats VaddCoalescer::get_stats() const
+{
+    CoalescerStats s;
+    s.requests = num_requests;
+    s.batches  = num_batches;
+    s.elements = num_elements;
+    return s;
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,107 @@
+#ifndef COALESCER_HPP__
+#define COALESCER_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace xilinx {
+namespace example_utils {
+struct CoalescerStats
+{
+    uint64_t requests = 0;
+    uint64_t batches  = 0;
+    uint64_t elements = 0;
+};
+
+// Batches small vector additions from many threads into single wide_vadd
+// runs.
+//
+// For payloads of a few KiB the fixed cost of migrate + enqueueTask +
+// migrate dwarfs the transfer itself. Requests arriving within 'window' of
+// the oldest pending one (or until 'max_batch_elems' is reached) are packed
+// back to back into one set of buffers, each starting on a 512-bit word
+// boundary, and run as one kernel invocation. Addition is element-wise, so
+// the kernel needs no knowledge of where one request ends and the next
+// begins; the offset table lives on the host and is used to scatter the
+// results back to the callers.
+class VaddCoalescer
+{
+private:
+    struct Request
+    {
+        const uint32_t *a;
+        const uint32_t *b;
+        uint32_t *c;
+        size_t n;
+        std::chrono::steady_clock::time_point arrival;
+        std::promise<void> done;
+    };
+
+    struct Slot
+    {
+        BufferHandle a, b, c;
+        bool busy = false;
+    };
+
+    struct Batch
+    {
+        Slot *slot;
+        std::vector<std::unique_ptr<Request>> requests;
+        std::vector<size_t> offsets;
+        EventHandle done;
+    };
+
+    DeviceBackend &dev;
+    size_t max_batch_elems;
+    std::chrono::microseconds window;
+
+    std::mutex mutex;
+    std::condition_variable pending_cv;
+    std::condition_variable slot_cv;
+    std::condition_variable in_flight_cv;
+    std::deque<std::unique_ptr<Request>> pending;
+    size_t pending_elems;
+    std::vector<Slot> slots;
+    std::deque<Batch> in_flight;
+    bool stopping;
+    bool dispatcher_done;
+
+    std::atomic<uint64_t> num_requests, num_batches, num_elements;
+
+    void dispatcher_main();
+    void completer_main();
+    Slot *acquire_slot();
+
+    // Declared last so they start after everything above is constructed
+    std::thread dispatcher;
+    std::thread completer;
+
+public:
+    // 'depth' batches may be in flight at once, each with its own buffers
+    VaddCoalescer(DeviceBackend &dev,
+                  size_t max_batch_elems           = 1024 * 1024,
+                  std::chrono::microseconds window = std::chrono::microseconds(100),
+                  unsigned int depth               = 2);
+
+    // Completes everything already submitted
+    ~VaddCoalescer();
+
+    // c[i] = a[i] + b[i] for n elements. Thread safe. The pointers must stay
+    // valid until the returned future is ready.
+    std::future<void> submit(const uint32_t *a, const uint32_t *b, uint32_t *c, size_t n);
+
+    CoalescerStats get_stats() const;
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // COALESCER_HPP__
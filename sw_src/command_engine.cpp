@@ -0,0 +1,186 @@
+#include "command_engine.hpp"
+
+#include "line_exception.hpp"
+
+namespace xilinx {
+namespace example_utils {
+namespace detail {
+void HostEvent::complete(std::exception_ptr err)
+{
+    std::vector<std::function<void()>> to_run;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = err;
+        done  = true;
+        to_run.swap(callbacks);
+    }
+    cv.notify_all();
+    for (auto &fn : to_run) {
+        fn();
+    }
+}
+
+std::exception_ptr HostEvent::get_error()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+void HostEvent::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return done; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool HostEvent::is_complete()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return done;
+}
+
+void HostEvent::on_complete(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!done) {
+            callbacks.push_back(std::move(fn));
+            return;
+        }
+    }
+    fn();
+}
+
+void HostCommand::run()
+{
+    std::exception_ptr err;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        err = dep_error;
+    }
+    if (!err) {
+        try {
+            work();
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+    }
+    event->complete(err);
+    finished();
+}
+} // namespace detail
+
+CommandEngine::CommandEngine(unsigned int num_threads) : stopping(false)
+{
+    for (unsigned int i = 0; i < num_threads; i++) {
+        threads.emplace_back(&CommandEngine::thread_main, this);
+    }
+}
+
+CommandEngine::~CommandEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+void CommandEngine::push(std::shared_ptr<detail::HostCommand> cmd)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(std::move(cmd));
+    }
+    cv.notify_one();
+}
+
+void CommandEngine::thread_main()
+{
+    for (;;) {
+        std::shared_ptr<detail::HostCommand> cmd;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !ready.empty(); });
+            if (ready.empty()) {
+                return;
+            }
+            cmd = std::move(ready.front());
+            ready.pop_front();
+        }
+        cmd->run();
+    }
+}
+
+CommandTracker::CommandTracker() : outstanding(0) {}
+
+EventHandle CommandTracker::submit(std::function<void()> work,
+                                   CommandEngine &engine,
+                                   const std::vector<EventHandle> &deps)
+{
+    std::vector<std::shared_ptr<detail::HostEvent>> dep_events;
+    for (auto &dep : deps) {
+        auto ev = std::dynamic_pointer_cast<detail::HostEvent>(dep);
+        if (!ev) {
+            throw_lineexception("Dependency event was not created by a host-threaded backend");
+        }
+        dep_events.push_back(ev);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(outstanding_mutex);
+        outstanding++;
+    }
+
+    auto cmd       = std::make_shared<detail::HostCommand>();
+    cmd->work      = std::move(work);
+    cmd->event     = std::make_shared<detail::HostEvent>();
+    cmd->finished  = [this] { command_done(); };
+    cmd->remaining = (int)dep_events.size() + 1;
+
+    CommandEngine *eng = &engine;
+    auto arrive        = [cmd, eng]() {
+        if (--cmd->remaining == 0) {
+            eng->push(cmd);
+        }
+    };
+
+    for (auto &ev : dep_events) {
+        detail::HostEvent *dep = ev.get();
+        ev->on_complete([cmd, dep, arrive]() {
+            std::exception_ptr err = dep->get_error();
+            if (err) {
+                std::lock_guard<std::mutex> lock(cmd->error_mutex);
+                if (!cmd->dep_error) {
+                    cmd->dep_error = err;
+                }
+            }
+            arrive();
+        });
+    }
+    arrive();
+
+    return cmd->event;
+}
+
+void CommandTracker::command_done()
+{
+    std::lock_guard<std::mutex> lock(outstanding_mutex);
+    if (--outstanding == 0) {
+        outstanding_cv.notify_all();
+    }
+}
+
+void CommandTracker::finish()
+{
+    std::unique_lock<std::mutex> lock(outstanding_mutex);
+    outstanding_cv.wait(lock, [this] { return outstanding == 0; });
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,99 @@
+#ifndef COMMAND_ENGINE_HPP__
+#define COMMAND_ENGINE_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+namespace detail {
+// Event of a command run on a CommandEngine
+class HostEvent : public BackendEvent
+{
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::exception_ptr error;
+    std::vector<std::function<void()>> callbacks;
+
+public:
+    void complete(std::exception_ptr err);
+
+    void wait() override;
+    bool is_complete() override;
+    std::exception_ptr get_error() override;
+    void on_complete(std::function<void()> fn) override;
+};
+
+struct HostCommand
+{
+    std::function<void()> work;
+    std::function<void()> finished;
+    std::shared_ptr<HostEvent> event;
+    std::atomic<int> remaining;
+
+    std::mutex error_mutex;
+    std::exception_ptr dep_error;
+
+    // A failed dependency fails the command without running it, the way an
+    // OpenCL command waiting on an errored event does
+    void run();
+};
+} // namespace detail
+
+// Host threads that run ready commands in the order they became ready. With
+// one thread an engine behaves like a DMA engine or an in-order queue.
+class CommandEngine
+{
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<detail::HostCommand>> ready;
+    bool stopping;
+    std::vector<std::thread> threads;
+
+    void thread_main();
+
+public:
+    CommandEngine(unsigned int num_threads);
+    ~CommandEngine();
+    void push(std::shared_ptr<detail::HostCommand> cmd);
+};
+
+// The event graph of a backend whose commands run on host threads: each
+// submitted command waits for its dependencies and is then pushed to the
+// engine it was submitted to. Shared by CpuBackend, whose commands are
+// emulations, and XrtBackend, whose commands are blocking XRT calls.
+class CommandTracker
+{
+private:
+    std::mutex outstanding_mutex;
+    std::condition_variable outstanding_cv;
+    unsigned int outstanding;
+
+    void command_done();
+
+public:
+    CommandTracker();
+
+    // 'deps' must have been returned by submit() on some CommandTracker
+    EventHandle submit(std::function<void()> work, CommandEngine &engine, const std::vector<EventHandle> &deps);
+
+    // Blocks until every command submitted so far has completed
+    void finish();
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // COMMAND_ENGINE_HPP__
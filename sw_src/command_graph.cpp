@@ -0,0 +1,191 @@
+#include "command_graph.hpp"
+
+#include "line_exception.hpp"
+
+#include <algorithm>
+
+namespace xilinx {
+namespace example_utils {
+GraphArgs &GraphArgs::set(unsigned int index, const BufferHandle &buf)
+{
+    fixed.set(index, buf);
+    return *this;
+}
+
+GraphArgs &GraphArgs::set(unsigned int index, GraphSlot slot)
+{
+    slots.push_back(std::make_pair(index, slot.index));
+    return *this;
+}
+
+const EventHandle &GraphRun::event(size_t node) const
+{
+    if (node >= events.size()) {
+        throw_lineexception("Graph has no node " + std::to_string(node));
+    }
+    return events[node];
+}
+
+std::vector<EventHandle> GraphRun::sink_events() const
+{
+    std::vector<EventHandle> out;
+    if (!sinks) {
+        return out;
+    }
+    for (auto s : *sinks) {
+        out.push_back(events[s]);
+    }
+    return out;
+}
+
+void GraphRun::wait()
+{
+    if (!sinks) {
+        return;
+    }
+    for (auto s : *sinks) {
+        events[s]->wait();
+    }
+}
+
+GraphExec::GraphExec() : dev(nullptr) {}
+
+GraphRun GraphExec::replay(const KernelArgs &bindings, const std::vector<EventHandle> &deps)
+{
+    if (dev == nullptr) {
+        throw_lineexception("Replay of a graph that was never instantiated");
+    }
+    for (auto s : slots) {
+        if (!bindings.is_set(s)) {
+            throw_lineexception("Graph slot " + std::to_string(s) + " was not bound");
+        }
+    }
+
+    GraphRun run;
+    run.events.resize(steps.size());
+    run.sinks = sinks;
+
+    for (size_t n = 0; n < steps.size(); n++) {
+        Step &step = steps[n];
+
+        for (size_t i = 0; i < step.deps.size(); i++) {
+            step.wait_list[i] = run.events[step.deps[i]];
+        }
+        const std::vector<EventHandle> &wait_list = step.deps.empty() ? deps : step.wait_list;
+
+        if (step.is_task) {
+            for (auto &s : step.arg_slots) {
+                step.args.set_from(s.first, bindings, s.second);
+            }
+            run.events[n] = step.kernel->run(step.args, wait_list);
+        }
+        else {
+            for (auto &s : step.buf_slots) {
+                step.bufs[s.first] = bindings.buffer(s.second);
+            }
+            run.events[n] = dev->migrate(step.bufs, step.direction, wait_list);
+        }
+    }
+    return run;
+}
+
+const std::vector<unsigned int> &GraphExec::get_slots() const
+{
+    return slots;
+}
+
+void CommandGraph::check_deps(const std::vector<size_t> &deps) const
+{
+    for (auto d : deps) {
+        if (d >= nodes.size()) {
+            throw_lineexception("Graph nodes can only depend on nodes recorded before them");
+        }
+    }
+}
+
+size_t CommandGraph::migrate(const std::vector<GraphBuffer> &bufs,
+                             MigrateDirection direction,
+                             const std::vector<size_t> &deps)
+{
+    check_deps(deps);
+    Node node;
+    node.is_task   = false;
+    node.direction = direction;
+    node.bufs      = bufs;
+    node.deps      = deps;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t CommandGraph::task(const std::string &kernel, const GraphArgs &args, const std::vector<size_t> &deps)
+{
+    check_deps(deps);
+    Node node;
+    node.is_task = true;
+    node.kernel  = kernel;
+    node.args    = args;
+    node.deps    = deps;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t CommandGraph::size() const
+{
+    return nodes.size();
+}
+
+GraphExec CommandGraph::instantiate(DeviceBackend &dev) const
+{
+    GraphExec exec;
+    exec.dev = &dev;
+
+    std::vector<bool> has_dependents(nodes.size(), false);
+    for (size_t n = 0; n < nodes.size(); n++) {
+        const Node &node = nodes[n];
+        GraphExec::Step step;
+        step.is_task   = node.is_task;
+        step.direction = node.direction;
+
+        // Duplicates would only make the backend wait on an event twice
+        step.deps = node.deps;
+        std::sort(step.deps.begin(), step.deps.end());
+        step.deps.erase(std::unique(step.deps.begin(), step.deps.end()), step.deps.end());
+        for (auto d : step.deps) {
+            has_dependents[d] = true;
+        }
+        step.wait_list.resize(step.deps.size());
+
+        if (node.is_task) {
+            step.kernel    = dev.prepare_kernel(node.kernel, node.args.fixed);
+            step.arg_slots = node.args.slots;
+            for (auto &s : step.arg_slots) {
+                exec.slots.push_back(s.second);
+            }
+        }
+        else {
+            for (size_t i = 0; i < node.bufs.size(); i++) {
+                step.bufs.push_back(node.bufs[i].buf);
+                if (node.bufs[i].slot >= 0) {
+                    step.buf_slots.push_back(std::make_pair(i, (unsigned int)node.bufs[i].slot));
+                    exec.slots.push_back((unsigned int)node.bufs[i].slot);
+                }
+            }
+        }
+
+        exec.steps.push_back(step);
+    }
+
+    std::sort(exec.slots.begin(), exec.slots.end());
+    exec.slots.erase(std::unique(exec.slots.begin(), exec.slots.end()), exec.slots.end());
+
+    std::shared_ptr<std::vector<size_t>> sinks = std::make_shared<std::vector<size_t>>();
+    for (size_t n = 0; n < nodes.size(); n++) {
+        if (!has_dependents[n]) {
+            sinks->push_back(n);
+        }
+    }
+    exec.sinks = sinks;
+    return exec;
+}
+} // namespace example_utils
+} // namespace xilinx
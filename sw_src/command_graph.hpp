@@ -0,0 +1,164 @@
+#ifndef COMMAND_GRAPH_HPP__
+#define COMMAND_GRAPH_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// A value left open when a graph is recorded and supplied on each replay:
+// slot i is argument i of the KernelArgs passed to GraphExec::replay()
+struct GraphSlot
+{
+    unsigned int index;
+
+    explicit GraphSlot(unsigned int index) : index(index) {}
+};
+
+// A buffer operand of a recorded migration, fixed or bound on replay
+struct GraphBuffer
+{
+    BufferHandle buf;
+    int slot;
+
+    GraphBuffer(const BufferHandle &buf) : buf(buf), slot(-1) {}
+    GraphBuffer(GraphSlot slot) : slot((int)slot.index) {}
+};
+
+// Kernel arguments of a recorded task. Arguments set with a value are fixed
+// for every replay; arguments set with a GraphSlot are bound on replay.
+class GraphArgs
+{
+private:
+    KernelArgs fixed;
+    std::vector<std::pair<unsigned int, unsigned int>> slots;
+
+    friend class CommandGraph;
+
+public:
+    GraphArgs &set(unsigned int index, const BufferHandle &buf);
+    GraphArgs &set(unsigned int index, GraphSlot slot);
+
+    template <typename T>
+    GraphArgs &set(unsigned int index, T value)
+    {
+        fixed.set(index, value);
+        return *this;
+    }
+};
+
+// The events of one replay
+class GraphRun
+{
+private:
+    std::vector<EventHandle> events;
+    std::shared_ptr<const std::vector<size_t>> sinks;
+
+    friend class GraphExec;
+
+public:
+    // Event of the command recorded as node 'node'
+    const EventHandle &event(size_t node) const;
+
+    // Events of the commands nothing else in the graph waits for. Pass them
+    // as the dependencies of a later replay to chain runs.
+    std::vector<EventHandle> sink_events() const;
+
+    void wait();
+};
+
+// An instantiated graph, ready to replay
+class GraphExec
+{
+private:
+    // The buffer list, argument list and wait list of a step are built once
+    // and patched in place on each replay rather than rebuilt
+    struct Step
+    {
+        bool is_task;
+
+        // Migrations: buffer list with the slot-bound positions to patch
+        MigrateDirection direction;
+        std::vector<BufferHandle> bufs;
+        std::vector<std::pair<size_t, unsigned int>> buf_slots;
+
+        // Tasks: the slot-bound arguments, argument index <- slot
+        PreparedKernelHandle kernel;
+        KernelArgs args;
+        std::vector<std::pair<unsigned int, unsigned int>> arg_slots;
+
+        std::vector<size_t> deps;
+        std::vector<EventHandle> wait_list;
+    };
+
+    DeviceBackend *dev;
+    std::vector<Step> steps;
+    std::shared_ptr<const std::vector<size_t>> sinks;
+    std::vector<unsigned int> slots;
+
+    friend class CommandGraph;
+
+public:
+    GraphExec();
+
+    // Submits every recorded command with the slots taken from 'bindings'.
+    // Commands without recorded dependencies wait on 'deps'. The per-step
+    // lists are reused, so replays of one GraphExec must not run concurrently.
+    GraphRun replay(const KernelArgs &bindings, const std::vector<EventHandle> &deps = {});
+
+    // The slot indices replay() needs bound, in ascending order
+    const std::vector<unsigned int> &get_slots() const;
+};
+
+// Records migrations and kernel runs with their dependencies once, so that a
+// pipeline's per-iteration structure is declared rather than hand-chained
+// with event vectors.
+//
+// instantiate() does the per-graph work up front: dependency lists are
+// resolved to node indices, each task gets a PreparedKernel with its fixed
+// arguments applied, and the positions of open slots are tabulated. A replay
+// then only patches the slots and submits.
+//
+// Every command is still submitted to the backend on its own, so a replay
+// only saves the argument, buffer and wait list building of hand-chaining.
+//
+// Nodes can only depend on nodes recorded before them, so recording order is
+// always a valid submission order.
+class CommandGraph
+{
+private:
+    struct Node
+    {
+        bool is_task;
+        MigrateDirection direction;
+        std::vector<GraphBuffer> bufs;
+        std::string kernel;
+        GraphArgs args;
+        std::vector<size_t> deps;
+    };
+
+    std::vector<Node> nodes;
+
+    void check_deps(const std::vector<size_t> &deps) const;
+
+public:
+    // Each returns the new node's index
+    size_t migrate(const std::vector<GraphBuffer> &bufs,
+                   MigrateDirection direction,
+                   const std::vector<size_t> &deps = {});
+    size_t task(const std::string &kernel, const GraphArgs &args, const std::vector<size_t> &deps = {});
+
+    size_t size() const;
+
+    GraphExec instantiate(DeviceBackend &dev) const;
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // COMMAND_GRAPH_HPP__
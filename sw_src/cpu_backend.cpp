@@ -0,0 +1,264 @@
+#include "cpu_backend.hpp"
+
+#include "line_exception.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+namespace xilinx {
+namespace example_utils {
+class CpuBuffer : public BackendBuffer
+{
+private:
+    size_t bytes;
+    void *host;
+    void *device;
+
+    // Set for sub-buffers, which borrow their parent's storage
+    BufferHandle parent;
+
+public:
+    CpuBuffer(size_t size) : bytes(size), host(nullptr), device(nullptr)
+    {
+        // Page aligned like XRT's host allocations, so O_DIRECT and
+        // non-temporal copies into host_ptr() behave the same
+        if (posix_memalign(&host, 4096, size ? size : 1) != 0 ||
+            posix_memalign(&device, 4096, size ? size : 1) != 0) {
+            free(host);
+            throw std::bad_alloc();
+        }
+    }
+
+    CpuBuffer(const BufferHandle &parent, CpuBuffer *p, size_t offset, size_t size)
+        : bytes(size), host((char *)p->host + offset), device((char *)p->device + offset), parent(parent)
+    {
+    }
+
+    ~CpuBuffer()
+    {
+        if (!parent) {
+            free(host);
+            free(device);
+        }
+    }
+
+    size_t size() const override
+    {
+        return bytes;
+    }
+
+    void *host_ptr() override
+    {
+        return host;
+    }
+
+    void *device_ptr()
+    {
+        return device;
+    }
+};
+
+static CpuBuffer *as_cpu_buffer(const BufferHandle &buf)
+{
+    CpuBuffer *b = dynamic_cast<CpuBuffer *>(buf.get());
+    if (b == nullptr) {
+        throw_lineexception("Buffer was not created by a CpuBackend");
+    }
+    return b;
+}
+
+static double env_double(const char *name, double def)
+{
+    const char *val = getenv(name);
+    return (val && *val) ? strtod(val, NULL) : def;
+}
+
+CpuBackendConfig CpuBackendConfig::from_environment()
+{
+    CpuBackendConfig c;
+    c.h2d_gbps          = env_double("XCL_CPU_H2D_GBPS", c.h2d_gbps);
+    c.d2h_gbps          = env_double("XCL_CPU_D2H_GBPS", c.d2h_gbps);
+    c.launch_latency_us = env_double("XCL_CPU_LAUNCH_LATENCY_US", c.launch_latency_us);
+    c.compute_units     = (unsigned int)env_double("XCL_CPU_COMPUTE_UNITS", c.compute_units);
+    if (c.compute_units == 0) {
+        c.compute_units = 1;
+    }
+    return c;
+}
+
+CpuBackend::CpuBackend(const CpuBackendConfig &config)
+    : config(config), h2d_engine(1), d2h_engine(1),
+      compute_engine(config.compute_units ? config.compute_units : 1)
+{
+    register_builtin_kernels(*this);
+}
+
+CpuBackend::~CpuBackend()
+{
+    finish();
+}
+
+const char *CpuBackend::name() const
+{
+    return "CPU emulation";
+}
+
+BufferHandle CpuBackend::create_buffer(size_t size, BufferAccess /*access*/)
+{
+    return std::make_shared<CpuBuffer>(size);
+}
+
+BufferHandle CpuBackend::create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size)
+{
+    if (offset % 4096 != 0 || offset + size > parent->size()) {
+        throw_lineexception("Sub-buffer must start on a 4 KiB boundary and fit in its parent");
+    }
+    return std::make_shared<CpuBuffer>(parent, as_cpu_buffer(parent), offset, size);
+}
+
+void CpuBackend::bind_kernel_args(const std::string & /*kernel*/, const KernelArgs & /*args*/)
+{
+    // There is only one memory, so nothing to place
+}
+
+EventHandle CpuBackend::migrate(const std::vector<BufferHandle> &bufs,
+                                MigrateDirection direction,
+                                const std::vector<EventHandle> &deps)
+{
+    std::vector<std::pair<CpuBuffer *, BufferHandle>> targets;
+    for (auto &buf : bufs) {
+        targets.push_back(std::make_pair(as_cpu_buffer(buf), buf));
+    }
+    double gbps = (direction == MigrateDirection::ToDevice) ? config.h2d_gbps : config.d2h_gbps;
+
+    auto work = [targets, direction, gbps]() {
+        auto start   = std::chrono::steady_clock::now();
+        size_t total = 0;
+        for (auto &t : targets) {
+            CpuBuffer *b = t.first;
+            if (direction == MigrateDirection::ToDevice) {
+                memcpy(b->device_ptr(), b->host_ptr(), b->size());
+            }
+            else {
+                memcpy(b->host_ptr(), b->device_ptr(), b->size());
+            }
+            total += b->size();
+        }
+        // Hold the DMA engine for as long as the modelled link would take
+        if (gbps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration<double>(total / (gbps * 1.0e9)));
+        }
+    };
+
+    return tracker.submit(work, direction == MigrateDirection::ToDevice ? h2d_engine : d2h_engine, deps);
+}
+
+CpuBackend::KernelFn CpuBackend::find_kernel(const std::string &kernel)
+{
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    auto it = kernels.find(kernel);
+    if (it == kernels.end()) {
+        throw_lineexception("No CPU emulation registered for kernel " + kernel);
+    }
+    return it->second;
+}
+
+EventHandle CpuBackend::submit_kernel(const KernelFn &fn,
+                                      const KernelArgs &args,
+                                      const std::vector<EventHandle> &deps)
+{
+    for (size_t i = 0; i < args.count(); i++) {
+        if (args.is_buffer(i)) {
+            as_cpu_buffer(args.buffer(i));
+        }
+    }
+
+    double latency_us = config.launch_latency_us;
+
+    auto work = [fn, args, latency_us]() {
+        if (latency_us > 0) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(latency_us));
+        }
+        fn(args);
+    };
+
+    return tracker.submit(work, compute_engine, deps);
+}
+
+EventHandle CpuBackend::run_kernel(const std::string &kernel,
+                                   const KernelArgs &args,
+                                   const std::vector<EventHandle> &deps)
+{
+    return submit_kernel(find_kernel(kernel), args, deps);
+}
+
+// Looks the emulation up once and, like XrtPreparedKernel, keeps the
+// arguments of its latest run so each run only changes the indices it sets
+class CpuPreparedKernel : public PreparedKernel
+{
+private:
+    CpuBackend &backend;
+    CpuBackend::KernelFn fn;
+
+    std::mutex mutex;
+    KernelArgs current;
+
+public:
+    CpuPreparedKernel(CpuBackend &backend, const CpuBackend::KernelFn &fn, const KernelArgs &fixed)
+        : backend(backend), fn(fn), current(fixed)
+    {
+    }
+
+    EventHandle run(const KernelArgs &args, const std::vector<EventHandle> &deps) override
+    {
+        KernelArgs merged;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned int i = 0; i < args.count(); i++) {
+                if (args.is_set(i)) {
+                    current.set_from(i, args, i);
+                }
+            }
+            merged = current;
+        }
+        return backend.submit_kernel(fn, merged, deps);
+    }
+};
+
+PreparedKernelHandle CpuBackend::prepare_kernel(const std::string &kernel, const KernelArgs &fixed)
+{
+    return std::make_shared<CpuPreparedKernel>(*this, find_kernel(kernel), fixed);
+}
+
+void CpuBackend::finish()
+{
+    tracker.finish();
+}
+
+void CpuBackend::register_kernel(const std::string &name, KernelFn fn)
+{
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    kernels[name] = fn;
+}
+
+const CpuBackendConfig &CpuBackend::get_config() const
+{
+    return config;
+}
+
+void *CpuBackend::device_ptr(const BufferHandle &buf)
+{
+    return as_cpu_buffer(buf)->device_ptr();
+}
+
+void CpuBackend::check_access(const BufferHandle &buf, size_t bytes, const char *kernel)
+{
+    if (bytes > buf->size()) {
+        throw_lineexception(std::string("Kernel ") + kernel + " would access " +
+                            std::to_string(bytes) + " bytes of a " +
+                            std::to_string(buf->size()) + " byte buffer");
+    }
+}
+} // namespace example_utils
+} // namespace xilinx
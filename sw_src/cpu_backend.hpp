@@ -0,0 +1,105 @@
+#ifndef CPU_BACKEND_HPP__
+#define CPU_BACKEND_HPP__
+
+#pragma once
+
+#include "command_engine.hpp"
+#include "device_backend.hpp"
+
+#include <map>
+#include <mutex>
+
+namespace xilinx {
+namespace example_utils {
+class CpuPreparedKernel;
+
+struct CpuBackendConfig
+{
+    // Modelled DMA bandwidth per direction in GB/s; 0 copies at memcpy speed
+    double h2d_gbps = 12.0;
+    double d2h_gbps = 12.0;
+
+    // Modelled delay between a kernel becoming ready and starting to run
+    double launch_latency_us = 40.0;
+
+    // Number of kernel invocations that may run at the same time
+    unsigned int compute_units = 1;
+
+    // Overrides from XCL_CPU_H2D_GBPS, XCL_CPU_D2H_GBPS,
+    // XCL_CPU_LAUNCH_LATENCY_US and XCL_CPU_COMPUTE_UNITS where set
+    static CpuBackendConfig from_environment();
+};
+
+// Emulates the card in host memory. Every buffer has separate host and
+// "device" storage, so a missing migration shows up as wrong results just as
+// it would on hardware. Commands wait on their dependencies and then run on
+// one of three engines -- host to card DMA, card to host DMA and the compute
+// units -- each of which processes its commands in order, so transfers in
+// both directions and kernel execution overlap the way they do on the card.
+class CpuBackend : public DeviceBackend
+{
+public:
+    // An emulated kernel. Buffer arguments are accessed through device_ptr().
+    typedef std::function<void(const KernelArgs &)> KernelFn;
+
+private:
+    CpuBackendConfig config;
+
+    std::mutex kernel_mutex;
+    std::map<std::string, KernelFn> kernels;
+
+    CommandTracker tracker;
+
+    // Declared last so the engines stop before anything they use goes away
+    CommandEngine h2d_engine;
+    CommandEngine d2h_engine;
+    CommandEngine compute_engine;
+
+    KernelFn find_kernel(const std::string &kernel);
+    EventHandle submit_kernel(const KernelFn &fn, const KernelArgs &args, const std::vector<EventHandle> &deps);
+
+    friend class CpuPreparedKernel;
+
+public:
+    CpuBackend(const CpuBackendConfig &config = CpuBackendConfig());
+    ~CpuBackend();
+
+    const char *name() const override;
+
+    BufferHandle create_buffer(size_t size, BufferAccess access) override;
+    BufferHandle create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size) override;
+    void bind_kernel_args(const std::string &kernel, const KernelArgs &args) override;
+
+    EventHandle migrate(const std::vector<BufferHandle> &bufs,
+                        MigrateDirection direction,
+                        const std::vector<EventHandle> &deps = {}) override;
+
+    EventHandle run_kernel(const std::string &kernel,
+                           const KernelArgs &args,
+                           const std::vector<EventHandle> &deps = {}) override;
+
+    PreparedKernelHandle prepare_kernel(const std::string &kernel, const KernelArgs &fixed) override;
+
+    void finish() override;
+
+    // Adds or replaces the emulation of a kernel. The kernels built into
+    // alveo_examples.xclbin (see register_builtin_kernels()) are registered
+    // on construction.
+    void register_kernel(const std::string &name, KernelFn fn);
+
+    const CpuBackendConfig &get_config() const;
+
+    // Device-side storage of a buffer created by a CpuBackend
+    static void *device_ptr(const BufferHandle &buf);
+
+    // Throws if a kernel would touch more than the buffer holds, mirroring
+    // what would be a silent out-of-bounds access on the card
+    static void check_access(const BufferHandle &buf, size_t bytes, const char *kernel);
+};
+
+// Registers the emulations of the kernels in alveo_examples.xclbin
+void register_builtin_kernels(CpuBackend &backend);
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // CPU_BACKEND_HPP__
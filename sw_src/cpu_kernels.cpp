@@ -0,0 +1,306 @@
+#include "cpu_backend.hpp"
+
+#include "line_exception.hpp"
+#include "mailbox_vadd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Host C++ equivalents of the kernels in hw_src. They reproduce the kernels'
+// observable behaviour rather than their microarchitecture.
+
+namespace xilinx {
+namespace example_utils {
+// clSetKernelArg() fails with CL_INVALID_ARG_SIZE when a scalar is not the
+// width the kernel declares, so the emulation refuses it too
+static void check_scalar_size(const KernelArgs &args, unsigned int index, size_t bytes, const char *kernel)
+{
+    if (args.is_buffer(index) || args.scalar_size(index) != bytes) {
+        throw_lineexception(std::string("Argument ") + std::to_string(index) + " of " + kernel +
+                            " must be a " + std::to_string(bytes) + " byte scalar");
+    }
+}
+
+static void vadd_cpu(const KernelArgs &args)
+{
+    check_scalar_size(args, 3, sizeof(uint64_t), "vadd");
+    uint64_t size = args.get_uint(3);
+    if (size == 0) {
+        return;
+    }
+    CpuBackend::check_access(args.buffer(0), size * sizeof(uint32_t), "vadd");
+    CpuBackend::check_access(args.buffer(1), size * sizeof(uint32_t), "vadd");
+    CpuBackend::check_access(args.buffer(2), size * sizeof(uint32_t), "vadd");
+
+    const uint32_t *in1 = (const uint32_t *)CpuBackend::device_ptr(args.buffer(0));
+    const uint32_t *in2 = (const uint32_t *)CpuBackend::device_ptr(args.buffer(1));
+    uint32_t *out       = (uint32_t *)CpuBackend::device_ptr(args.buffer(2));
+    for (uint64_t i = 0; i < size; i++) {
+        out[i] = in1[i] + in2[i];
+    }
+}
+
+// The kernel processes a partial last word whole, so 'size' is rounded up to
+// 16 elements and the buffers must hold the padding
+static void wide_vadd_cpu(const KernelArgs &args)
+{
+    check_scalar_size(args, 3, sizeof(uint64_t), "wide_vadd");
+    uint64_t size = (args.get_uint(3) + 15) / 16 * 16;
+    size_t bytes  = size * sizeof(uint32_t);
+    CpuBackend::check_access(args.buffer(0), bytes, "wide_vadd");
+    CpuBackend::check_access(args.buffer(1), bytes, "wide_vadd");
+    CpuBackend::check_access(args.buffer(2), bytes, "wide_vadd");
+
+    const uint32_t *in1 = (const uint32_t *)CpuBackend::device_ptr(args.buffer(0));
+    const uint32_t *in2 = (const uint32_t *)CpuBackend::device_ptr(args.buffer(1));
+    uint32_t *out       = (uint32_t *)CpuBackend::device_ptr(args.buffer(2));
+    for (uint64_t i = 0; i < size; i++) {
+        out[i] = in1[i] + in2[i];
+    }
+}
+
+// Does nothing, so a run costs only the backend's modelled launch latency
+static void nop_cpu(const KernelArgs & /*args*/)
+{
+}
+
+// Polls the descriptor ring until a STOP record arrives, like the hardware
+// kernel. The ring is shared with migrations running on other threads, so
+// sequence numbers are read and written with acquire/release ordering.
+static void mailbox_vadd_cpu(const KernelArgs &args)
+{
+    check_scalar_size(args, 6, sizeof(uint64_t), "mailbox_vadd");
+    uint32_t ring_entries = (uint32_t)args.get_uint(5);
+    uint64_t capacity     = args.get_uint(6);
+    size_t bytes          = capacity * sizeof(uint32_t);
+    CpuBackend::check_access(args.buffer(0), bytes, "mailbox_vadd");
+    CpuBackend::check_access(args.buffer(1), bytes, "mailbox_vadd");
+    CpuBackend::check_access(args.buffer(2), bytes, "mailbox_vadd");
+    CpuBackend::check_access(args.buffer(3), ring_entries * sizeof(MailboxDescriptor), "mailbox_vadd");
+    CpuBackend::check_access(args.buffer(4), ring_entries * sizeof(MailboxCompletion), "mailbox_vadd");
+
+    const uint32_t *in1         = (const uint32_t *)CpuBackend::device_ptr(args.buffer(0));
+    const uint32_t *in2         = (const uint32_t *)CpuBackend::device_ptr(args.buffer(1));
+    uint32_t *out               = (uint32_t *)CpuBackend::device_ptr(args.buffer(2));
+    MailboxDescriptor *cmd_ring = (MailboxDescriptor *)CpuBackend::device_ptr(args.buffer(3));
+    MailboxCompletion *cpl_ring = (MailboxCompletion *)CpuBackend::device_ptr(args.buffer(4));
+
+    uint32_t head     = 0;
+    uint32_t expected = 1;
+    bool running      = true;
+    while (running) {
+        MailboxDescriptor *d = &cmd_ring[head];
+        if (__atomic_load_n(&d->seq, __ATOMIC_ACQUIRE) != expected ||
+            __atomic_load_n(&d->seq_check, __ATOMIC_ACQUIRE) != expected) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint32_t op     = d->op;
+        uint64_t first  = d->first;
+        uint64_t count  = d->count;
+        uint32_t status = MAILBOX_STATUS_OK;
+
+        if (op == MAILBOX_OP_STOP) {
+            running = false;
+        }
+        else if (op != MAILBOX_OP_VADD) {
+            status = MAILBOX_STATUS_BAD_OP;
+        }
+        else if (first % 16 != 0 || first > capacity || (count + 15) / 16 > (capacity - first) / 16) {
+            status = MAILBOX_STATUS_BAD_RANGE;
+        }
+        else {
+            // Whole words, like the kernel
+            for (uint64_t i = first; i < first + (count + 15) / 16 * 16; i++) {
+                out[i] = in1[i] + in2[i];
+            }
+        }
+
+        MailboxCompletion *r = &cpl_ring[head];
+        r->status            = status;
+        __atomic_store_n(&r->seq, expected, __ATOMIC_RELEASE);
+
+        head = (head + 1 == ring_entries) ? 0 : head + 1;
+        if (++expected == 0) {
+            expected = 1;
+        }
+    }
+}
+
+// Contributions of source pixels to one output pixel along one axis for an
+// area (box filter) resize
+struct AreaTap
+{
+    int index;
+    float weight;
+};
+
+static std::vector<std::vector<AreaTap>> area_taps(int size_in, int size_out)
+{
+    std::vector<std::vector<AreaTap>> taps(size_out);
+    double scale = (double)size_in / size_out;
+    for (int o = 0; o < size_out; o++) {
+        double start = o * scale;
+        double end   = std::min((o + 1) * scale, (double)size_in);
+        double span  = end - start;
+        for (int i = (int)start; i < end; i++) {
+            double overlap = std::min(end, i + 1.0) - std::max(start, (double)i);
+            if (overlap > 0) {
+                taps[o].push_back({i, (float)(overlap / span)});
+            }
+        }
+    }
+    return taps;
+}
+
+// Packed 8-bit BGR images, as moved by Array2xfMat/xfMat2Array
+static void resize_area_rgb(const uint8_t *in, int width_in, int height_in,
+                            float *out, int width_out, int height_out)
+{
+    auto x_taps = area_taps(width_in, width_out);
+    auto y_taps = area_taps(height_in, height_out);
+
+    std::vector<float> row(width_in * 3);
+    for (int y = 0; y < height_out; y++) {
+        std::fill(row.begin(), row.end(), 0.0f);
+        for (auto &ty : y_taps[y]) {
+            const uint8_t *src = in + (size_t)ty.index * width_in * 3;
+            for (int i = 0; i < width_in * 3; i++) {
+                row[i] += ty.weight * src[i];
+            }
+        }
+        float *dst = out + (size_t)y * width_out * 3;
+        for (int x = 0; x < width_out; x++) {
+            float acc[3] = {0.0f, 0.0f, 0.0f};
+            for (auto &tx : x_taps[x]) {
+                for (int c = 0; c < 3; c++) {
+                    acc[c] += tx.weight * row[tx.index * 3 + c];
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                dst[x * 3 + c] = acc[c];
+            }
+        }
+    }
+}
+
+static void store_rgb(const float *in, uint8_t *out, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (uint8_t)std::min(255.0f, std::max(0.0f, std::round(in[i])));
+    }
+}
+
+// Separable Gaussian with a constant (zero) border
+static void gaussian_blur_rgb(std::vector<float> &img, int width, int height, int taps, float sigma)
+{
+    int half = taps / 2;
+    std::vector<float> k(taps);
+    float sum = 0.0f;
+    for (int i = 0; i < taps; i++) {
+        k[i] = std::exp(-((i - half) * (i - half)) / (2.0f * sigma * sigma));
+        sum += k[i];
+    }
+    for (auto &v : k) {
+        v /= sum;
+    }
+
+    std::vector<float> tmp(img.size());
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                float acc = 0.0f;
+                for (int i = 0; i < taps; i++) {
+                    int xs = x + i - half;
+                    if (xs >= 0 && xs < width) {
+                        acc += k[i] * img[((size_t)y * width + xs) * 3 + c];
+                    }
+                }
+                tmp[((size_t)y * width + x) * 3 + c] = acc;
+            }
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                float acc = 0.0f;
+                for (int i = 0; i < taps; i++) {
+                    int ys = y + i - half;
+                    if (ys >= 0 && ys < height) {
+                        acc += k[i] * tmp[((size_t)ys * width + x) * 3 + c];
+                    }
+                }
+                img[((size_t)y * width + x) * 3 + c] = acc;
+            }
+        }
+    }
+}
+
+static void check_dimensions(const KernelArgs &args, int max_width, int max_height, const char *kernel)
+{
+    for (unsigned int i = 2; i < 6; i += 2) {
+        int64_t w = args.get_int(i);
+        int64_t h = args.get_int(i + 1);
+        if (w <= 0 || h <= 0 || w > max_width || h > max_height) {
+            throw_lineexception(std::string("Image dimensions out of range for ") + kernel);
+        }
+        // Both kernels move eight pixels per clock (XF_NPPC8)
+        if (w % 8 != 0) {
+            throw_lineexception(std::string("Image widths must be multiples of 8 for ") + kernel);
+        }
+    }
+    // ... and are built with MAX_DOWN_SCALE 7
+    if (args.get_int(2) > 7 * args.get_int(4) || args.get_int(3) > 7 * args.get_int(5)) {
+        throw_lineexception(std::string("Downscale by more than 7 requested from ") + kernel);
+    }
+}
+
+static void resize_accel_rgb_cpu(const KernelArgs &args)
+{
+    check_dimensions(args, 3840, 2160, "resize_accel_rgb");
+    int width_in   = (int)args.get_int(2);
+    int height_in  = (int)args.get_int(3);
+    int width_out  = (int)args.get_int(4);
+    int height_out = (int)args.get_int(5);
+    size_t out_px  = (size_t)width_out * height_out * 3;
+    CpuBackend::check_access(args.buffer(0), (size_t)width_in * height_in * 3, "resize_accel_rgb");
+    CpuBackend::check_access(args.buffer(1), out_px, "resize_accel_rgb");
+
+    std::vector<float> resized(out_px);
+    resize_area_rgb((const uint8_t *)CpuBackend::device_ptr(args.buffer(0)), width_in, height_in,
+                    resized.data(), width_out, height_out);
+    store_rgb(resized.data(), (uint8_t *)CpuBackend::device_ptr(args.buffer(1)), out_px);
+}
+
+static void resize_blur_rgb_cpu(const KernelArgs &args)
+{
+    check_dimensions(args, 1920, 1080, "resize_blur_rgb");
+    int width_in   = (int)args.get_int(2);
+    int height_in  = (int)args.get_int(3);
+    int width_out  = (int)args.get_int(4);
+    int height_out = (int)args.get_int(5);
+    float sigma    = args.get_float(6);
+    size_t out_px  = (size_t)width_out * height_out * 3;
+    CpuBackend::check_access(args.buffer(0), (size_t)width_in * height_in * 3, "resize_blur_rgb");
+    CpuBackend::check_access(args.buffer(1), out_px, "resize_blur_rgb");
+
+    std::vector<float> resized(out_px);
+    resize_area_rgb((const uint8_t *)CpuBackend::device_ptr(args.buffer(0)), width_in, height_in,
+                    resized.data(), width_out, height_out);
+    gaussian_blur_rgb(resized, width_out, height_out, 7, sigma);
+    store_rgb(resized.data(), (uint8_t *)CpuBackend::device_ptr(args.buffer(1)), out_px);
+}
+
+void register_builtin_kernels(CpuBackend &backend)
+{
+    backend.register_kernel("vadd", vadd_cpu);
+    backend.register_kernel("wide_vadd", wide_vadd_cpu);
+    backend.register_kernel("mailbox_vadd", mailbox_vadd_cpu);
+    backend.register_kernel("nop", nop_cpu);
+    backend.register_kernel("resize_accel_rgb", resize_accel_rgb_cpu);
+    backend.register_kernel("resize_blur_rgb", resize_blur_rgb_cpu);
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,278 @@
+#include "deadline_scheduler.hpp"
+
+#include "line_exception.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace xilinx {
+namespace example_utils {
+const char *job_class_name(JobClass cls)
+{
+    switch (cls) {
+    case JobClass::Critical:
+        return "Critical";
+    case JobClass::Normal:
+        return "Normal";
+    default:
+        return "Bulk";
+    }
+}
+
+double ClassStats::miss_rate() const
+{
+    return jobs ? (double)missed / jobs : 0.0;
+}
+
+DeadlineScheduler::DeadlineScheduler(DeviceBackend &dev, const DeadlineSchedulerConfig &config)
+    : dev(dev), config(config), in_flight(0), next_seq(0), stopping(false)
+{
+    if (this->config.max_in_flight == 0) {
+        this->config.max_in_flight = 1;
+    }
+    dispatcher = std::thread(&DeadlineScheduler::dispatcher_main, this);
+}
+
+DeadlineScheduler::~DeadlineScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    dispatcher.join();
+}
+
+std::future<JobOutcome> DeadlineScheduler::submit(JobClass cls,
+                                                  std::chrono::steady_clock::time_point deadline,
+                                                  std::vector<JobStep> steps)
+{
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->cls         = cls;
+    job->arrival     = std::chrono::steady_clock::now();
+    job->deadline    = deadline;
+    job->steps       = std::move(steps);
+    job->next_step   = 0;
+    job->outstanding = 0;
+    std::future<JobOutcome> fut = job->done.get_future();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) {
+        throw_lineexception("Scheduler is shutting down");
+    }
+    job->seq = next_seq++;
+    jobs.push_back(job);
+    if (job->steps.empty()) {
+        finish_job(job);
+    }
+    cv.notify_all();
+    return fut;
+}
+
+std::future<JobOutcome> DeadlineScheduler::submit(JobClass cls, std::chrono::microseconds budget, std::vector<JobStep> steps)
+{
+    return submit(cls, std::chrono::steady_clock::now() + budget, std::move(steps));
+}
+
+bool DeadlineScheduler::runs_before(const Job &a, const Job &b) const
+{
+    if (config.policy == SchedulePolicy::Deadline) {
+        if (a.cls != b.cls) {
+            return a.cls < b.cls;
+        }
+        if (a.deadline != b.deadline) {
+            return a.deadline < b.deadline;
+        }
+    }
+    return a.seq < b.seq;
+}
+
+std::shared_ptr<DeadlineScheduler::Job> DeadlineScheduler::pick_job()
+{
+    // Queues are short, so a scan beats keeping a heap ordered as jobs
+    // drain and fail
+    std::shared_ptr<Job> best;
+    for (auto &job : jobs) {
+        if (job->next_step == job->steps.size() || job->error) {
+            continue;
+        }
+        if (!best || runs_before(*job, *best)) {
+            best = job;
+        }
+    }
+    return best;
+}
+
+void DeadlineScheduler::dispatcher_main()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        std::shared_ptr<Job> job;
+        cv.wait(lock, [&] {
+            if (in_flight < config.max_in_flight) {
+                job = pick_job();
+            }
+            return job || (stopping && jobs.empty());
+        });
+        if (!job) {
+            return;
+        }
+
+        JobStep step = std::move(job->steps[job->next_step++]);
+        job->outstanding++;
+        in_flight++;
+        lock.unlock();
+
+        EventHandle event;
+        std::exception_ptr err;
+        try {
+            event = step(dev);
+            if (!event) {
+                throw_lineexception("Job step submitted no commands");
+            }
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+
+        if (event) {
+            event->on_complete([this, job, event]() {
+                step_done(job, event);
+            });
+        }
+        lock.lock();
+        if (err) {
+            job->error = err;
+            job->outstanding--;
+            in_flight--;
+            if (job->outstanding == 0) {
+                finish_job(job);
+            }
+            cv.notify_all();
+        }
+    }
+}
+
+void DeadlineScheduler::step_done(const std::shared_ptr<Job> &job, const EventHandle &event)
+{
+    // Runs inside the event's completion callback, where blocking calls such
+    // as clWaitForEvents() are not allowed, so the error is only queried
+    std::exception_ptr err = event->get_error();
+
+    // Notified under the lock: once it is released the destructor may run
+    std::lock_guard<std::mutex> lock(mutex);
+    if (err && !job->error) {
+        job->error = err;
+    }
+    job->outstanding--;
+    in_flight--;
+    if (job->outstanding == 0 && (job->next_step == job->steps.size() || job->error)) {
+        finish_job(job);
+    }
+    cv.notify_all();
+}
+
+void DeadlineScheduler::finish_job(const std::shared_ptr<Job> &job)
+{
+    jobs.erase(std::find(jobs.begin(), jobs.end(), job));
+
+    ClassStats &s = stats[(int)job->cls];
+    if (job->error) {
+        s.failed++;
+        job->done.set_exception(job->error);
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    JobOutcome outcome;
+    outcome.met_deadline = now <= job->deadline;
+    outcome.latency      = std::chrono::duration_cast<std::chrono::nanoseconds>(now - job->arrival);
+
+    s.jobs++;
+    if (!outcome.met_deadline) {
+        s.missed++;
+    }
+    s.latency.record(outcome.latency.count());
+    job->done.set_value(outcome);
+}
+
+void DeadlineScheduler::drain()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return jobs.empty() && in_flight == 0; });
+}
+
+ClassStats DeadlineScheduler::get_stats(JobClass cls) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats[(int)cls];
+}
+
+void DeadlineScheduler::reset_stats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &s : stats) {
+        s = ClassStats();
+    }
+}
+
+void DeadlineScheduler::print_stats(std::ostream &os) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ios_base::fmtflags flags(os.flags());
+    os << std::left << std::setw(10) << "Class" << std::right << std::setw(8) << "Jobs"
+       << std::setw(8) << "Missed" << std::setw(10) << "Miss (%)" << std::setw(8) << "Failed"
+       << std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)" << std::setw(12) << "Max (us)" << std::endl;
+    os << std::fixed << std::setprecision(1);
+    for (int c = 0; c < NUM_JOB_CLASSES; c++) {
+        const ClassStats &s = stats[c];
+        if (s.jobs == 0 && s.failed == 0) {
+            continue;
+        }
+        os << std::left << std::setw(10) << job_class_name((JobClass)c) << std::right
+           << std::setw(8) << s.jobs << std::setw(8) << s.missed << std::setw(10) << s.miss_rate() * 100.0
+           << std::setw(8) << s.failed
+           << std::setw(12) << s.latency.value_at_percentile(50.0) / 1000.0
+           << std::setw(12) << s.latency.value_at_percentile(99.0) / 1000.0
+           << std::setw(12) << s.latency.max() / 1000.0 << std::endl;
+    }
+    os.flags(flags);
+}
+
+std::vector<JobStep> chunked_vadd_steps(const BufferHandle &a,
+                                        const BufferHandle &b,
+                                        const BufferHandle &c,
+                                        uint64_t count,
+                                        size_t chunk_bytes)
+{
+    // wide_vadd processes a partial last word whole, so the buffers need the
+    // padding up to the next 64 bytes
+    size_t bytes  = count * sizeof(uint32_t);
+    size_t padded = (bytes + 63) / 64 * 64;
+    if (padded > a->size() || padded > b->size() || padded > c->size()) {
+        throw_lineexception("Vector length exceeds the buffers");
+    }
+
+    // Sub-buffer origins must be 4 KiB aligned
+    chunk_bytes = std::max(chunk_bytes / 4096 * 4096, (size_t)4096);
+
+    std::vector<JobStep> steps;
+    for (size_t offset = 0; offset < bytes; offset += chunk_bytes) {
+        size_t size     = std::min(chunk_bytes, bytes - offset);
+        size_t sub_size = std::min(chunk_bytes, padded - offset);
+        steps.push_back([a, b, c, offset, size, sub_size](DeviceBackend &dev) {
+            BufferHandle sa = dev.create_sub_buffer(a, offset, sub_size);
+            BufferHandle sb = dev.create_sub_buffer(b, offset, sub_size);
+            BufferHandle sc = dev.create_sub_buffer(c, offset, sub_size);
+
+            KernelArgs args;
+            args.set(0, sa).set(1, sb).set(2, sc).set(3, (uint64_t)(size / sizeof(uint32_t)));
+            EventHandle to_dev = dev.migrate({sa, sb}, MigrateDirection::ToDevice);
+            EventHandle run    = dev.run_kernel("wide_vadd", args, {to_dev});
+            return dev.migrate({sc}, MigrateDirection::ToHost, {run});
+        });
+    }
+    return steps;
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,166 @@
+#ifndef DEADLINE_SCHEDULER_HPP__
+#define DEADLINE_SCHEDULER_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+#include "latency_histogram.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Scheduling classes, most urgent first. A job only runs while no job of a
+// more urgent class has work waiting.
+enum class JobClass {
+    Critical, // Latency SLO, e.g. interactive image requests
+    Normal,
+    Bulk // Throughput only; should be split into many steps
+};
+
+#define NUM_JOB_CLASSES 3
+
+const char *job_class_name(JobClass cls);
+
+// One unit of device work, and the point between which a job can be
+// preempted: submits its commands and returns the event of the last one.
+// Commands already submitted cannot be recalled, so a job holds the device
+// for at most one step's worth of time after more urgent work arrives.
+typedef std::function<EventHandle(DeviceBackend &)> JobStep;
+
+struct JobOutcome
+{
+    bool met_deadline;
+
+    // From submit() until the job's last step completed
+    std::chrono::nanoseconds latency;
+};
+
+struct ClassStats
+{
+    uint64_t jobs   = 0;
+    uint64_t missed = 0;
+    uint64_t failed = 0;
+    LatencyHistogram latency;
+
+    // Fraction of completed jobs that finished after their deadline
+    double miss_rate() const;
+};
+
+enum class SchedulePolicy {
+    Fifo,    // Arrival order, ignoring classes and deadlines; a baseline
+    Deadline // By class, then earliest deadline first
+};
+
+struct DeadlineSchedulerConfig
+{
+    SchedulePolicy policy = SchedulePolicy::Deadline;
+
+    // Steps submitted to the device and not yet complete. Two keeps the DMA
+    // engines and compute units overlapped; more lets bulk work queue deeper
+    // inside the runtime, where urgent work cannot overtake it.
+    unsigned int max_in_flight = 2;
+};
+
+// Orders jobs from many threads onto one device by priority class and,
+// within a class, earliest deadline first.
+//
+// Every backend runs commands in the order they become ready, so the only
+// place work can be reordered is before it is submitted. The scheduler
+// therefore holds jobs on the host and feeds their steps to the device one
+// at a time, keeping at most 'max_in_flight' outstanding; each time a step
+// completes, the most urgent waiting step goes next. Bulk jobs built with
+// chunked_vadd_steps() give way to urgent jobs after every chunk.
+//
+// Each job's steps are submitted in order, but a step may be submitted
+// before the previous one completes; steps that depend on each other must
+// say so through the runtime (e.g. by sharing an in-order engine).
+class DeadlineScheduler
+{
+private:
+    struct Job
+    {
+        JobClass cls;
+        std::chrono::steady_clock::time_point arrival;
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t seq;
+        std::vector<JobStep> steps;
+        size_t next_step;
+        unsigned int outstanding;
+        std::exception_ptr error;
+        std::promise<JobOutcome> done;
+    };
+
+    DeviceBackend &dev;
+    DeadlineSchedulerConfig config;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<Job>> jobs;
+    unsigned int in_flight;
+    uint64_t next_seq;
+    bool stopping;
+    ClassStats stats[NUM_JOB_CLASSES];
+
+    void dispatcher_main();
+    std::shared_ptr<Job> pick_job();
+    bool runs_before(const Job &a, const Job &b) const;
+    void step_done(const std::shared_ptr<Job> &job, const EventHandle &event);
+    void finish_job(const std::shared_ptr<Job> &job);
+
+    // Declared last so it starts after everything above is constructed
+    std::thread dispatcher;
+
+public:
+    DeadlineScheduler(DeviceBackend &dev, const DeadlineSchedulerConfig &config = DeadlineSchedulerConfig());
+
+    // Completes every job already submitted
+    ~DeadlineScheduler();
+
+    DeadlineScheduler(const DeadlineScheduler &) = delete;
+    DeadlineScheduler &operator=(const DeadlineScheduler &) = delete;
+
+    // Queues a job. Thread safe. The future holds the job's outcome once its
+    // last step has completed, or the first error a step threw or reported.
+    std::future<JobOutcome> submit(JobClass cls,
+                                   std::chrono::steady_clock::time_point deadline,
+                                   std::vector<JobStep> steps);
+
+    // As above with the deadline 'budget' after now
+    std::future<JobOutcome> submit(JobClass cls, std::chrono::microseconds budget, std::vector<JobStep> steps);
+
+    // Blocks until every job submitted so far has completed
+    void drain();
+
+    ClassStats get_stats(JobClass cls) const;
+    void reset_stats();
+
+    // One line per class that has run jobs: count, misses and latency
+    void print_stats(std::ostream &os) const;
+};
+
+// c[i] = a[i] + b[i] for 'count' elements as one step per chunk of about
+// 'chunk_bytes' per operand. Chunks are sub-buffers starting on 4 KiB
+// boundaries, as subdivide_buffer() makes them, with the last taking the
+// remainder; each migrates its inputs, runs wide_vadd and migrates its
+// result back. The buffers must also hold the padding up to the next 64
+// bytes, which wide_vadd overwrites.
+std::vector<JobStep> chunked_vadd_steps(const BufferHandle &a,
+                                        const BufferHandle &b,
+                                        const BufferHandle &c,
+                                        uint64_t count,
+                                        size_t chunk_bytes);
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // DEADLINE_SCHEDULER_HPP__
@@ -0,0 +1,221 @@
+#include "device_arena.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace xilinx {
+namespace example_utils {
+DeviceArena::DeviceArena(XilinxOclHelper &xocl,
+                         int bank,
+                         size_t capacity_in,
+                         cl_mem_flags flags,
+                         size_t min_block_in)
+    : capacity(capacity_in), min_block(min_block_in)
+{
+    backing = xocl.create_buffer_in_bank(bank, capacity, flags);
+    init_free_lists();
+}
+
+DeviceArena::DeviceArena(XilinxOclHelper &xocl,
+                         cl::CommandQueue &q,
+                         cl::Kernel &krnl,
+                         int arg_index,
+                         size_t capacity_in,
+                         cl_mem_flags flags,
+                         size_t min_block_in)
+    : capacity(capacity_in), min_block(min_block_in)
+{
+    backing = xocl.create_buffer(capacity, flags);
+
+    // Setting the buffer as a kernel argument lets XRT resolve which bank it
+    // belongs in; the migration then forces the device allocation to happen
+    // now rather than on the first request
+    krnl.setArg(arg_index, backing);
+    q.enqueueMigrateMemObjects({backing}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED);
+    q.finish();
+
+    init_free_lists();
+}
+
+size_t DeviceArena::block_size(unsigned int order) const
+{
+    return min_block << order;
+}
+
+void DeviceArena::init_free_lists()
+{
+    if (min_block < 4096 || (min_block & (min_block - 1)) != 0) {
+        throw_lineexception("Arena minimum block size must be a power of two of at least 4 KiB");
+    }
+
+    capacity -= capacity % min_block;
+    if (capacity == 0) {
+        throw_lineexception("Arena capacity is smaller than its minimum block size");
+    }
+
+    max_order = 0;
+    while (block_size(max_order + 1) <= capacity) {
+        max_order++;
+    }
+    free_lists.resize(max_order + 1);
+
+    // Carve the capacity into the largest naturally aligned blocks that fit,
+    // so capacities that are not a power of two are still fully usable
+    size_t offset = 0;
+    for (int order = max_order; order >= 0; order--) {
+        while (offset + block_size(order) <= capacity) {
+            free_lists[order].insert(offset);
+            offset += block_size(order);
+        }
+    }
+
+    allocated_bytes    = 0;
+    requested_bytes    = 0;
+    peak_allocated     = 0;
+    failed_allocations = 0;
+}
+
+cl::Buffer DeviceArena::allocate(size_t size, cl_mem_flags flags)
+{
+    if (size == 0) {
+        throw_lineexception("Attempted to allocate an empty region from a device arena");
+    }
+
+    size_t offset;
+    unsigned int order = 0;
+    {
+        std::lock_guard<std::mutex> lock(m);
+
+        while (order <= max_order && block_size(order) < size) {
+            order++;
+        }
+
+        // Find the smallest free block that is large enough
+        unsigned int found = order;
+        while (found <= max_order && free_lists[found].empty()) {
+            found++;
+        }
+        if (found > max_order) {
+            failed_allocations++;
+            throw_lineexception("Device arena exhausted");
+        }
+
+        offset = *free_lists[found].begin();
+        free_lists[found].erase(free_lists[found].begin());
+
+        // Split it down to the requested order, returning the upper halves
+        while (found > order) {
+            found--;
+            free_lists[found].insert(offset + block_size(found));
+        }
+
+        live[offset] = std::make_pair(order, size);
+        allocated_bytes += block_size(order);
+        requested_bytes += size;
+        if (allocated_bytes > peak_allocated) {
+            peak_allocated = allocated_bytes;
+        }
+    }
+
+    cl_buffer_region region;
+    region.origin = offset;
+    region.size   = size;
+
+    cl_int err;
+    cl::Buffer buf = backing.createSubBuffer(flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+    if (err != CL_SUCCESS) {
+        std::lock_guard<std::mutex> lock(m);
+        live.erase(offset);
+        allocated_bytes -= block_size(order);
+        requested_bytes -= size;
+        free_lists[order].insert(offset);
+        throw_lineexception("Unable to create sub-buffer in device arena");
+    }
+    return buf;
+}
+
+void DeviceArena::release(const cl::Buffer &buf)
+{
+    size_t offset = buf.getInfo<CL_MEM_OFFSET>();
+
+    std::lock_guard<std::mutex> lock(m);
+    auto it = live.find(offset);
+    if (it == live.end()) {
+        throw_lineexception("Released buffer was not allocated from this arena");
+    }
+
+    unsigned int order = it->second.first;
+    allocated_bytes -= block_size(order);
+    requested_bytes -= it->second.second;
+    live.erase(it);
+
+    // Coalesce with free buddies as far up as possible
+    while (order < max_order) {
+        size_t buddy = offset ^ block_size(order);
+        auto b       = free_lists[order].find(buddy);
+        if (b == free_lists[order].end()) {
+            break;
+        }
+        free_lists[order].erase(b);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    free_lists[order].insert(offset);
+}
+
+ArenaStats DeviceArena::get_stats()
+{
+    std::lock_guard<std::mutex> lock(m);
+
+    ArenaStats stats;
+    stats.capacity           = capacity;
+    stats.requested_bytes    = requested_bytes;
+    stats.allocated_bytes    = allocated_bytes;
+    stats.peak_allocated     = peak_allocated;
+    stats.free_bytes         = capacity - allocated_bytes;
+    stats.live_allocations   = live.size();
+    stats.failed_allocations = failed_allocations;
+
+    stats.largest_free_block = 0;
+    for (int order = max_order; order >= 0; order--) {
+        if (!free_lists[order].empty()) {
+            stats.largest_free_block = block_size(order);
+            break;
+        }
+    }
+
+    stats.external_fragmentation = 0.0;
+    if (stats.free_bytes > 0) {
+        stats.external_fragmentation = 1.0 - (double)stats.largest_free_block / stats.free_bytes;
+    }
+    stats.internal_fragmentation = 0.0;
+    if (allocated_bytes > 0) {
+        stats.internal_fragmentation = 1.0 - (double)requested_bytes / allocated_bytes;
+    }
+    return stats;
+}
+
+void DeviceArena::print_stats()
+{
+    ArenaStats s = get_stats();
+
+    std::ios_base::fmtflags flags(std::cout.flags());
+    std::cout << std::fixed << std::setprecision(2)
+              << "  Capacity               : " << s.capacity / (1024.0 * 1024.0) << " MiB" << std::endl
+              << "  Allocated (peak)       : " << s.allocated_bytes / (1024.0 * 1024.0) << " MiB ("
+              << s.peak_allocated / (1024.0 * 1024.0) << " MiB)" << std::endl
+              << "  Live allocations       : " << s.live_allocations << std::endl
+              << "  Failed allocations     : " << s.failed_allocations << std::endl
+              << "  Largest free block     : " << s.largest_free_block / (1024.0 * 1024.0) << " MiB" << std::endl
+              << "  External fragmentation : " << 100.0 * s.external_fragmentation << " %" << std::endl
+              << "  Internal fragmentation : " << 100.0 * s.internal_fragmentation << " %" << std::endl;
+    std::cout.flags(flags);
+}
+
+const cl::Buffer &DeviceArena::get_backing_buffer() const
+{
+    return backing;
+}
+} // namespace example_utils
+} // namespace xilinx
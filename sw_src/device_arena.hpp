@@ -0,0 +1,90 @@
+#ifndef DEVICE_ARENA_HPP__
+#define DEVICE_ARENA_HPP__
+
+#pragma once
+
+#include "xilinx_ocl_helper.hpp"
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+struct ArenaStats
+{
+    size_t capacity;           // bytes managed by the arena
+    size_t requested_bytes;    // bytes asked for by live allocations
+    size_t allocated_bytes;    // bytes handed out, including rounding
+    size_t peak_allocated;     // high-water mark of allocated_bytes
+    size_t free_bytes;         // capacity - allocated_bytes
+    size_t largest_free_block; // biggest single allocation that can succeed
+    size_t live_allocations;
+    size_t failed_allocations;
+
+    // Share of the free space that is NOT usable by one large allocation
+    // (0 = all free space is one block)
+    double external_fragmentation;
+    // Share of the allocated space lost to power-of-two rounding
+    double internal_fragmentation;
+};
+
+// Reserves one large buffer in a device memory bank up front and hands out
+// aligned regions of it as sub-buffers, the same mechanism subdivide_buffer()
+// uses in examples 5 and 6. Regions are managed by a binary buddy allocator,
+// so the arena's footprint is fixed however many requests come and go.
+// All members are thread-safe.
+class DeviceArena
+{
+private:
+    cl::Buffer backing;
+    size_t capacity;
+    size_t min_block;
+    unsigned int max_order;
+
+    std::mutex m;
+    std::vector<std::set<size_t>> free_lists; // per order, offsets of free blocks
+    std::map<size_t, std::pair<unsigned int, size_t>> live; // offset -> (order, requested)
+    size_t allocated_bytes;
+    size_t requested_bytes;
+    size_t peak_allocated;
+    size_t failed_allocations;
+
+    void init_free_lists();
+    size_t block_size(unsigned int order) const;
+
+public:
+    // Reserves 'capacity' bytes in the given memory bank (memory topology index)
+    DeviceArena(XilinxOclHelper &xocl,
+                int bank,
+                size_t capacity,
+                cl_mem_flags flags = CL_MEM_READ_WRITE,
+                size_t min_block   = 4096);
+
+    // Reserves 'capacity' bytes in whichever bank is connected to argument
+    // 'arg_index' of 'krnl', letting XRT resolve the connectivity
+    DeviceArena(XilinxOclHelper &xocl,
+                cl::CommandQueue &q,
+                cl::Kernel &krnl,
+                int arg_index,
+                size_t capacity,
+                cl_mem_flags flags = CL_MEM_READ_WRITE,
+                size_t min_block   = 4096);
+
+    // Returns a sub-buffer of at least 'size' bytes, aligned to its rounded
+    // size. Throws if the arena cannot satisfy the request.
+    cl::Buffer allocate(size_t size, cl_mem_flags flags);
+
+    // Returns a region obtained from allocate() to the arena
+    void release(const cl::Buffer &buf);
+
+    ArenaStats get_stats();
+    void print_stats();
+
+    const cl::Buffer &get_backing_buffer() const;
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // DEVICE_ARENA_HPP__
@@ -0,0 +1,206 @@
+#include "device_backend.hpp"
+
+#include "cpu_backend.hpp"
+#include "line_exception.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+#ifdef XILINX_EXAMPLES_HAVE_XRT
+#include "ocl_backend.hpp"
+#include "xrt_backend.hpp"
+#endif
+
+namespace xilinx {
+namespace example_utils {
+KernelArgs::Arg &KernelArgs::slot(unsigned int index)
+{
+    if (index >= args.size()) {
+        args.resize(index + 1);
+    }
+    return args[index];
+}
+
+const KernelArgs::Arg &KernelArgs::get_arg(unsigned int index) const
+{
+    if (index >= args.size() || (!args[index].buf && args[index].num_bytes == 0)) {
+        throw_lineexception("Kernel argument " + std::to_string(index) + " was not set");
+    }
+    return args[index];
+}
+
+KernelArgs &KernelArgs::set(unsigned int index, const BufferHandle &buf)
+{
+    Arg &a      = slot(index);
+    a.buf       = buf;
+    a.num_bytes = 0;
+    return *this;
+}
+
+KernelArgs &KernelArgs::set_from(unsigned int index, const KernelArgs &other, unsigned int other_index)
+{
+    slot(index) = other.get_arg(other_index);
+    return *this;
+}
+
+size_t KernelArgs::count() const
+{
+    return args.size();
+}
+
+bool KernelArgs::is_set(unsigned int index) const
+{
+    return index < args.size() && (args[index].buf || args[index].num_bytes != 0);
+}
+
+bool KernelArgs::same_as(unsigned int index, const KernelArgs &other) const
+{
+    if (!is_set(index) || !other.is_set(index)) {
+        return false;
+    }
+    const Arg &mine   = args[index];
+    const Arg &theirs = other.args[index];
+    if (mine.buf || theirs.buf) {
+        return mine.buf == theirs.buf;
+    }
+    return mine.num_bytes == theirs.num_bytes && memcmp(mine.bytes, theirs.bytes, mine.num_bytes) == 0;
+}
+
+bool KernelArgs::is_buffer(unsigned int index) const
+{
+    return (bool)get_arg(index).buf;
+}
+
+const BufferHandle &KernelArgs::buffer(unsigned int index) const
+{
+    const Arg &a = get_arg(index);
+    if (!a.buf) {
+        throw_lineexception("Kernel argument " + std::to_string(index) + " is not a buffer");
+    }
+    return a.buf;
+}
+
+const void *KernelArgs::scalar_data(unsigned int index) const
+{
+    const Arg &a = get_arg(index);
+    if (a.buf) {
+        throw_lineexception("Kernel argument " + std::to_string(index) + " is not a scalar");
+    }
+    return a.bytes;
+}
+
+size_t KernelArgs::scalar_size(unsigned int index) const
+{
+    scalar_data(index);
+    return args[index].num_bytes;
+}
+
+uint64_t KernelArgs::get_uint(unsigned int index) const
+{
+    const unsigned char *p = (const unsigned char *)scalar_data(index);
+    switch (args[index].num_bytes) {
+    case 1:
+        return *(const uint8_t *)p;
+    case 2:
+        return *(const uint16_t *)p;
+    case 4:
+        return *(const uint32_t *)p;
+    default:
+        return *(const uint64_t *)p;
+    }
+}
+
+int64_t KernelArgs::get_int(unsigned int index) const
+{
+    const unsigned char *p = (const unsigned char *)scalar_data(index);
+    switch (args[index].num_bytes) {
+    case 1:
+        return *(const int8_t *)p;
+    case 2:
+        return *(const int16_t *)p;
+    case 4:
+        return *(const int32_t *)p;
+    default:
+        return *(const int64_t *)p;
+    }
+}
+
+float KernelArgs::get_float(unsigned int index) const
+{
+    const void *p = scalar_data(index);
+    if (args[index].num_bytes == sizeof(double)) {
+        return (float)*(const double *)p;
+    }
+    return *(const float *)p;
+}
+
+class MergingPreparedKernel : public PreparedKernel
+{
+private:
+    DeviceBackend &dev;
+    std::string kernel;
+    KernelArgs fixed;
+
+public:
+    MergingPreparedKernel(DeviceBackend &dev, const std::string &kernel, const KernelArgs &fixed)
+        : dev(dev), kernel(kernel), fixed(fixed)
+    {
+    }
+
+    EventHandle run(const KernelArgs &args, const std::vector<EventHandle> &deps) override
+    {
+        KernelArgs merged = fixed;
+        for (unsigned int i = 0; i < args.count(); i++) {
+            if (args.is_set(i)) {
+                merged.set_from(i, args, i);
+            }
+        }
+        return dev.run_kernel(kernel, merged, deps);
+    }
+};
+
+PreparedKernelHandle DeviceBackend::prepare_kernel(const std::string &kernel, const KernelArgs &fixed)
+{
+    return std::make_shared<MergingPreparedKernel>(*this, kernel, fixed);
+}
+
+std::unique_ptr<DeviceBackend> create_device_backend(const std::string &xclbin)
+{
+    const char *env = getenv("XILINX_EXAMPLES_BACKEND");
+    return create_device_backend(xclbin, (env && *env) ? env : "auto");
+}
+
+std::unique_ptr<DeviceBackend> create_device_backend(const std::string &xclbin, const std::string &kind)
+{
+    if (kind != "cpu" && kind != "ocl" && kind != "xrt" && kind != "auto") {
+        throw_lineexception("Backend must be cpu, ocl, xrt or auto, not " + kind);
+    }
+
+#ifdef XILINX_EXAMPLES_HAVE_XRT
+    if (kind == "xrt") {
+        return std::unique_ptr<DeviceBackend>(new XrtBackend(xclbin));
+    }
+    if (kind != "cpu") {
+        try {
+            return std::unique_ptr<DeviceBackend>(new OclBackend(xclbin));
+        }
+        catch (std::exception &e) {
+            if (kind == "ocl") {
+                throw;
+            }
+            std::cout << "No usable Xilinx device (" << e.what()
+                      << "), falling back to CPU emulation" << std::endl;
+        }
+    }
+#else
+    // Only the device backends load an image
+    (void)xclbin;
+    if (kind == "ocl" || kind == "xrt") {
+        throw_lineexception("Built without XRT, only the CPU backend is available");
+    }
+#endif
+
+    return std::unique_ptr<DeviceBackend>(new CpuBackend(CpuBackendConfig::from_environment()));
+}
+} // namespace example_utils
+} // namespace xilinx
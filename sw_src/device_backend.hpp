@@ -0,0 +1,193 @@
+#ifndef DEVICE_BACKEND_HPP__
+#define DEVICE_BACKEND_HPP__
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// The subset of the runtime the example pipelines need -- buffers, migrations,
+// kernel launches and an event graph -- behind an interface with three
+// implementations: OclBackend drives a card through XilinxOclHelper,
+// XrtBackend drives it through XRT's native C++ API, and CpuBackend emulates
+// the card and the alveo_examples kernels in host C++ so that pipelines and
+// schedulers can be developed and benchmarked on machines without a card or
+// a Vitis install.
+//
+// Nothing in this header depends on OpenCL.
+
+enum class BufferAccess {
+    ReadOnly,
+    WriteOnly,
+    ReadWrite
+};
+
+enum class MigrateDirection {
+    ToDevice,
+    ToHost
+};
+
+class BackendBuffer
+{
+public:
+    virtual ~BackendBuffer() {}
+
+    virtual size_t size() const = 0;
+
+    // Host-side view of the buffer, valid for the buffer's lifetime. Data
+    // written here reaches kernels only after a migration to the device.
+    virtual void *host_ptr() = 0;
+};
+
+class BackendEvent
+{
+public:
+    virtual ~BackendEvent() {}
+
+    // Blocks until the command completes; rethrows the command's error
+    virtual void wait() = 0;
+
+    virtual bool is_complete() = 0;
+
+    // The command's error, or null if it succeeded or has not completed yet.
+    // Never blocks, so unlike wait() it may be called from on_complete().
+    virtual std::exception_ptr get_error() = 0;
+
+    // Runs 'fn' once the command completes, immediately if it already has.
+    // Callbacks may run on a runtime thread and must not block.
+    virtual void on_complete(std::function<void()> fn) = 0;
+};
+
+typedef std::shared_ptr<BackendBuffer> BufferHandle;
+typedef std::shared_ptr<BackendEvent> EventHandle;
+
+// Kernel arguments by index: buffers, or scalars stored as their raw bytes
+// like clSetKernelArg() does
+class KernelArgs
+{
+private:
+    struct Arg
+    {
+        BufferHandle buf;
+        unsigned char bytes[8];
+        size_t num_bytes = 0;
+    };
+    std::vector<Arg> args;
+
+    Arg &slot(unsigned int index);
+    const Arg &get_arg(unsigned int index) const;
+
+public:
+    KernelArgs &set(unsigned int index, const BufferHandle &buf);
+
+    template <typename T>
+    KernelArgs &set(unsigned int index, T value)
+    {
+        static_assert(std::is_arithmetic<T>::value && sizeof(T) <= 8,
+                      "Scalar kernel arguments must be arithmetic types of at most 8 bytes");
+        Arg &a = slot(index);
+        a.buf.reset();
+        memcpy(a.bytes, &value, sizeof(T));
+        a.num_bytes = sizeof(T);
+        return *this;
+    }
+
+    // Copies argument 'other_index' of 'other', whatever its kind
+    KernelArgs &set_from(unsigned int index, const KernelArgs &other, unsigned int other_index);
+
+    size_t count() const;
+    bool is_set(unsigned int index) const;
+
+    // True if argument 'index' is set here and in 'other' to the same buffer
+    // or the same scalar bytes
+    bool same_as(unsigned int index, const KernelArgs &other) const;
+
+    bool is_buffer(unsigned int index) const;
+    const BufferHandle &buffer(unsigned int index) const;
+
+    // Raw scalar bytes and their size
+    const void *scalar_data(unsigned int index) const;
+    size_t scalar_size(unsigned int index) const;
+
+    // Scalar reads; integer arguments are widened from whatever width
+    // they were set with
+    uint64_t get_uint(unsigned int index) const;
+    int64_t get_int(unsigned int index) const;
+    float get_float(unsigned int index) const;
+};
+
+// A kernel instance with some of its arguments applied ahead of time; see
+// DeviceBackend::prepare_kernel()
+class PreparedKernel
+{
+public:
+    virtual ~PreparedKernel() {}
+
+    // Runs the kernel with 'args' applied over the prepared arguments; only
+    // the indices set in 'args' change
+    virtual EventHandle run(const KernelArgs &args, const std::vector<EventHandle> &deps = {}) = 0;
+};
+
+typedef std::shared_ptr<PreparedKernel> PreparedKernelHandle;
+
+class DeviceBackend
+{
+public:
+    virtual ~DeviceBackend() {}
+
+    virtual const char *name() const = 0;
+
+    virtual BufferHandle create_buffer(size_t size, BufferAccess access) = 0;
+
+    // A window onto part of 'parent' that can be migrated and passed to
+    // kernels on its own. 'offset' must be a multiple of 4 KiB. Windows
+    // passed to the wide kernels need a size that is a multiple of 64 bytes,
+    // since those kernels read and write whole 512-bit words.
+    virtual BufferHandle create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size) = 0;
+
+    // Associates buffers with a kernel's arguments without running it. As
+    // with setArg() before mapping, this lets the runtime place each buffer
+    // in the bank its argument is connected to, so call it before the first
+    // host_ptr() on a new buffer.
+    virtual void bind_kernel_args(const std::string &kernel, const KernelArgs &args) = 0;
+
+    virtual EventHandle migrate(const std::vector<BufferHandle> &bufs,
+                                MigrateDirection direction,
+                                const std::vector<EventHandle> &deps = {}) = 0;
+
+    virtual EventHandle run_kernel(const std::string &kernel,
+                                   const KernelArgs &args,
+                                   const std::vector<EventHandle> &deps = {}) = 0;
+
+    // For a kernel launched repeatedly with mostly the same arguments. A
+    // backend may give the result a kernel object of its own with 'fixed'
+    // already set, so each run() only sets the arguments that differ; the
+    // default merges the arguments and calls run_kernel().
+    virtual PreparedKernelHandle prepare_kernel(const std::string &kernel, const KernelArgs &fixed);
+
+    // Blocks until every command submitted so far has completed
+    virtual void finish() = 0;
+};
+
+// Selects a backend from the XILINX_EXAMPLES_BACKEND environment variable:
+// "cpu" forces CpuBackend (configured from the environment, see
+// CpuBackendConfig::from_environment()), "ocl" forces OclBackend and "xrt"
+// forces XrtBackend on the first Xilinx device, and "auto" (the default) uses
+// the card through OpenCL when one can be programmed with 'xclbin' and the CPU
+// otherwise. Builds without XRT always return the CPU backend.
+std::unique_ptr<DeviceBackend> create_device_backend(const std::string &xclbin);
+
+// As above with the backend named by 'kind' instead of the environment
+std::unique_ptr<DeviceBackend> create_device_backend(const std::string &xclbin, const std::string &kind);
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // DEVICE_BACKEND_HPP__
@@ -0,0 +1,390 @@
+#ifndef DEVICE_BUFFER_HPP__
+#define DEVICE_BUFFER_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// How the host is about to use the mapped contents of a DeviceBuffer
+enum class HostAccess {
+    Read,     // Device results are copied back if the host copy is stale
+    Write,    // The host overwrites all of it; nothing is copied back
+    ReadWrite // Copied back if stale, then modified
+};
+
+// A pointer and element count into a mapped DeviceBuffer. Stands in for
+// std::span, which needs C++20.
+template <typename T>
+class HostSpan
+{
+private:
+    T *ptr;
+    size_t count;
+
+public:
+    HostSpan(T *ptr, size_t count) : ptr(ptr), count(count) {}
+
+    T *data() const
+    {
+        return ptr;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t size_bytes() const
+    {
+        return count * sizeof(T);
+    }
+
+    T *begin() const
+    {
+        return ptr;
+    }
+
+    T *end() const
+    {
+        return ptr + count;
+    }
+
+    T &operator[](size_t i) const
+    {
+        return ptr[i];
+    }
+};
+
+// Move-only owner of a cl::Buffer of 'count' elements of T that tracks
+// whether the host copy, the device copy or both are current, so data only
+// crosses PCIe when the side about to use it is stale.
+//
+// The host copy is mapped on first host access and stays mapped until the
+// buffer is destroyed. A host() call with Write or ReadWrite access marks the
+// device copy stale; to_device() uploads it if so and is a no-op otherwise.
+// After a kernel that writes the buffer, call device_written() so the next
+// host() read downloads the results. Buffers with BufferAccess::WriteOnly are
+// placed on the card with CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED, since the
+// kernel will overwrite whatever is there.
+//
+// For updates to a small part of a large buffer, host_range() or
+// mark_dirty() record which elements changed instead of marking the whole
+// device copy stale. to_device() then migrates only those ranges, rounded
+// out to 4 KiB pages, as sub-buffers of the parent.
+//
+// Set the buffer as a kernel argument (bind()) before the first to_device()
+// so XRT allocates it in the bank the argument is connected to. All commands
+// go to the queue given to the constructor, which must be in order.
+template <typename T>
+class DeviceBuffer
+{
+private:
+    cl::CommandQueue q;
+    cl::Buffer buf;
+    size_t count;
+    BufferAccess access;
+    T *mapped;
+    bool host_valid;
+    bool device_valid;
+    bool placed;
+
+    // Host-modified byte ranges [first, second) not yet on the device copy,
+    // page aligned, disjoint and non-adjacent. Only used while device_valid.
+    std::map<size_t, size_t> dirty;
+    size_t dirty_bytes;
+
+    unsigned int migrations;
+    size_t migrated_bytes;
+
+    void map()
+    {
+        if (mapped == nullptr) {
+            mapped = (T *)q.enqueueMapBuffer(buf, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, bytes());
+        }
+    }
+
+    void release()
+    {
+        if (mapped != nullptr) {
+            q.enqueueUnmapMemObject(buf, mapped);
+            q.finish();
+            mapped = nullptr;
+        }
+    }
+
+    void count_migration(size_t size)
+    {
+        migrations++;
+        migrated_bytes += size;
+    }
+
+    void add_dirty(size_t begin, size_t end)
+    {
+        // Sub-buffer origins must be page aligned, and whole pages cost no
+        // more to move than the bytes inside them
+        begin = begin / 4096 * 4096;
+        end   = std::min((end + 4095) / 4096 * 4096, bytes());
+
+        // Absorb every range that overlaps or touches [begin, end)
+        auto it = dirty.upper_bound(begin);
+        if (it != dirty.begin() && std::prev(it)->second >= begin) {
+            --it;
+        }
+        while (it != dirty.end() && it->first <= end) {
+            begin = std::min(begin, it->first);
+            end   = std::max(end, it->second);
+            dirty_bytes -= it->second - it->first;
+            it = dirty.erase(it);
+        }
+        dirty[begin] = end;
+        dirty_bytes += end - begin;
+    }
+
+    void clear_dirty()
+    {
+        dirty.clear();
+        dirty_bytes = 0;
+    }
+
+    bool migrate_dirty(cl::Event *event, const std::vector<cl::Event> *deps)
+    {
+        // Past half the buffer, one whole migration beats many small ones
+        if (dirty_bytes > bytes() / 2) {
+            clear_dirty();
+            device_valid = false;
+            return to_device(event, deps);
+        }
+
+        cl_mem_flags flags = access == BufferAccess::ReadWrite ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY;
+        std::vector<cl::Memory> ranges;
+        for (auto &d : dirty) {
+            cl_buffer_region region;
+            region.origin = d.first;
+            region.size   = d.second - d.first;
+            ranges.push_back(buf.createSubBuffer(flags, CL_BUFFER_CREATE_TYPE_REGION, &region));
+        }
+
+        // The runtime keeps the sub-buffers alive until the migration is done
+        q.enqueueMigrateMemObjects(ranges, 0, deps, event);
+        count_migration(dirty_bytes);
+        clear_dirty();
+        return true;
+    }
+
+public:
+    DeviceBuffer(XilinxOclHelper &xocl, cl::CommandQueue q, size_t count, BufferAccess access)
+        : q(q), count(count), access(access), mapped(nullptr), host_valid(false),
+          device_valid(false), placed(false), dirty_bytes(0), migrations(0), migrated_bytes(0)
+    {
+        if (count == 0) {
+            throw_lineexception("Device buffers cannot be empty");
+        }
+
+        cl_mem_flags flags = CL_MEM_ALLOC_HOST_PTR;
+        if (access == BufferAccess::ReadOnly) {
+            flags |= CL_MEM_READ_ONLY;
+        }
+        else if (access == BufferAccess::WriteOnly) {
+            flags |= CL_MEM_WRITE_ONLY;
+        }
+        else {
+            flags |= CL_MEM_READ_WRITE;
+        }
+        buf = xocl.create_buffer(count * sizeof(T), flags);
+    }
+
+    ~DeviceBuffer()
+    {
+        try {
+            release();
+        }
+        catch (...) {
+        }
+    }
+
+    DeviceBuffer(const DeviceBuffer &) = delete;
+    DeviceBuffer &operator=(const DeviceBuffer &) = delete;
+
+    DeviceBuffer(DeviceBuffer &&other)
+        : q(other.q), buf(other.buf), count(other.count), access(other.access),
+          mapped(other.mapped), host_valid(other.host_valid), device_valid(other.device_valid),
+          placed(other.placed), dirty(std::move(other.dirty)), dirty_bytes(other.dirty_bytes),
+          migrations(other.migrations), migrated_bytes(other.migrated_bytes)
+    {
+        other.buf    = cl::Buffer();
+        other.mapped = nullptr;
+        other.count  = 0;
+    }
+
+    DeviceBuffer &operator=(DeviceBuffer &&other)
+    {
+        if (this != &other) {
+            release();
+            q              = other.q;
+            buf            = other.buf;
+            count          = other.count;
+            access         = other.access;
+            mapped         = other.mapped;
+            host_valid     = other.host_valid;
+            device_valid   = other.device_valid;
+            placed         = other.placed;
+            dirty          = std::move(other.dirty);
+            dirty_bytes    = other.dirty_bytes;
+            migrations     = other.migrations;
+            migrated_bytes = other.migrated_bytes;
+            other.buf      = cl::Buffer();
+            other.mapped   = nullptr;
+            other.count    = 0;
+        }
+        return *this;
+    }
+
+    // Maps the buffer if needed and makes the host copy current for
+    // 'mode'. Blocks while results are copied back.
+    HostSpan<T> host(HostAccess mode)
+    {
+        map();
+        if (mode != HostAccess::Write && !host_valid && device_valid) {
+            cl::Event done;
+            q.enqueueMigrateMemObjects({buf}, CL_MIGRATE_MEM_OBJECT_HOST, nullptr, &done);
+            done.wait();
+            count_migration(bytes());
+        }
+        host_valid = true;
+        if (mode != HostAccess::Read) {
+            device_valid = false;
+            clear_dirty();
+        }
+        return HostSpan<T>(mapped, count);
+    }
+
+    // Records that the host has modified elements [first, first + n) through
+    // a span from host(HostAccess::Read). The host copy must be current.
+    void mark_dirty(size_t first, size_t n)
+    {
+        if (first > count || n > count - first) {
+            throw_lineexception("Dirty range is outside the buffer");
+        }
+        if (!host_valid) {
+            throw_lineexception("Marking part of a stale host copy dirty would upload stale data");
+        }
+
+        // Nothing changed, the kernel never reads the buffer, or the whole
+        // device copy is stale anyway
+        if (n == 0 || access == BufferAccess::WriteOnly || !device_valid) {
+            return;
+        }
+        add_dirty(first * sizeof(T), (first + n) * sizeof(T));
+    }
+
+    // Elements [first, first + n) for the host to update in place; the rest of
+    // the device copy stays current
+    HostSpan<T> host_range(size_t first, size_t n)
+    {
+        host(HostAccess::Read);
+        mark_dirty(first, n);
+        return HostSpan<T>(mapped + first, n);
+    }
+
+    // Makes the device copy current before a kernel uses it. Returns true and
+    // sets 'event' if a migration was enqueued; 'deps' are waited on first.
+    bool to_device(cl::Event *event = nullptr, const std::vector<cl::Event> *deps = nullptr)
+    {
+        if (device_valid) {
+            return dirty.empty() ? false : migrate_dirty(event, deps);
+        }
+
+        // Write-only outputs only need placing, and a buffer the host never
+        // wrote has nothing worth uploading either
+        cl_mem_migration_flags flags = 0;
+        if (access == BufferAccess::WriteOnly || !host_valid) {
+            if (placed) {
+                device_valid = true;
+                return false;
+            }
+            flags = CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED;
+        }
+        else {
+            count_migration(bytes());
+        }
+
+        q.enqueueMigrateMemObjects({buf}, flags, deps, event);
+        placed       = true;
+        device_valid = true;
+        return true;
+    }
+
+    // Records that a kernel has written the device copy, making the host copy
+    // stale
+    void device_written()
+    {
+        if (access == BufferAccess::ReadOnly) {
+            throw_lineexception("Kernels cannot write a buffer declared BufferAccess::ReadOnly");
+        }
+        if (!dirty.empty()) {
+            throw_lineexception("Kernel wrote a buffer with host updates that were never migrated");
+        }
+        device_valid = true;
+        host_valid   = false;
+    }
+
+    void bind(cl::Kernel &krnl, unsigned int index) const
+    {
+        krnl.setArg(index, buf);
+    }
+
+    const cl::Buffer &get_buffer() const
+    {
+        return buf;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t bytes() const
+    {
+        return count * sizeof(T);
+    }
+
+    bool is_host_valid() const
+    {
+        return host_valid;
+    }
+
+    bool is_device_valid() const
+    {
+        return device_valid && dirty.empty();
+    }
+
+    // Bytes the next to_device() would move for dirty ranges
+    size_t get_dirty_bytes() const
+    {
+        return dirty_bytes;
+    }
+
+    // Data-carrying migrations issued so far, in either direction
+    unsigned int get_migration_count() const
+    {
+        return migrations;
+    }
+
+    size_t get_migrated_bytes() const
+    {
+        return migrated_bytes;
+    }
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // DEVICE_BUFFER_HPP__
@@ -0,0 +1,315 @@
+#include "direct_reader.hpp"
+
+#include "line_exception.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Set by CMake when the kernel headers are new enough (5.6) for
+// IORING_OP_READ; without it only the pread path is built
+#ifdef XILINX_EXAMPLES_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace xilinx {
+namespace example_utils {
+#ifdef XILINX_EXAMPLES_HAVE_IO_URING
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+#endif
+
+DirectFileReader::DirectFileReader(const std::string &path, unsigned int queue_depth, bool direct)
+    : fd(-1), file_size(0), queue_depth(queue_depth), direct(direct), ring_fd(-1), ring_reads(true),
+      ring_in_flight(0), sq_ptr(MAP_FAILED), sq_ring_size(0), cq_ptr(MAP_FAILED), cq_ring_size(0),
+      sqes(MAP_FAILED), sqes_size(0), num_in_flight(0)
+{
+    if (queue_depth == 0) {
+        throw_lineexception("Reader queue depth must be at least 1");
+    }
+
+    if (direct) {
+        fd = open(path.c_str(), O_RDONLY | O_DIRECT);
+        if (fd < 0 && errno == EINVAL) {
+            // Filesystem does not support O_DIRECT; use the page cache
+            this->direct = false;
+        }
+    }
+    if (fd < 0) {
+        fd = open(path.c_str(), O_RDONLY);
+    }
+    if (fd < 0) {
+        throw_lineexception_errno("Unable to open " + path, errno);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw_lineexception_errno("Unable to stat " + path, errno);
+    }
+    file_size = st.st_size;
+
+    slots.resize(queue_depth);
+    for (unsigned int i = queue_depth; i > 0; i--) {
+        free_slots.push_back(i - 1);
+    }
+
+    setup_ring();
+}
+
+DirectFileReader::~DirectFileReader()
+{
+    if (ring_fd >= 0) {
+        // Let in-flight reads land before their destinations can go away
+        while (num_in_flight > 0) {
+            try {
+                wait_completion();
+            }
+            catch (...) {
+            }
+        }
+        munmap(sqes, sqes_size);
+        if (cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_ring_size);
+        }
+        munmap(sq_ptr, sq_ring_size);
+        close(ring_fd);
+    }
+    close(fd);
+}
+
+void DirectFileReader::setup_ring()
+{
+#ifdef XILINX_EXAMPLES_HAVE_IO_URING
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int rfd = sys_io_uring_setup(queue_depth, &p);
+    if (rfd < 0) {
+        // Kernel too old or io_uring disabled (e.g. by seccomp)
+        return;
+    }
+
+    sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    sq_ptr = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, rfd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+        close(rfd);
+        return;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr = sq_ptr;
+    }
+    else {
+        cq_ptr = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, rfd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) {
+            munmap(sq_ptr, sq_ring_size);
+            close(rfd);
+            return;
+        }
+    }
+
+    sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    sqes      = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, rfd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_ring_size);
+        }
+        munmap(sq_ptr, sq_ring_size);
+        close(rfd);
+        return;
+    }
+
+    char *sq = (char *)sq_ptr;
+    char *cq = (char *)cq_ptr;
+    sq_head  = (unsigned *)(sq + p.sq_off.head);
+    sq_tail  = (unsigned *)(sq + p.sq_off.tail);
+    sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+    sq_array = (unsigned *)(sq + p.sq_off.array);
+    cq_head  = (unsigned *)(cq + p.cq_off.head);
+    cq_tail  = (unsigned *)(cq + p.cq_off.tail);
+    cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+    cqes     = cq + p.cq_off.cqes;
+    ring_fd  = rfd;
+#endif
+}
+
+void DirectFileReader::submit_slot(unsigned int slot, size_t already_read)
+{
+    if (!uses_io_uring()) {
+        pending.push_back(slot);
+        return;
+    }
+
+#ifdef XILINX_EXAMPLES_HAVE_IO_URING
+    ReadRequest &req = slots[slot];
+    unsigned tail = *sq_tail;
+    unsigned idx  = tail & *sq_mask;
+
+    struct io_uring_sqe *sqe = &((struct io_uring_sqe *)sqes)[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = fd;
+    sqe->addr      = (uint64_t)(uintptr_t)((char *)req.dst + already_read);
+    sqe->len       = (uint32_t)(req.len - already_read);
+    sqe->off       = req.offset + already_read;
+    sqe->user_data = slot;
+    sq_array[idx]  = idx;
+
+    // Publish the entry before the new tail
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    int ret;
+    do {
+        ret = sys_io_uring_enter(ring_fd, 1, 0, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        throw_lineexception_errno("io_uring_enter failed to submit read", errno);
+    }
+    ring_in_flight++;
+#endif
+}
+
+bool DirectFileReader::submit(const ReadRequest &req)
+{
+    if (free_slots.empty()) {
+        return false;
+    }
+    if (direct && (((uintptr_t)req.dst | req.offset | req.len) & (DIRECT_READ_ALIGN - 1))) {
+        throw_lineexception("O_DIRECT reads must be 4 KiB aligned in address, offset and length");
+    }
+
+    unsigned int slot = free_slots.back();
+    free_slots.pop_back();
+    slots[slot]       = req;
+    slots[slot].bytes = 0;
+    num_in_flight++;
+
+    submit_slot(slot, 0);
+    return true;
+}
+
+ReadRequest DirectFileReader::wait_completion()
+{
+    if (num_in_flight == 0) {
+        throw_lineexception("wait_completion() called with no reads in flight");
+    }
+
+    for (;;) {
+        unsigned int slot;
+        ssize_t res;
+
+        if (ring_in_flight == 0) {
+            slot = pending.front();
+            pending.erase(pending.begin());
+            ReadRequest &req = slots[slot];
+            do {
+                res = pread(fd, (char *)req.dst + req.bytes, req.len - req.bytes, req.offset + req.bytes);
+            } while (res < 0 && errno == EINTR);
+            if (res < 0) {
+                res = -errno;
+            }
+        }
+        else {
+#ifdef XILINX_EXAMPLES_HAVE_IO_URING
+            unsigned head = *cq_head;
+            while (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+                int ret = sys_io_uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+                if (ret < 0 && errno != EINTR) {
+                    throw_lineexception_errno("io_uring_enter failed waiting for reads", errno);
+                }
+            }
+            struct io_uring_cqe *cqe = &((struct io_uring_cqe *)cqes)[head & *cq_mask];
+            slot                     = (unsigned int)cqe->user_data;
+            res                      = cqe->res;
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+            ring_in_flight--;
+
+            // Reads are checked for alignment before they are queued, so
+            // EINVAL means a 5.1-5.5 kernel without IORING_OP_READ. Redo the
+            // read, and all later ones, with pread(), which also reports any
+            // error that really was the read's own.
+            if (res == -EINVAL) {
+                ring_reads = false;
+                pending.push_back(slot);
+                continue;
+            }
+#endif
+        }
+
+        ReadRequest &req = slots[slot];
+        if (res < 0) {
+            free_slots.push_back(slot);
+            num_in_flight--;
+            throw_lineexception_errno("File read failed", (int)-res);
+        }
+        req.bytes += res;
+
+        uint64_t expected = 0;
+        if (req.offset < file_size) {
+            expected = std::min<uint64_t>(req.len, file_size - req.offset);
+        }
+        if (res > 0 && req.bytes < expected) {
+            // Short read before the end of file; queue the remainder
+            submit_slot(slot, req.bytes);
+            continue;
+        }
+
+        free_slots.push_back(slot);
+        num_in_flight--;
+        return req;
+    }
+}
+
+uint64_t DirectFileReader::size() const
+{
+    return file_size;
+}
+
+unsigned int DirectFileReader::in_flight() const
+{
+    return num_in_flight;
+}
+
+unsigned int DirectFileReader::get_queue_depth() const
+{
+    return queue_depth;
+}
+
+bool DirectFileReader::is_direct() const
+{
+    return direct;
+}
+
+bool DirectFileReader::uses_io_uring() const
+{
+    return ring_fd >= 0 && ring_reads;
+}
+
+const char *DirectFileReader::engine_name() const
+{
+    if (uses_io_uring()) {
+        return direct ? "io_uring + O_DIRECT" : "io_uring (buffered)";
+    }
+    return direct ? "pread + O_DIRECT" : "pread (buffered)";
+}
+} // namespace example_utils
+} // namespace xilinx
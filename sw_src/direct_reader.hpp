@@ -0,0 +1,95 @@
+#ifndef DIRECT_READER_HPP__
+#define DIRECT_READER_HPP__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Alignment required of destinations, offsets and lengths for O_DIRECT reads
+#define DIRECT_READ_ALIGN 4096
+
+struct ReadRequest
+{
+    void *dst       = nullptr;
+    uint64_t offset = 0;
+    size_t len      = 0;
+    uint64_t tag    = 0;
+    // Filled in on completion: bytes actually read (short only at end of file)
+    size_t bytes = 0;
+};
+
+// Reads a file asynchronously with up to 'queue_depth' reads in flight.
+//
+// With 'direct' set the file is opened O_DIRECT, so data goes from the disk
+// straight into the destination (e.g. a mapped CL_MEM_ALLOC_HOST_PTR buffer)
+// without a page cache copy; destinations, offsets and lengths must then be
+// DIRECT_READ_ALIGN aligned. Reads are issued through io_uring using the raw
+// syscalls. If io_uring is unavailable -- not built in because the kernel
+// headers predate IORING_OP_READ (Linux 5.6), or refused at run time by an
+// older kernel or a seccomp filter -- the reader falls back to a blocking
+// pread() per request, and if the filesystem refuses O_DIRECT (e.g. tmpfs)
+// to buffered I/O, so callers never need a second code path.
+class DirectFileReader
+{
+private:
+    int fd;
+    uint64_t file_size;
+    unsigned int queue_depth;
+    bool direct;
+
+    // io_uring state; ring_fd < 0 means the pread fallback is in use. A
+    // kernel without IORING_OP_READ (before 5.6) accepts the ring but fails
+    // every read with EINVAL, which clears ring_reads.
+    int ring_fd;
+    bool ring_reads;
+    unsigned int ring_in_flight;
+    void *sq_ptr;
+    size_t sq_ring_size;
+    void *cq_ptr;
+    size_t cq_ring_size;
+    void *sqes;
+    size_t sqes_size;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    void *cqes;
+
+    // Requests indexed by slot; the slot index is the io_uring user_data
+    std::vector<ReadRequest> slots;
+    std::vector<unsigned int> free_slots;
+    std::vector<unsigned int> pending; // FIFO of slots for the pread fallback
+    unsigned int num_in_flight;
+
+    void setup_ring();
+    void submit_slot(unsigned int slot, size_t already_read);
+
+public:
+    DirectFileReader(const std::string &path, unsigned int queue_depth = 8, bool direct = true);
+    ~DirectFileReader();
+
+    DirectFileReader(const DirectFileReader &) = delete;
+    DirectFileReader &operator=(const DirectFileReader &) = delete;
+
+    // Queues a read of 'len' bytes at 'offset' into 'dst'. Returns false,
+    // without queueing, if 'queue_depth' reads are already in flight.
+    bool submit(const ReadRequest &req);
+
+    // Blocks until any queued read has completed and returns it. Throws on
+    // I/O errors; short reads are resubmitted until end of file.
+    ReadRequest wait_completion();
+
+    uint64_t size() const;
+    unsigned int in_flight() const;
+    unsigned int get_queue_depth() const;
+    bool is_direct() const;
+    bool uses_io_uring() const;
+    const char *engine_name() const;
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // DIRECT_READER_HPP__
@@ -0,0 +1,149 @@
+#include "fd_channel.hpp"
+
+#include "line_exception.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace xilinx {
+namespace example_utils {
+void send_fd_message(int sock, const void *data, size_t len, const std::vector<int> &fds)
+{
+    if (fds.size() > FD_CHANNEL_MAX_FDS) {
+        throw_lineexception("Too many descriptors for one message");
+    }
+
+    struct iovec iov;
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len  = len;
+
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov    = &iov;
+    mh.msg_iovlen = 1;
+
+    char control[CMSG_SPACE(sizeof(int) * FD_CHANNEL_MAX_FDS)];
+    if (!fds.empty()) {
+        memset(control, 0, sizeof(control));
+        mh.msg_control    = control;
+        mh.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh);
+        cmsg->cmsg_level     = SOL_SOCKET;
+        cmsg->cmsg_type      = SCM_RIGHTS;
+        cmsg->cmsg_len       = CMSG_LEN(sizeof(int) * fds.size());
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+
+    ssize_t ret;
+    do {
+        ret = sendmsg(sock, &mh, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret != (ssize_t)len) {
+        throw_lineexception_errno("Unable to send message", errno);
+    }
+}
+
+bool recv_fd_message(int sock, void *data, size_t len, std::vector<int> *fds)
+{
+    struct iovec iov;
+    iov.iov_base = data;
+    iov.iov_len  = len;
+
+    char control[CMSG_SPACE(sizeof(int) * FD_CHANNEL_MAX_FDS)];
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov        = &iov;
+    mh.msg_iovlen     = 1;
+    mh.msg_control    = control;
+    mh.msg_controllen = sizeof(control);
+
+    ssize_t ret;
+    do {
+        ret = recvmsg(sock, &mh, MSG_CMSG_CLOEXEC);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret == 0) {
+        return false;
+    }
+    if (ret < 0) {
+        throw_lineexception_errno("Unable to receive message", errno);
+    }
+
+    // Take the descriptors before checking the size, so a malformed message
+    // cannot leak them
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh); cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t count        = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int *received = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+        for (size_t i = 0; i < count; i++) {
+            // Never leak descriptors the caller did not ask for
+            if (fds && ret == (ssize_t)len) {
+                fds->push_back(received[i]);
+            }
+            else {
+                close(received[i]);
+            }
+        }
+    }
+
+    if (ret != (ssize_t)len) {
+        throw_lineexception("Received a " + std::to_string(ret) + " byte message, expected " + std::to_string(len));
+    }
+    return true;
+}
+
+void send_buffer_message(int sock, const BufferMessage &msg, const std::vector<int> &fds)
+{
+    send_fd_message(sock, &msg, sizeof(msg), fds);
+}
+
+bool recv_buffer_message(int sock, BufferMessage &msg, std::vector<int> *fds)
+{
+    return recv_fd_message(sock, &msg, sizeof(msg), fds);
+}
+
+void send_all(int sock, const void *data, size_t len)
+{
+    const char *p = static_cast<const char *>(data);
+    while (len > 0) {
+        ssize_t ret = send(sock, p, len, MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_lineexception_errno("Unable to send data", errno);
+        }
+        p += ret;
+        len -= ret;
+    }
+}
+
+bool recv_all(int sock, void *data, size_t len)
+{
+    char *p = static_cast<char *>(data);
+    while (len > 0) {
+        ssize_t ret = recv(sock, p, len, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_lineexception_errno("Unable to receive data", errno);
+        }
+        if (ret == 0) {
+            return false;
+        }
+        p += ret;
+        len -= ret;
+    }
+    return true;
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,57 @@
+#ifndef FD_CHANNEL_HPP__
+#define FD_CHANNEL_HPP__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Control messages for sharing device buffers between processes over a
+// UNIX domain socket. Buffer file descriptors (from
+// XilinxOclHelper::get_fd_for_buffer) travel alongside a message as
+// SCM_RIGHTS ancillary data, so the payload itself is never copied.
+//
+// Ownership protocol: the producer creates a fixed set of slots and sends
+// BUFFER_ANNOUNCE once per slot with the slot's fds. A slot then belongs to
+// the producer until it sends BUFFER_FILLED, and to the consumer until it
+// answers with BUFFER_RELEASED, after which the producer may refill it.
+// STREAM_END tells the consumer no more slots will be filled.
+enum BufferMessageType : uint32_t {
+    BUFFER_ANNOUNCE = 1,
+    BUFFER_FILLED   = 2,
+    BUFFER_RELEASED = 3,
+    STREAM_END      = 4
+};
+
+struct BufferMessage
+{
+    uint32_t type;
+    uint32_t slot;
+    uint64_t size; // valid bytes in each buffer of the slot
+    uint64_t tag;  // user sequence number
+};
+
+#define FD_CHANNEL_MAX_FDS 8
+
+// Sends 'len' bytes as one message, attaching up to FD_CHANNEL_MAX_FDS file
+// descriptors. The sender keeps its own copies of the descriptors.
+void send_fd_message(int sock, const void *data, size_t len, const std::vector<int> &fds = std::vector<int>());
+
+// Receives one message of exactly 'len' bytes and any attached descriptors.
+// Returns false if the peer closed the connection.
+bool recv_fd_message(int sock, void *data, size_t len, std::vector<int> *fds = nullptr);
+
+// The same for BufferMessages
+void send_buffer_message(int sock, const BufferMessage &msg, const std::vector<int> &fds = std::vector<int>());
+bool recv_buffer_message(int sock, BufferMessage &msg, std::vector<int> *fds = nullptr);
+
+// Blocking helpers for plain byte streams
+void send_all(int sock, const void *data, size_t len);
+bool recv_all(int sock, void *data, size_t len);
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // FD_CHANNEL_HPP__
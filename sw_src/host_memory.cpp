@@ -0,0 +1,156 @@
+#include "host_memory.hpp"
+
+#include "line_exception.hpp"
+#include "numa_utils.hpp"
+
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define SMALL_PAGE_BYTES 4096UL
+#define HUGE_2M_BYTES (2UL * 1024 * 1024)
+#define HUGE_1G_BYTES (1024UL * 1024 * 1024)
+
+namespace xilinx {
+namespace example_utils {
+static size_t round_up(size_t size, size_t align)
+{
+    return ((size + align - 1) / align) * align;
+}
+
+size_t host_page_bytes(const HostAllocPolicy &policy)
+{
+    switch (policy.page_size) {
+    case HostPageSize::Huge2M:
+        return HUGE_2M_BYTES;
+    case HostPageSize::Huge1G:
+        return HUGE_1G_BYTES;
+    default:
+        return SMALL_PAGE_BYTES;
+    }
+}
+
+const char *host_backing_name(HostBacking backing)
+{
+    switch (backing) {
+    case HostBacking::HugeTLB:
+        return "hugetlbfs";
+    case HostBacking::TransparentHuge:
+        return "THP";
+    default:
+        return "4K pages";
+    }
+}
+
+// Maps 'length' bytes aligned to 'align' by over-allocating and trimming
+// the unaligned head and tail
+static void *map_aligned(size_t length, size_t align)
+{
+    size_t span = length + align;
+    void *raw   = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+
+    uintptr_t start   = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + align - 1) & ~(uintptr_t)(align - 1);
+    size_t head       = aligned - start;
+    size_t tail       = span - head - length;
+    if (head) {
+        munmap(raw, head);
+    }
+    if (tail) {
+        munmap(reinterpret_cast<void *>(aligned + length), tail);
+    }
+    return reinterpret_cast<void *>(aligned);
+}
+
+void *host_alloc(size_t size, const HostAllocPolicy &policy, HostBacking *backing)
+{
+    size_t page_bytes = host_page_bytes(policy);
+    size_t length     = round_up(size ? size : 1, page_bytes);
+    HostBacking used  = HostBacking::Normal;
+    void *ptr         = NULL;
+
+    if (policy.page_size != HostPageSize::Normal) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+        flags |= (policy.page_size == HostPageSize::Huge1G) ? MAP_HUGE_1GB : MAP_HUGE_2MB;
+        // MAP_POPULATE would fault the pages in before we get the chance to
+        // bind them, so leave prefaulting to the loop below in that case
+        if (policy.prefault && policy.numa_node < 0) {
+            flags |= MAP_POPULATE;
+        }
+
+        ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (ptr != MAP_FAILED) {
+            used = HostBacking::HugeTLB;
+        }
+        else {
+            // No reserved hugetlbfs pages of this size; ask for transparent
+            // hugepages on a 2 MiB aligned region instead
+            ptr = map_aligned(length, HUGE_2M_BYTES);
+            if (ptr == NULL) {
+                throw std::bad_alloc();
+            }
+            madvise(ptr, length, MADV_HUGEPAGE);
+            used = HostBacking::TransparentHuge;
+        }
+    }
+    else {
+        ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+    }
+
+    if (policy.numa_node >= 0) {
+        bind_memory_to_numa_node(ptr, length, policy.numa_node);
+    }
+
+    bool populated = (used == HostBacking::HugeTLB) && (policy.numa_node < 0);
+    if (policy.prefault && !populated) {
+        // Write to every page so the kernel allocates it now rather than on
+        // first use. A write is needed; a read would only map the zero page.
+        volatile char *p = static_cast<volatile char *>(ptr);
+        for (size_t off = 0; off < length; off += SMALL_PAGE_BYTES) {
+            p[off] = 0;
+        }
+    }
+
+    if (policy.lock) {
+        if (mlock(ptr, length) != 0) {
+            int err = errno;
+            munmap(ptr, length);
+            throw_lineexception_errno("Unable to lock host allocation, check RLIMIT_MEMLOCK", err);
+        }
+    }
+
+    if (backing) {
+        *backing = used;
+    }
+    return ptr;
+}
+
+void host_free(void *ptr, size_t size, const HostAllocPolicy &policy)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    size_t length = round_up(size ? size : 1, host_page_bytes(policy));
+    if (policy.lock) {
+        munlock(ptr, length);
+    }
+    munmap(ptr, length);
+}
+} // namespace example_utils
+} // namespace xilinx
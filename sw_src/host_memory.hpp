@@ -0,0 +1,97 @@
+#ifndef HOST_MEMORY_HPP__
+#define HOST_MEMORY_HPP__
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace xilinx {
+namespace example_utils {
+// Page size used to back a host allocation. Larger pages mean fewer page
+// table entries for XRT to walk when pinning a buffer for DMA.
+enum class HostPageSize {
+    Normal, // 4 KiB pages
+    Huge2M, // 2 MiB hugetlbfs pages, falling back to transparent hugepages
+    Huge1G  // 1 GiB hugetlbfs pages, falling back to transparent hugepages
+};
+
+// How an allocation actually ended up being backed
+enum class HostBacking {
+    Normal,
+    HugeTLB,
+    TransparentHuge
+};
+
+struct HostAllocPolicy
+{
+    HostPageSize page_size = HostPageSize::Normal;
+
+    // mlock() the allocation so it can never be swapped out. Subject to
+    // RLIMIT_MEMLOCK.
+    bool lock = false;
+
+    // Fault in every page at allocation time so first-touch page faults do
+    // not land in a timed region later on
+    bool prefault = false;
+
+    // Bind the allocation to this NUMA node before it is faulted in, or -1
+    // to use the default first-touch placement
+    int numa_node = -1;
+};
+
+// All allocations are at least 4 KiB aligned, so they can always be wrapped
+// with CL_MEM_USE_HOST_PTR without XRT falling back to a shadow copy.
+void *host_alloc(size_t size, const HostAllocPolicy &policy, HostBacking *backing = nullptr);
+void host_free(void *ptr, size_t size, const HostAllocPolicy &policy);
+size_t host_page_bytes(const HostAllocPolicy &policy);
+const char *host_backing_name(HostBacking backing);
+
+// Standard allocator that carries a HostAllocPolicy, e.g.
+//   std::vector<uint32_t, policy_allocator<uint32_t>> v(n, policy_allocator<uint32_t>(policy));
+template <typename T>
+struct policy_allocator
+{
+    using value_type = T;
+
+    HostAllocPolicy policy;
+
+    policy_allocator()
+    {
+    }
+    explicit policy_allocator(const HostAllocPolicy &policy_in) : policy(policy_in)
+    {
+    }
+    template <typename U>
+    policy_allocator(const policy_allocator<U> &other) : policy(other.policy)
+    {
+    }
+
+    T *allocate(std::size_t num)
+    {
+        return reinterpret_cast<T *>(host_alloc(num * sizeof(T), policy));
+    }
+    void deallocate(T *p, std::size_t num)
+    {
+        host_free(p, num * sizeof(T), policy);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const policy_allocator<T> &a, const policy_allocator<U> &b)
+{
+    return a.policy.page_size == b.policy.page_size &&
+           a.policy.lock == b.policy.lock &&
+           a.policy.prefault == b.policy.prefault &&
+           a.policy.numa_node == b.policy.numa_node;
+}
+
+template <typename T, typename U>
+bool operator!=(const policy_allocator<T> &a, const policy_allocator<U> &b)
+{
+    return !(a == b);
+}
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // HOST_MEMORY_HPP__
@@ -0,0 +1,158 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace xilinx {
+namespace example_utils {
+// 2^SUB_BUCKET_BITS exact buckets at the bottom, then half that many per
+// power of two
+#define SUB_BUCKET_BITS 7
+#define SUB_BUCKETS (1ULL << SUB_BUCKET_BITS)
+#define HALF_SUB_BUCKETS (SUB_BUCKETS / 2)
+#define NUM_BUCKETS (SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * HALF_SUB_BUCKETS)
+
+size_t LatencyHistogram::bucket_of(uint64_t value)
+{
+    if (value < SUB_BUCKETS) {
+        return (size_t)value;
+    }
+
+    // Shift so that the top SUB_BUCKET_BITS - 1 bits after the leading one
+    // pick the bucket within this power of two
+    unsigned int msb   = 63 - __builtin_clzll(value);
+    unsigned int shift = msb - (SUB_BUCKET_BITS - 1);
+    return (size_t)(SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + ((value >> shift) - HALF_SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::bucket_high(size_t bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t above       = bucket - SUB_BUCKETS;
+    unsigned int shift = (unsigned int)(above / HALF_SUB_BUCKETS) + 1;
+    uint64_t sub       = HALF_SUB_BUCKETS + above % HALF_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+LatencyHistogram::LatencyHistogram() : counts(NUM_BUCKETS, 0)
+{
+    clear();
+}
+
+void LatencyHistogram::record(uint64_t value_ns)
+{
+    counts[bucket_of(value_ns)]++;
+    if (total == 0 || value_ns < min_value) {
+        min_value = value_ns;
+    }
+    max_value = std::max(max_value, value_ns);
+    sum += (double)value_ns;
+    total++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.total == 0) {
+        return;
+    }
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        counts[i] += other.counts[i];
+    }
+    min_value = (total == 0) ? other.min_value : std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+    sum += other.sum;
+    total += other.total;
+}
+
+void LatencyHistogram::clear()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total     = 0;
+    min_value = 0;
+    max_value = 0;
+    sum       = 0.0;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return total;
+}
+
+uint64_t LatencyHistogram::min() const
+{
+    return min_value;
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return max_value;
+}
+
+double LatencyHistogram::mean() const
+{
+    return total ? sum / total : 0.0;
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const
+{
+    if (total == 0) {
+        return 0;
+    }
+    double clamped  = std::min(100.0, std::max(0.0, percentile));
+    uint64_t needed = std::max<uint64_t>(1, (uint64_t)std::ceil(clamped / 100.0 * total));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= needed) {
+            return std::max(min_value, std::min(max_value, bucket_high(i)));
+        }
+    }
+    return max_value;
+}
+
+void LatencyHistogram::print(std::ostream &os, const std::string &title) const
+{
+    std::ios_base::fmtflags flags(os.flags());
+    os << title << " (" << total << " samples, mean " << std::fixed << std::setprecision(3)
+       << mean() / 1000.0 << " us)" << std::endl;
+    os << std::setw(12) << "Value" << std::setw(13) << "Percentile" << std::setw(13) << "TotalCount"
+       << std::setw(18) << "1/(1-Percentile)" << std::endl;
+    if (total == 0) {
+        os.flags(flags);
+        return;
+    }
+
+    // 0%, then percentiles whose distance to 100% halves every two steps,
+    // stopping once a step covers less than one sample
+    double remaining = 100.0;
+    double p         = 0.0;
+    while (true) {
+        uint64_t value = value_at_percentile(p);
+        uint64_t at    = (uint64_t)std::ceil(p / 100.0 * total);
+        os << std::setw(12) << std::setprecision(3) << value / 1000.0
+           << std::setw(13) << std::setprecision(6) << p / 100.0
+           << std::setw(13) << std::max<uint64_t>(at, 1);
+        if (p < 100.0) {
+            os << std::setw(18) << std::setprecision(2) << 100.0 / (100.0 - p);
+        }
+        os << std::endl;
+
+        if (p >= 100.0) {
+            break;
+        }
+        remaining /= std::sqrt(2.0);
+        p = 100.0 - remaining;
+        if (remaining / 100.0 * total < 1.0) {
+            p = 100.0;
+        }
+    }
+    os << "#[Max = " << std::setprecision(3) << max_value / 1000.0 << " us, Min = " << min_value / 1000.0
+       << " us, Total count = " << total << "]" << std::endl;
+    os.flags(flags);
+}
+} // namespace example_utils
+} // namespace xilinx
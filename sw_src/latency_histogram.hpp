@@ -0,0 +1,58 @@
+#ifndef LATENCY_HISTOGRAM_HPP__
+#define LATENCY_HISTOGRAM_HPP__
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Log-linear histogram of nanosecond latencies in the style of HdrHistogram.
+// Values below 128 ns are counted exactly; above that, every power-of-two
+// range is split into 64 equal buckets, so any recorded value is reported
+// within 1.6% whatever its magnitude, in a fixed few KiB of counters.
+// record() is O(1) and does not allocate. Not thread safe; give each thread
+// its own histogram and merge() them afterwards.
+class LatencyHistogram
+{
+private:
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t min_value;
+    uint64_t max_value;
+    double sum;
+
+    static size_t bucket_of(uint64_t value);
+    static uint64_t bucket_high(size_t bucket);
+
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value_ns);
+    void merge(const LatencyHistogram &other);
+    void clear();
+
+    uint64_t count() const;
+    uint64_t min() const;
+    uint64_t max() const;
+    double mean() const;
+
+    // Smallest bucket bound that at least 'percentile' percent of the
+    // recorded values fall at or below, clamped to max()
+    uint64_t value_at_percentile(double percentile) const;
+
+    // Prints a percentile distribution in HdrHistogram's text layout, with
+    // values in microseconds and the tail halving towards the maximum:
+    //
+    //       Value   Percentile   TotalCount  1/(1-Percentile)
+    //      12.031     0.500000         5012              2.00
+    //      ...
+    void print(std::ostream &os, const std::string &title) const;
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // LATENCY_HISTOGRAM_HPP__
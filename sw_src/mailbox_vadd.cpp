@@ -0,0 +1,210 @@
+#include "mailbox_vadd.hpp"
+
+#include "line_exception.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace xilinx {
+namespace example_utils {
+static size_t round_up(size_t n, size_t align)
+{
+    return (n + align - 1) / align * align;
+}
+
+MailboxVadd::MailboxVadd(DeviceBackend &dev, size_t capacity_elems, unsigned int ring_entries)
+    : dev(dev), capacity(round_up(std::max<size_t>(capacity_elems, 1), MAILBOX_ALIGN_ELEMS)),
+      ring_entries(ring_entries ? ring_entries : 1), next_ticket(1), retired(0), stopped(false)
+{
+    a        = dev.create_buffer(capacity * sizeof(uint32_t), BufferAccess::ReadOnly);
+    b        = dev.create_buffer(capacity * sizeof(uint32_t), BufferAccess::ReadOnly);
+    c        = dev.create_buffer(capacity * sizeof(uint32_t), BufferAccess::WriteOnly);
+    cmd_ring = dev.create_buffer(this->ring_entries * sizeof(MailboxDescriptor), BufferAccess::ReadOnly);
+    cpl_ring = dev.create_buffer(this->ring_entries * sizeof(MailboxCompletion), BufferAccess::WriteOnly);
+
+    KernelArgs args;
+    args.set(0, a).set(1, b).set(2, c).set(3, cmd_ring).set(4, cpl_ring);
+    args.set(5, (uint32_t)this->ring_entries).set(6, (uint64_t)capacity);
+    dev.bind_kernel_args("mailbox_vadd", args);
+
+    // Zeroed rings hold no valid sequence numbers
+    memset(cmd_ring->host_ptr(), 0, cmd_ring->size());
+    memset(cpl_ring->host_ptr(), 0, cpl_ring->size());
+
+    last_cmd    = dev.migrate({a, b, c, cmd_ring, cpl_ring}, MigrateDirection::ToDevice);
+    kernel_done = dev.run_kernel("mailbox_vadd", args, {last_cmd});
+}
+
+MailboxVadd::~MailboxVadd()
+{
+    try {
+        stop();
+    }
+    catch (...) {
+    }
+}
+
+uint32_t *MailboxVadd::get_a()
+{
+    return (uint32_t *)a->host_ptr();
+}
+
+uint32_t *MailboxVadd::get_b()
+{
+    return (uint32_t *)b->host_ptr();
+}
+
+uint32_t *MailboxVadd::get_c()
+{
+    return (uint32_t *)c->host_ptr();
+}
+
+size_t MailboxVadd::get_capacity() const
+{
+    return capacity;
+}
+
+// Sequence numbers run 1..2^32-1 and wrap back to 1, as in the kernel
+uint32_t MailboxVadd::seq_for(uint64_t ticket)
+{
+    return (uint32_t)((ticket - 1) % 0xFFFFFFFFULL + 1);
+}
+
+// Whole pages covering the job, up to the end of the buffer
+BufferHandle MailboxVadd::job_range(const BufferHandle &buf, size_t first, size_t count)
+{
+    size_t offset = first * sizeof(uint32_t);
+    size_t bytes  = round_up(std::max<size_t>(count, 1) * sizeof(uint32_t), 4096);
+    return dev.create_sub_buffer(buf, offset, std::min(bytes, buf->size() - offset));
+}
+
+uint64_t MailboxVadd::post(uint32_t op, size_t first, size_t count)
+{
+    while (outstanding.size() >= ring_entries) {
+        refresh();
+        check_kernel();
+        std::this_thread::yield();
+    }
+
+    std::vector<EventHandle> deps = {last_cmd};
+    Job job;
+    job.ticket = next_ticket;
+    job.first  = first;
+    job.count  = count;
+    if (op == MAILBOX_OP_VADD && count > 0) {
+        job.c_range = job_range(c, first, count);
+        deps.push_back(dev.migrate({job_range(a, first, count), job_range(b, first, count)},
+                                   MigrateDirection::ToDevice));
+    }
+
+    // The fields are written before the two sequence numbers, and the kernel
+    // only accepts a record once both match, so a DMA racing with these
+    // writes can never hand it a half-written descriptor
+    MailboxDescriptor *d = (MailboxDescriptor *)cmd_ring->host_ptr() + (job.ticket - 1) % ring_entries;
+    memset(d, 0, sizeof(*d));
+    d->op    = op;
+    d->first = first;
+    d->count = count;
+    __atomic_store_n(&d->seq, seq_for(job.ticket), __ATOMIC_RELEASE);
+    __atomic_store_n(&d->seq_check, seq_for(job.ticket), __ATOMIC_RELEASE);
+
+    // Ring updates are chained so an older copy of the ring can never land
+    // on top of a newer one
+    last_cmd = dev.migrate({cmd_ring}, MigrateDirection::ToDevice, deps);
+
+    outstanding.push_back(job);
+    return next_ticket++;
+}
+
+uint64_t MailboxVadd::submit(size_t first, size_t count)
+{
+    if (stopped) {
+        throw_lineexception("Mailbox kernel has been stopped");
+    }
+    if (first % MAILBOX_ALIGN_ELEMS != 0 || first > capacity || count > capacity - first) {
+        throw_lineexception("Job range must start on a MAILBOX_ALIGN_ELEMS boundary and fit in the buffers");
+    }
+    return post(MAILBOX_OP_VADD, first, count);
+}
+
+// Reads back the completion ring and retires every job found complete,
+// oldest first, then brings their results back in one migration
+void MailboxVadd::refresh()
+{
+    if (outstanding.empty()) {
+        return;
+    }
+    dev.migrate({cpl_ring}, MigrateDirection::ToHost)->wait();
+
+    const MailboxCompletion *cpl = (const MailboxCompletion *)cpl_ring->host_ptr();
+    std::vector<BufferHandle> results;
+    while (!outstanding.empty()) {
+        Job &job                   = outstanding.front();
+        const MailboxCompletion &r = cpl[(job.ticket - 1) % ring_entries];
+        if (__atomic_load_n(&r.seq, __ATOMIC_ACQUIRE) != seq_for(job.ticket)) {
+            break;
+        }
+        if (r.status != MAILBOX_STATUS_OK) {
+            failed.insert(job.ticket);
+        }
+        else if (job.c_range) {
+            results.push_back(job.c_range);
+        }
+        retired = job.ticket;
+        outstanding.pop_front();
+    }
+
+    if (!results.empty()) {
+        dev.migrate(results, MigrateDirection::ToHost)->wait();
+    }
+}
+
+// Jobs still outstanding once the kernel has returned will never complete
+void MailboxVadd::check_kernel()
+{
+    if (!kernel_done->is_complete()) {
+        return;
+    }
+    refresh();
+    if (!outstanding.empty()) {
+        kernel_done->wait();
+        throw_lineexception("Mailbox kernel exited with jobs outstanding");
+    }
+}
+
+bool MailboxVadd::poll(uint64_t ticket)
+{
+    if (ticket == 0 || ticket >= next_ticket) {
+        throw_lineexception("Unknown mailbox ticket");
+    }
+    if (ticket > retired) {
+        refresh();
+    }
+    if (failed.erase(ticket)) {
+        throw_lineexception("Mailbox kernel rejected job " + std::to_string(ticket));
+    }
+    return ticket <= retired;
+}
+
+void MailboxVadd::wait(uint64_t ticket)
+{
+    while (!poll(ticket)) {
+        check_kernel();
+        std::this_thread::yield();
+    }
+}
+
+void MailboxVadd::stop()
+{
+    if (stopped) {
+        return;
+    }
+    stopped = true;
+
+    post(MAILBOX_OP_STOP, 0, 0);
+    kernel_done->wait();
+    refresh();
+}
+} // namespace example_utils
+} // namespace xilinx
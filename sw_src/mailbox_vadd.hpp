@@ -0,0 +1,116 @@
+#ifndef MAILBOX_VADD_HPP__
+#define MAILBOX_VADD_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <set>
+
+namespace xilinx {
+namespace example_utils {
+// Record layouts and codes shared with hw_src/mailbox_vadd.cpp
+#define MAILBOX_OP_VADD 1
+#define MAILBOX_OP_STOP 2
+
+#define MAILBOX_STATUS_OK 0
+#define MAILBOX_STATUS_BAD_RANGE 1
+#define MAILBOX_STATUS_BAD_OP 2
+
+// Jobs start on 4 KiB boundaries so each one's inputs and results can be
+// migrated as sub-buffers without touching its neighbours
+#define MAILBOX_ALIGN_ELEMS 1024
+
+struct MailboxDescriptor
+{
+    uint32_t seq;
+    uint32_t op;
+    uint64_t first;
+    uint64_t count;
+    uint32_t reserved[9];
+    uint32_t seq_check;
+};
+
+struct MailboxCompletion
+{
+    uint32_t seq;
+    uint32_t status;
+    uint32_t reserved[14];
+};
+
+static_assert(sizeof(MailboxDescriptor) == 64, "Descriptors are one 512-bit word");
+static_assert(sizeof(MailboxCompletion) == 64, "Completions are one 512-bit word");
+
+// Host side of the persistent mailbox_vadd kernel.
+//
+// The kernel is started once by the constructor and then polls a ring of
+// descriptors in device memory, so a job costs a descriptor write and a
+// completion poll rather than a kernel start/done handshake through the
+// scheduler. The kernel occupies its compute unit until stop().
+//
+// Jobs work on ranges of three buffers owned by this object: fill get_a()
+// and get_b(), submit(), then read get_c() once poll() or wait() says the
+// job is done. Not thread safe.
+class MailboxVadd
+{
+private:
+    struct Job
+    {
+        uint64_t ticket;
+        size_t first;
+        size_t count;
+        BufferHandle c_range;
+    };
+
+    DeviceBackend &dev;
+    size_t capacity;
+    unsigned int ring_entries;
+
+    BufferHandle a, b, c;
+    BufferHandle cmd_ring, cpl_ring;
+    EventHandle kernel_done;
+    EventHandle last_cmd;
+
+    uint64_t next_ticket;
+    uint64_t retired;
+    std::deque<Job> outstanding;
+    std::set<uint64_t> failed;
+    bool stopped;
+
+    static uint32_t seq_for(uint64_t ticket);
+    BufferHandle job_range(const BufferHandle &buf, size_t first, size_t count);
+    uint64_t post(uint32_t op, size_t first, size_t count);
+    void refresh();
+    void check_kernel();
+
+public:
+    // 'ring_entries' jobs may be outstanding at once
+    MailboxVadd(DeviceBackend &dev, size_t capacity_elems, unsigned int ring_entries = 64);
+
+    // Stops the kernel; results of jobs not yet waited for are discarded
+    ~MailboxVadd();
+
+    uint32_t *get_a();
+    uint32_t *get_b();
+    uint32_t *get_c();
+    size_t get_capacity() const;
+
+    // Queues c[first, first + count) = a + b over the same range and returns
+    // a ticket for it. 'first' must be a multiple of MAILBOX_ALIGN_ELEMS.
+    // Blocks while the descriptor ring is full.
+    uint64_t submit(size_t first, size_t count);
+
+    // True once the job's results are in get_c(). Throws if the kernel
+    // rejected the job.
+    bool poll(uint64_t ticket);
+    void wait(uint64_t ticket);
+
+    // Completes every submitted job and makes the kernel return
+    void stop();
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // MAILBOX_VADD_HPP__
@@ -0,0 +1,150 @@
+#include "numa_utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+#define MPOL_BIND 2
+#define MPOL_MF_MOVE (1 << 1)
+
+namespace xilinx {
+namespace example_utils {
+// Parses a sysfs list such as "0-3,8-11"
+static std::vector<int> parse_cpu_list(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first   = std::stoi(range.substr(0, dash));
+        int last    = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+int get_pci_numa_node(const std::string &bdf)
+{
+    if (bdf.empty()) {
+        return -1;
+    }
+
+    // sysfs names always carry the PCI domain
+    std::string name = bdf;
+    if (std::count(name.begin(), name.end(), ':') == 1) {
+        name = "0000:" + name;
+    }
+
+    std::ifstream f("/sys/bus/pci/devices/" + name + "/numa_node");
+    int node = -1;
+    if (!(f >> node)) {
+        return -1;
+    }
+    return node;
+}
+
+int get_numa_node_count()
+{
+    std::ifstream f("/sys/devices/system/node/online");
+    std::string list;
+    if (!std::getline(f, list)) {
+        return 1;
+    }
+    std::vector<int> nodes = parse_cpu_list(list);
+    return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+std::vector<int> get_numa_node_cpus(int node)
+{
+    std::vector<int> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+
+    std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (std::getline(f, list)) {
+        cpus = parse_cpu_list(list);
+    }
+    return cpus;
+}
+
+bool pin_thread_to_numa_node(int node)
+{
+    std::vector<int> cpus = get_numa_node_cpus(node);
+    if (cpus.empty()) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+bool bind_memory_to_numa_node(void *ptr, size_t size, int node)
+{
+    if (node < 0 || ptr == NULL) {
+        return false;
+    }
+
+    const size_t bits_per_word = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / bits_per_word + 1, 0);
+    mask[node / bits_per_word] |= 1UL << (node % bits_per_word);
+
+    long ret = syscall(SYS_mbind,
+                       ptr,
+                       size,
+                       MPOL_BIND,
+                       mask.data(),
+                       mask.size() * bits_per_word + 1,
+                       MPOL_MF_MOVE);
+    return ret == 0;
+}
+
+void parallel_first_touch(void *ptr, size_t size, int node, unsigned int num_threads)
+{
+    if (num_threads == 0) {
+        size_t node_cpus = get_numa_node_cpus(node).size();
+        num_threads      = node_cpus ? node_cpus : std::thread::hardware_concurrency();
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+    }
+
+    // Split on page boundaries so no page is touched from two threads
+    const size_t page = 4096;
+    size_t pages      = (size + page - 1) / page;
+    size_t per_thread = (pages + num_threads - 1) / num_threads;
+
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        size_t begin = t * per_thread * page;
+        if (begin >= size) {
+            break;
+        }
+        size_t len = std::min(per_thread * page, size - begin);
+        workers.emplace_back([=]() {
+            pin_thread_to_numa_node(node);
+            memset(static_cast<char *>(ptr) + begin, 0, len);
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+} // namespace example_utils
+} // namespace xilinx
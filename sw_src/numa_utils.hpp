@@ -0,0 +1,38 @@
+#ifndef NUMA_UTILS_HPP__
+#define NUMA_UTILS_HPP__
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// NUMA helpers implemented directly on sysfs and the mbind/sched_setaffinity
+// system calls, so no dependency on libnuma is needed. Every function treats
+// a node of -1 as "unknown" and does nothing.
+
+// Returns the NUMA node of a PCI device given its BDF (e.g. "0000:65:00.1"),
+// or -1 if the platform does not report one
+int get_pci_numa_node(const std::string &bdf);
+
+// Number of NUMA nodes in the system (1 on non-NUMA machines)
+int get_numa_node_count();
+
+// CPUs belonging to a node, as listed in sysfs
+std::vector<int> get_numa_node_cpus(int node);
+
+// Restricts the calling thread to the CPUs of a node
+bool pin_thread_to_numa_node(int node);
+
+// Binds a page-aligned range to a node, migrating any pages already faulted
+bool bind_memory_to_numa_node(void *ptr, size_t size, int node);
+
+// Zeroes a range using num_threads threads pinned to 'node', so that every
+// page is first touched from that node
+void parallel_first_touch(void *ptr, size_t size, int node, unsigned int num_threads = 0);
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // NUMA_UTILS_HPP__
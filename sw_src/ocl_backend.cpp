@@ -0,0 +1,287 @@
+#include "ocl_backend.hpp"
+
+namespace xilinx {
+namespace example_utils {
+class OclBuffer : public BackendBuffer
+{
+private:
+    std::mutex map_mutex;
+    cl::CommandQueue q;
+    size_t bytes;
+    void *mapped;
+
+public:
+    cl::Buffer buf;
+
+    OclBuffer(cl::Buffer buf, cl::CommandQueue q, size_t size)
+        : q(q), bytes(size), mapped(nullptr), buf(buf)
+    {
+    }
+
+    ~OclBuffer()
+    {
+        if (mapped) {
+            try {
+                q.enqueueUnmapMemObject(buf, mapped);
+                q.finish();
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    size_t size() const override
+    {
+        return bytes;
+    }
+
+    void *host_ptr() override
+    {
+        std::lock_guard<std::mutex> lock(map_mutex);
+        if (!mapped) {
+            mapped = q.enqueueMapBuffer(buf, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, bytes);
+        }
+        return mapped;
+    }
+};
+
+class OclEvent : public BackendEvent
+{
+public:
+    cl::Event event;
+
+    OclEvent(cl::Event event) : event(event) {}
+
+    void wait() override
+    {
+        event.wait();
+        std::exception_ptr err = get_error();
+        if (err) {
+            std::rethrow_exception(err);
+        }
+    }
+
+    bool is_complete() override
+    {
+        cl_int status = event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>();
+        return status == CL_COMPLETE || status < 0;
+    }
+
+    // A negative execution status is the error code the command failed with
+    std::exception_ptr get_error() override
+    {
+        cl_int status = event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>();
+        if (status >= 0) {
+            return nullptr;
+        }
+        return std::make_exception_ptr(
+            LineException("OpenCL command failed with status " + std::to_string(status), 0, __FILE__, __LINE__));
+    }
+
+    void on_complete(std::function<void()> fn) override
+    {
+        auto *heap_fn = new std::function<void()>(std::move(fn));
+        event.setCallback(
+            CL_COMPLETE,
+            [](cl_event, cl_int, void *data) {
+                auto *f = static_cast<std::function<void()> *>(data);
+                (*f)();
+                delete f;
+            },
+            heap_fn);
+    }
+};
+
+static cl_mem_flags access_flags(BufferAccess access)
+{
+    switch (access) {
+    case BufferAccess::ReadOnly:
+        return CL_MEM_READ_ONLY;
+    case BufferAccess::WriteOnly:
+        return CL_MEM_WRITE_ONLY;
+    default:
+        return CL_MEM_READ_WRITE;
+    }
+}
+
+static std::vector<cl::Event> to_cl_events(const std::vector<EventHandle> &deps)
+{
+    std::vector<cl::Event> events;
+    for (auto &dep : deps) {
+        events.push_back(OclBackend::get_cl_event(dep));
+    }
+    return events;
+}
+
+// Sets the arguments present in 'args', leaving the others as they were
+static void apply_args(cl::Kernel &krnl, const KernelArgs &args)
+{
+    for (unsigned int i = 0; i < args.count(); i++) {
+        if (!args.is_set(i)) {
+            continue;
+        }
+        if (args.is_buffer(i)) {
+            krnl.setArg(i, OclBackend::get_cl_buffer(args.buffer(i)));
+        }
+        else {
+            krnl.setArg(i, args.scalar_size(i), args.scalar_data(i));
+        }
+    }
+}
+
+// Owns a cl::Kernel of its own, so the fixed arguments are set once and runs
+// do not contend for the backend's kernel_mutex
+class OclPreparedKernel : public PreparedKernel
+{
+private:
+    std::mutex mutex;
+    cl::CommandQueue q;
+    cl::Kernel krnl;
+
+public:
+    OclPreparedKernel(cl::CommandQueue q, cl::Kernel krnl, const KernelArgs &fixed) : q(q), krnl(krnl)
+    {
+        apply_args(this->krnl, fixed);
+    }
+
+    EventHandle run(const KernelArgs &args, const std::vector<EventHandle> &deps) override
+    {
+        std::vector<cl::Event> wait_list = to_cl_events(deps);
+        cl::Event event;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        apply_args(krnl, args);
+        q.enqueueTask(krnl, wait_list.empty() ? NULL : &wait_list, &event);
+        q.flush();
+        return std::make_shared<OclEvent>(event);
+    }
+};
+
+OclBackend::OclBackend(const std::string &xclbin)
+{
+    xocl.initialize(xclbin);
+    q = xocl.get_command_queue();
+}
+
+const char *OclBackend::name() const
+{
+    return "OpenCL";
+}
+
+BufferHandle OclBackend::create_buffer(size_t size, BufferAccess access)
+{
+    cl::Buffer buf = xocl.create_buffer(size, access_flags(access) | CL_MEM_ALLOC_HOST_PTR);
+    return std::make_shared<OclBuffer>(buf, q, size);
+}
+
+BufferHandle OclBackend::create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size)
+{
+    cl_buffer_region region;
+    region.origin = offset;
+    region.size   = size;
+
+    // Sub-buffers inherit host pointer flags; only the access flags may be given
+    cl::Buffer &buf    = get_cl_buffer(parent);
+    cl_mem_flags flags = buf.getInfo<CL_MEM_FLAGS>() & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY);
+    cl::Buffer sub     = buf.createSubBuffer(flags, CL_BUFFER_CREATE_TYPE_REGION, &region);
+    return std::make_shared<OclBuffer>(sub, q, size);
+}
+
+cl::Kernel &OclBackend::set_kernel_args(const std::string &kernel, const KernelArgs &args)
+{
+    auto it = kernels.find(kernel);
+    if (it == kernels.end()) {
+        it = kernels.insert(std::make_pair(kernel, xocl.get_kernel(kernel))).first;
+    }
+    cl::Kernel &krnl = it->second;
+
+    for (unsigned int i = 0; i < args.count(); i++) {
+        if (args.is_buffer(i)) {
+            krnl.setArg(i, get_cl_buffer(args.buffer(i)));
+        }
+        else {
+            krnl.setArg(i, args.scalar_size(i), args.scalar_data(i));
+        }
+    }
+    return krnl;
+}
+
+void OclBackend::bind_kernel_args(const std::string &kernel, const KernelArgs &args)
+{
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    set_kernel_args(kernel, args);
+}
+
+EventHandle OclBackend::migrate(const std::vector<BufferHandle> &bufs,
+                                MigrateDirection direction,
+                                const std::vector<EventHandle> &deps)
+{
+    std::vector<cl::Memory> mems;
+    for (auto &buf : bufs) {
+        mems.push_back(get_cl_buffer(buf));
+    }
+    std::vector<cl::Event> wait_list = to_cl_events(deps);
+
+    cl::Event event;
+    q.enqueueMigrateMemObjects(mems,
+                               direction == MigrateDirection::ToHost ? CL_MIGRATE_MEM_OBJECT_HOST : 0,
+                               wait_list.empty() ? NULL : &wait_list,
+                               &event);
+    q.flush();
+    return std::make_shared<OclEvent>(event);
+}
+
+EventHandle OclBackend::run_kernel(const std::string &kernel,
+                                   const KernelArgs &args,
+                                   const std::vector<EventHandle> &deps)
+{
+    std::vector<cl::Event> wait_list = to_cl_events(deps);
+    cl::Event event;
+
+    // setArg() and enqueueTask() must not interleave between threads
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    cl::Kernel &krnl = set_kernel_args(kernel, args);
+    q.enqueueTask(krnl, wait_list.empty() ? NULL : &wait_list, &event);
+    q.flush();
+    return std::make_shared<OclEvent>(event);
+}
+
+PreparedKernelHandle OclBackend::prepare_kernel(const std::string &kernel, const KernelArgs &fixed)
+{
+    return std::make_shared<OclPreparedKernel>(q, xocl.get_kernel(kernel), fixed);
+}
+
+void OclBackend::finish()
+{
+    q.finish();
+}
+
+XilinxOclHelper &OclBackend::get_helper()
+{
+    return xocl;
+}
+
+cl::CommandQueue &OclBackend::get_command_queue()
+{
+    return q;
+}
+
+cl::Buffer &OclBackend::get_cl_buffer(const BufferHandle &buf)
+{
+    OclBuffer *b = dynamic_cast<OclBuffer *>(buf.get());
+    if (b == nullptr) {
+        throw_lineexception("Buffer was not created by an OclBackend");
+    }
+    return b->buf;
+}
+
+cl::Event &OclBackend::get_cl_event(const EventHandle &event)
+{
+    OclEvent *e = dynamic_cast<OclEvent *>(event.get());
+    if (e == nullptr) {
+        throw_lineexception("Event was not created by an OclBackend");
+    }
+    return e->event;
+}
+} // namespace example_utils
+} // namespace xilinx
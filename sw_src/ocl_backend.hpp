@@ -0,0 +1,59 @@
+#ifndef OCL_BACKEND_HPP__
+#define OCL_BACKEND_HPP__
+
+#pragma once
+
+#include "device_backend.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+namespace xilinx {
+namespace example_utils {
+// DeviceBackend on a real card (or sw_emu/hw_emu) through XilinxOclHelper and
+// a single out-of-order command queue
+class OclBackend : public DeviceBackend
+{
+private:
+    XilinxOclHelper xocl;
+    cl::CommandQueue q;
+
+    std::mutex kernel_mutex;
+    std::map<std::string, cl::Kernel> kernels;
+
+    // Caller holds kernel_mutex
+    cl::Kernel &set_kernel_args(const std::string &kernel, const KernelArgs &args);
+
+public:
+    // Programs the first Xilinx device with 'xclbin'; throws if there is none
+    OclBackend(const std::string &xclbin);
+
+    const char *name() const override;
+
+    // Buffers are CL_MEM_ALLOC_HOST_PTR and are mapped on the first
+    // host_ptr() call
+    BufferHandle create_buffer(size_t size, BufferAccess access) override;
+    BufferHandle create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size) override;
+    void bind_kernel_args(const std::string &kernel, const KernelArgs &args) override;
+
+    EventHandle migrate(const std::vector<BufferHandle> &bufs,
+                        MigrateDirection direction,
+                        const std::vector<EventHandle> &deps = {}) override;
+
+    EventHandle run_kernel(const std::string &kernel,
+                           const KernelArgs &args,
+                           const std::vector<EventHandle> &deps = {}) override;
+
+    PreparedKernelHandle prepare_kernel(const std::string &kernel, const KernelArgs &fixed) override;
+
+    void finish() override;
+
+    XilinxOclHelper &get_helper();
+    cl::CommandQueue &get_command_queue();
+
+    // The OpenCL objects behind handles created by an OclBackend
+    static cl::Buffer &get_cl_buffer(const BufferHandle &buf);
+    static cl::Event &get_cl_event(const EventHandle &event);
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // OCL_BACKEND_HPP__
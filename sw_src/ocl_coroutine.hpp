@@ -0,0 +1,277 @@
+#ifndef OCL_COROUTINE_HPP__
+#define OCL_COROUTINE_HPP__
+
+#pragma once
+
+// Optional C++20 layer: lets a coroutine co_await OpenCL events, buffer
+// migrations and kernel launches. The rest of the library is C++14, so only
+// include this header from targets built with CMAKE_CXX_STANDARD 20.
+#if __cplusplus < 202002L
+#error "ocl_coroutine.hpp requires C++20"
+#endif
+
+#include "xilinx_ocl_helper.hpp"
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+class CoroutineScheduler;
+
+// Fire-and-forget coroutine type for an offload flow. A flow does not start
+// until it is handed to CoroutineScheduler::spawn(), and its frame is freed
+// automatically when it finishes.
+class OffloadFlow
+{
+public:
+    struct promise_type
+    {
+        CoroutineScheduler *scheduler = nullptr;
+        std::exception_ptr error;
+
+        OffloadFlow get_return_object()
+        {
+            return OffloadFlow(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        auto final_suspend() noexcept;
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            error = std::current_exception();
+        }
+    };
+
+    OffloadFlow(OffloadFlow &&other) noexcept : handle(other.handle)
+    {
+        other.handle = nullptr;
+    }
+    OffloadFlow(const OffloadFlow &) = delete;
+    OffloadFlow &operator=(const OffloadFlow &) = delete;
+    ~OffloadFlow()
+    {
+        // Only destroy flows that were never spawned
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+private:
+    friend class CoroutineScheduler;
+    std::coroutine_handle<promise_type> handle;
+
+    explicit OffloadFlow(std::coroutine_handle<promise_type> h) : handle(h)
+    {
+    }
+};
+
+// Resumes coroutines on a single scheduler thread. Event callbacks only queue
+// the suspended coroutine here, so flows never run on the XRT callback thread
+// and never run concurrently with each other. This also makes it safe for
+// flows to share a cl::Kernel between suspension points.
+class CoroutineScheduler
+{
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    std::condition_variable idle_cv;
+    std::deque<std::coroutine_handle<>> ready;
+    size_t active_flows = 0;
+    bool stopping       = false;
+    std::exception_ptr first_error;
+
+    // Declared last so that it starts after the members it uses
+    std::thread thread;
+
+    void run()
+    {
+        for (;;) {
+            std::coroutine_handle<> h;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (ready.empty()) {
+                    return;
+                }
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+    struct EventContext
+    {
+        CoroutineScheduler *scheduler;
+        std::coroutine_handle<> handle;
+        cl_int status;
+    };
+
+    static void CL_CALLBACK event_callback(cl_event event, cl_int status, void *user_data)
+    {
+        EventContext *ctx = static_cast<EventContext *>(user_data);
+        ctx->status       = status;
+        ctx->scheduler->schedule(ctx->handle);
+    }
+
+public:
+    // Suspends the awaiting coroutine until the event completes
+    class EventAwaiter
+    {
+    private:
+        CoroutineScheduler *scheduler;
+        cl::Event event;
+        EventContext ctx;
+
+    public:
+        EventAwaiter(CoroutineScheduler *s, cl::Event e) : scheduler(s), event(e)
+        {
+        }
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            ctx.scheduler = scheduler;
+            ctx.handle    = h;
+            ctx.status    = CL_COMPLETE;
+            if (clSetEventCallback(event(), CL_COMPLETE, &CoroutineScheduler::event_callback, &ctx) != CL_SUCCESS) {
+                throw_lineexception("Unable to register event completion callback");
+            }
+        }
+        cl::Event await_resume()
+        {
+            if (ctx.status < 0) {
+                throw_lineexception("Device command failed with status " + std::to_string(ctx.status));
+            }
+            return event;
+        }
+    };
+
+    CoroutineScheduler() : thread(&CoroutineScheduler::run, this)
+    {
+    }
+
+    ~CoroutineScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        thread.join();
+    }
+
+    void schedule(std::coroutine_handle<> h)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            ready.push_back(h);
+        }
+        cv.notify_one();
+    }
+
+    // Starts a flow on the scheduler thread. The scheduler takes ownership.
+    void spawn(OffloadFlow flow)
+    {
+        auto h                = flow.handle;
+        flow.handle           = nullptr;
+        h.promise().scheduler = this;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            active_flows++;
+        }
+        schedule(h);
+    }
+
+    // Blocks until every spawned flow has finished, then rethrows the first
+    // error raised by any of them
+    void wait_all()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        idle_cv.wait(lock, [this] { return active_flows == 0; });
+        if (first_error) {
+            std::exception_ptr e = first_error;
+            first_error          = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    void flow_finished(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (error && !first_error) {
+            first_error = error;
+        }
+        if (--active_flows == 0) {
+            idle_cv.notify_all();
+        }
+    }
+
+    // Awaitable wrappers. Each one enqueues the command, flushes the queue so
+    // the command is actually submitted, and suspends until it completes.
+    EventAwaiter wait(const cl::Event &event)
+    {
+        return EventAwaiter(this, event);
+    }
+
+    EventAwaiter migrate(cl::CommandQueue &q,
+                         const std::vector<cl::Memory> &mems,
+                         cl_mem_migration_flags flags,
+                         const std::vector<cl::Event> *deps = NULL)
+    {
+        cl::Event event;
+        q.enqueueMigrateMemObjects(mems, flags, deps, &event);
+        q.flush();
+        return EventAwaiter(this, event);
+    }
+
+    EventAwaiter task(cl::CommandQueue &q,
+                      const cl::Kernel &krnl,
+                      const std::vector<cl::Event> *deps = NULL)
+    {
+        cl::Event event;
+        q.enqueueTask(krnl, deps, &event);
+        q.flush();
+        return EventAwaiter(this, event);
+    }
+};
+
+inline auto OffloadFlow::promise_type::final_suspend() noexcept
+{
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+        {
+            CoroutineScheduler *s    = h.promise().scheduler;
+            std::exception_ptr error = h.promise().error;
+            h.destroy();
+            s->flow_finished(error);
+        }
+        void await_resume() const noexcept
+        {
+        }
+    };
+    return FinalAwaiter{};
+}
+
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // OCL_COROUTINE_HPP__
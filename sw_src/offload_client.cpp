@@ -0,0 +1,231 @@
+#include "offload_client.hpp"
+
+#include "fd_channel.hpp"
+#include "line_exception.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef XILINX_EXAMPLES_HAVE_MEMFD_CREATE
+#include <linux/memfd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace xilinx {
+namespace example_utils {
+static int offload_connect(const std::string &path)
+{
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw_lineexception("Socket path is too long: " + path);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw_lineexception_errno("Unable to create socket", errno);
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        int err = errno;
+        close(fd);
+        throw_lineexception_errno("Unable to connect to the offload daemon at " + path, err);
+    }
+    return fd;
+}
+
+static const char *status_name(uint32_t status)
+{
+    switch (status) {
+    case OFFLOAD_OK:
+        return "ok";
+    case OFFLOAD_BAD_REQUEST:
+        return "bad request";
+    default:
+        return "failed";
+    }
+}
+
+static int create_memfd(const char *name, unsigned int flags)
+{
+#ifdef XILINX_EXAMPLES_HAVE_MEMFD_CREATE
+    return memfd_create(name, flags);
+#else
+    return (int)syscall(SYS_memfd_create, name, flags);
+#endif
+}
+
+OffloadClient::OffloadClient(const std::string &socket_path, const std::string &name, size_t region_bytes)
+    : sock(-1), region_ptr(nullptr), region_bytes(region_bytes), next_tag(1)
+{
+    int fd = create_memfd("offload_region", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        throw_lineexception_errno("Unable to create the shared region", errno);
+    }
+    // The daemon only maps a region that can no longer shrink under it
+    if (ftruncate(fd, region_bytes) != 0 || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK) != 0) {
+        int err = errno;
+        close(fd);
+        throw_lineexception_errno("Unable to size and seal the shared region", err);
+    }
+    void *p = mmap(nullptr, region_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        throw_lineexception_errno("Unable to map the shared region", err);
+    }
+    region_ptr = (uint8_t *)p;
+
+    try {
+        sock = offload_connect(socket_path);
+
+        OffloadRequest req;
+        memset(&req, 0, sizeof(req));
+        req.type   = OFFLOAD_ATTACH;
+        req.arg[0] = region_bytes;
+        strncpy(req.name, name.c_str(), OFFLOAD_NAME_LEN - 1);
+        outstanding.push_back(req.tag = next_tag++);
+        send_fd_message(sock, &req, sizeof(req), {fd});
+        close(fd);
+        fd = -1;
+        wait(req.tag);
+    }
+    catch (...) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (sock >= 0) {
+            close(sock);
+        }
+        munmap(region_ptr, region_bytes);
+        throw;
+    }
+}
+
+OffloadClient::~OffloadClient()
+{
+    // Closing the socket while jobs are outstanding is safe: the daemon
+    // still waits for them before unmapping its view of the region
+    close(sock);
+    munmap(region_ptr, region_bytes);
+}
+
+uint8_t *OffloadClient::region()
+{
+    return region_ptr;
+}
+
+size_t OffloadClient::region_size() const
+{
+    return region_bytes;
+}
+
+uint64_t OffloadClient::send(OffloadRequest &req)
+{
+    req.tag = next_tag++;
+    send_fd_message(sock, &req, sizeof(req));
+    outstanding.push_back(req.tag);
+    return req.tag;
+}
+
+OffloadReply OffloadClient::receive(uint64_t tag)
+{
+    OffloadReply reply;
+    if (!recv_fd_message(sock, &reply, sizeof(reply))) {
+        throw_lineexception("The offload daemon closed the connection");
+    }
+    if (reply.type != OFFLOAD_REPLY || reply.tag != tag) {
+        throw_lineexception("Unexpected reply from the offload daemon");
+    }
+    return reply;
+}
+
+uint64_t OffloadClient::submit_vadd(size_t a_offset, size_t b_offset, size_t c_offset, uint64_t count)
+{
+    OffloadRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type   = OFFLOAD_VADD;
+    req.arg[0] = a_offset;
+    req.arg[1] = b_offset;
+    req.arg[2] = c_offset;
+    req.arg[3] = count;
+    return send(req);
+}
+
+uint64_t OffloadClient::submit_resize(size_t in_offset, int width_in, int height_in,
+                                      size_t out_offset, int width_out, int height_out)
+{
+    OffloadRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type   = OFFLOAD_RESIZE;
+    req.arg[0] = in_offset;
+    req.arg[1] = out_offset;
+    req.arg[2] = width_in;
+    req.arg[3] = height_in;
+    req.arg[4] = width_out;
+    req.arg[5] = height_out;
+    return send(req);
+}
+
+void OffloadClient::wait(uint64_t tag)
+{
+    // Replies arrive in request order
+    while (!outstanding.empty() && outstanding.front() <= tag) {
+        OffloadReply reply = receive(outstanding.front());
+        outstanding.pop_front();
+        if (reply.status != OFFLOAD_OK) {
+            throw_lineexception("Offload job " + std::to_string(reply.tag) + " " + status_name(reply.status));
+        }
+    }
+}
+
+void OffloadClient::wait_all()
+{
+    if (!outstanding.empty()) {
+        wait(outstanding.back());
+    }
+}
+
+OffloadClientStats OffloadClient::get_stats()
+{
+    wait_all();
+
+    OffloadRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = OFFLOAD_STATS;
+    send(req);
+    outstanding.pop_front();
+    OffloadReply reply = receive(req.tag);
+
+    OffloadClientStats stats;
+    stats.jobs    = reply.stat[0];
+    stats.failed  = reply.stat[1];
+    stats.mean_us = reply.stat[2] / 1000.0;
+    stats.p50_us  = reply.stat[3] / 1000.0;
+    stats.p99_us  = reply.stat[4] / 1000.0;
+    stats.max_us  = reply.stat[5] / 1000.0;
+    return stats;
+}
+
+void OffloadClient::shutdown_daemon(const std::string &socket_path)
+{
+    int fd = offload_connect(socket_path);
+    OffloadRequest req;
+    memset(&req, 0, sizeof(req));
+    req.type = OFFLOAD_SHUTDOWN;
+    try {
+        send_fd_message(fd, &req, sizeof(req));
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,84 @@
+#ifndef OFFLOAD_CLIENT_HPP__
+#define OFFLOAD_CLIENT_HPP__
+
+#pragma once
+
+#include "offload_protocol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace xilinx {
+namespace example_utils {
+// A client's latency as measured by the daemon, from receiving each request
+// to sending its reply
+struct OffloadClientStats
+{
+    uint64_t jobs;
+    uint64_t failed;
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double max_us;
+};
+
+// Connection to an OffloadServer. Job payloads live in a shared memory
+// region created with the client and mapped by the daemon, and are named by
+// their byte offset in region(); the daemon reads inputs from and writes
+// results to the region directly.
+//
+// Jobs are asynchronous: submit_*() returns a tag, and wait() blocks until
+// that job and every earlier one has been answered. A region range must not
+// be reused until the job using it has been waited for. Not thread safe.
+class OffloadClient
+{
+private:
+    int sock;
+    uint8_t *region_ptr;
+    size_t region_bytes;
+    uint64_t next_tag;
+    std::deque<uint64_t> outstanding;
+
+    uint64_t send(OffloadRequest &req);
+    OffloadReply receive(uint64_t tag);
+
+public:
+    // Connects to the daemon at 'socket_path' and shares a new region of
+    // 'region_bytes' with it. 'name' identifies the client in the daemon's
+    // reports.
+    OffloadClient(const std::string &socket_path, const std::string &name, size_t region_bytes);
+    ~OffloadClient();
+
+    OffloadClient(const OffloadClient &) = delete;
+    OffloadClient &operator=(const OffloadClient &) = delete;
+
+    uint8_t *region();
+    size_t region_size() const;
+
+    // c[i] = a[i] + b[i] for 'count' uint32_t elements
+    uint64_t submit_vadd(size_t a_offset, size_t b_offset, size_t c_offset, uint64_t count);
+
+    // Area resize of a packed 8-bit BGR image of up to 3840x2160. Widths must
+    // be multiples of 8 and neither dimension may shrink by more than 7x, as
+    // for the resize_accel_rgb kernel; other jobs are refused as bad requests.
+    uint64_t submit_resize(size_t in_offset, int width_in, int height_in,
+                           size_t out_offset, int width_out, int height_out);
+
+    // Throws if any of the jobs answered failed
+    void wait(uint64_t tag);
+    void wait_all();
+
+    // Waits for every outstanding job, then asks the daemon for this
+    // client's latency
+    OffloadClientStats get_stats();
+
+    // Asks the daemon at 'socket_path' to exit once its clients' outstanding
+    // jobs are answered
+    static void shutdown_daemon(const std::string &socket_path);
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // OFFLOAD_CLIENT_HPP__
@@ -0,0 +1,64 @@
+#ifndef OFFLOAD_PROTOCOL_HPP__
+#define OFFLOAD_PROTOCOL_HPP__
+
+#pragma once
+
+#include <cstdint>
+
+namespace xilinx {
+namespace example_utils {
+// Wire format between OffloadClient and OffloadServer over a SOCK_SEQPACKET
+// UNIX socket, one fixed-size record per packet.
+//
+// A client starts with OFFLOAD_ATTACH, passing a shared memory file
+// descriptor as SCM_RIGHTS data; every payload after that is an offset into
+// that region, so job data is never sent through the socket. Each job
+// request gets exactly one OFFLOAD_REPLY with the same tag, and replies come
+// back in request order.
+enum OffloadMessageType : uint32_t {
+    OFFLOAD_ATTACH   = 1,
+    OFFLOAD_VADD     = 2,
+    OFFLOAD_RESIZE   = 3,
+    OFFLOAD_STATS    = 4,
+    OFFLOAD_SHUTDOWN = 5,
+    OFFLOAD_REPLY    = 6
+};
+
+enum OffloadStatus : uint32_t {
+    OFFLOAD_OK          = 0,
+    OFFLOAD_BAD_REQUEST = 1,
+    OFFLOAD_FAILED      = 2
+};
+
+#define OFFLOAD_NAME_LEN 32
+
+struct OffloadRequest
+{
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t tag; // echoed in the reply
+
+    // ATTACH: arg[0] = bytes in the shared region, which the passed memfd
+    //         must already hold and be sealed with F_SEAL_SHRINK
+    // VADD:   arg[0..2] = region offsets of a, b and c; arg[3] = elements
+    // RESIZE: arg[0..1] = region offsets of the packed BGR input and output
+    //         images; arg[2..5] = width_in, height_in, width_out, height_out
+    uint64_t arg[6];
+
+    char name[OFFLOAD_NAME_LEN]; // ATTACH: the client's name for reports
+};
+
+struct OffloadReply
+{
+    uint32_t type;   // OFFLOAD_REPLY
+    uint32_t status; // OffloadStatus
+    uint64_t tag;
+
+    // STATS: the client's jobs, failed jobs, and mean, median, 99th
+    // percentile and maximum latency in nanoseconds from request to reply
+    uint64_t stat[6];
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // OFFLOAD_PROTOCOL_HPP__
@@ -0,0 +1,558 @@
+#include "offload_server.hpp"
+
+#include "fd_channel.hpp"
+#include "line_exception.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+// Largest image resize_accel_rgb accepts, as packed 8-bit BGR. It is built
+// for eight pixels per clock, so widths must be multiples of 8, and it can
+// shrink each dimension by at most MAX_DOWN_SCALE.
+#define OFFLOAD_RESIZE_MAX_WIDTH 3840
+#define OFFLOAD_RESIZE_MAX_HEIGHT 2160
+#define OFFLOAD_RESIZE_PIXELS_PER_CLOCK 8
+#define OFFLOAD_RESIZE_MAX_DOWN_SCALE 7
+#define OFFLOAD_RESIZE_MAX_BYTES ((size_t)OFFLOAD_RESIZE_MAX_WIDTH * OFFLOAD_RESIZE_MAX_HEIGHT * 3)
+
+namespace xilinx {
+namespace example_utils {
+// A request between being read and being answered
+struct OffloadServer::Job
+{
+    uint64_t tag;
+    uint32_t type;
+    uint32_t status;
+    std::chrono::steady_clock::time_point received;
+
+    // Blocks until the results are in the client's region; throws if the
+    // job failed. Empty for requests with nothing to wait for.
+    std::function<void()> wait;
+};
+
+struct OffloadServer::Session
+{
+    int sock;
+    std::string name;
+    int pid;
+    uint8_t *region;
+    size_t region_bytes;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> pending;
+    bool closed;
+    std::atomic<bool> finished;
+
+    // Only used by the completer thread
+    LatencyHistogram latency;
+    uint64_t failed;
+
+    std::thread reader;
+    std::thread completer;
+
+    Session(int sock)
+        : sock(sock), name("anonymous"), pid(0), region(nullptr), region_bytes(0), closed(false),
+          finished(false), failed(0)
+    {
+    }
+
+    // Whether [offset, offset + bytes) lies within the shared region
+    bool contains(uint64_t offset, uint64_t bytes) const
+    {
+        return region != nullptr && bytes <= region_bytes && offset <= region_bytes - bytes;
+    }
+};
+
+int offload_listen(const std::string &path)
+{
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw_lineexception("Socket path is too long: " + path);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw_lineexception_errno("Unable to create socket", errno);
+    }
+
+    // A socket file nobody answers on was left behind by a daemon that died
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        close(fd);
+        throw_lineexception("A daemon is already listening on " + path);
+    }
+    close(fd);
+    unlink(path.c_str());
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw_lineexception_errno("Unable to create socket", errno);
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        int err = errno;
+        close(fd);
+        throw_lineexception_errno("Unable to listen on " + path, err);
+    }
+    return fd;
+}
+
+OffloadServer::OffloadServer(DeviceBackend &dev, int listen_fd, const OffloadServerConfig &config)
+    : dev(dev), listen_fd(listen_fd), config(config),
+      coalescer(dev, config.vadd_batch_elems, config.vadd_window, config.vadd_depth),
+      resize_slots(std::max(config.resize_slots, 1u)), stopping(false)
+{
+    for (auto &slot : resize_slots) {
+        slot.in  = dev.create_buffer(OFFLOAD_RESIZE_MAX_BYTES, BufferAccess::ReadOnly);
+        slot.out = dev.create_buffer(OFFLOAD_RESIZE_MAX_BYTES, BufferAccess::WriteOnly);
+        dev.bind_kernel_args("resize_accel_rgb", KernelArgs().set(0, slot.in).set(1, slot.out));
+    }
+}
+
+OffloadServer::~OffloadServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto &s : sessions) {
+            if (s->sock >= 0) {
+                shutdown(s->sock, SHUT_RD);
+            }
+        }
+    }
+    for (auto &s : sessions) {
+        if (s->reader.joinable()) {
+            s->reader.join();
+        }
+        if (s->completer.joinable()) {
+            s->completer.join();
+        }
+    }
+    close(listen_fd);
+}
+
+void OffloadServer::run()
+{
+    while (!stopping) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (stopping) {
+                break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            throw_lineexception_errno("Unable to accept a client", errno);
+        }
+        if (stopping) {
+            close(fd);
+            break;
+        }
+
+        reap_sessions();
+
+        std::unique_ptr<Session> s(new Session(fd));
+        Session &session = *s;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sessions.push_back(std::move(s));
+        }
+        session.completer = std::thread(&OffloadServer::completer_main, this, std::ref(session));
+        session.reader    = std::thread(&OffloadServer::reader_main, this, std::ref(session));
+    }
+
+    // Stop reading from the remaining clients; their completers answer what
+    // was already submitted before the connections close
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &s : sessions) {
+            if (s->sock >= 0) {
+                shutdown(s->sock, SHUT_RD);
+            }
+        }
+    }
+    for (auto &s : sessions) {
+        s->reader.join();
+        s->completer.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    sessions.clear();
+}
+
+void OffloadServer::reap_sessions()
+{
+    std::vector<std::unique_ptr<Session>> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            if ((*it)->finished) {
+                done.push_back(std::move(*it));
+                it = sessions.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    for (auto &s : done) {
+        s->reader.join();
+        s->completer.join();
+    }
+}
+
+void OffloadServer::reader_main(Session &s)
+{
+    try {
+        OffloadRequest req;
+        std::vector<int> fds;
+        while (recv_fd_message(s.sock, &req, sizeof(req), &fds)) {
+            if (req.type == OFFLOAD_SHUTDOWN) {
+                for (int fd : fds) {
+                    close(fd);
+                }
+                stopping = true;
+                shutdown(listen_fd, SHUT_RDWR);
+                break;
+            }
+
+            Job job;
+            job.tag      = req.tag;
+            job.type     = req.type;
+            job.status   = OFFLOAD_OK;
+            job.received = std::chrono::steady_clock::now();
+
+            if (req.type == OFFLOAD_ATTACH) {
+                attach(s, req, fds, job);
+            }
+            else {
+                submit(s, req, job);
+            }
+            for (int fd : fds) {
+                close(fd);
+            }
+            fds.clear();
+            push(s, job);
+        }
+    }
+    catch (std::exception &e) {
+        std::cout << "Offload client " << s.name << ": " << e.what() << std::endl;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.closed = true;
+    }
+    s.cv.notify_all();
+}
+
+void OffloadServer::attach(Session &s, const OffloadRequest &req, const std::vector<int> &fds, Job &job)
+{
+    s.name = std::string(req.name, strnlen(req.name, OFFLOAD_NAME_LEN));
+
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(s.sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) {
+        s.pid = cred.pid;
+    }
+
+    if (s.region != nullptr || fds.size() != 1 || req.arg[0] == 0) {
+        job.status = OFFLOAD_BAD_REQUEST;
+        return;
+    }
+
+    // Touching pages past the end of the file raises SIGBUS, so the file must
+    // already cover the region and be sealed against shrinking later
+    struct stat st;
+    int seals = fcntl(fds[0], F_GET_SEALS);
+    if (fstat(fds[0], &st) != 0 || (uint64_t)st.st_size < req.arg[0] || seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        job.status = OFFLOAD_BAD_REQUEST;
+        return;
+    }
+    void *p = mmap(nullptr, req.arg[0], PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    if (p == MAP_FAILED) {
+        job.status = OFFLOAD_BAD_REQUEST;
+        return;
+    }
+    s.region       = (uint8_t *)p;
+    s.region_bytes = req.arg[0];
+}
+
+void OffloadServer::submit(Session &s, const OffloadRequest &req, Job &job)
+{
+    // Wait for room first, so a client cannot queue unbounded work
+    {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.cv.wait(lock, [&] { return s.pending.size() < config.max_outstanding; });
+    }
+
+    try {
+        bool ok = true;
+        if (req.type == OFFLOAD_VADD) {
+            ok = submit_vadd(s, req, job);
+        }
+        else if (req.type == OFFLOAD_RESIZE) {
+            ok = submit_resize(s, req, job);
+        }
+        else if (req.type != OFFLOAD_STATS) {
+            ok = false;
+        }
+        if (!ok) {
+            job.status = OFFLOAD_BAD_REQUEST;
+        }
+    }
+    catch (std::exception &e) {
+        std::cout << "Offload client " << s.name << ": " << e.what() << std::endl;
+        job.status = OFFLOAD_FAILED;
+    }
+}
+
+bool OffloadServer::submit_vadd(Session &s, const OffloadRequest &req, Job &job)
+{
+    uint64_t count = req.arg[3];
+    if (count > s.region_bytes / sizeof(uint32_t)) {
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (req.arg[i] % sizeof(uint32_t) != 0 || !s.contains(req.arg[i], count * sizeof(uint32_t))) {
+            return false;
+        }
+    }
+
+    const uint32_t *a = (const uint32_t *)(s.region + req.arg[0]);
+    const uint32_t *b = (const uint32_t *)(s.region + req.arg[1]);
+    uint32_t *c       = (uint32_t *)(s.region + req.arg[2]);
+
+    // Jobs larger than a batch are split; small ones share batches with
+    // other clients' jobs
+    std::vector<std::shared_future<void>> parts;
+    for (uint64_t first = 0; first < count; first += config.vadd_batch_elems) {
+        size_t n = std::min<uint64_t>(config.vadd_batch_elems, count - first);
+        parts.push_back(coalescer.submit(a + first, b + first, c + first, n).share());
+    }
+    job.wait = [parts]() {
+        for (auto &p : parts) {
+            p.get();
+        }
+    };
+    return true;
+}
+
+bool OffloadServer::submit_resize(Session &s, const OffloadRequest &req, Job &job)
+{
+    // A job the kernel cannot run could stall the card for every client, so
+    // anything outside what it was built for is refused here
+    for (int i = 2; i < 6; i += 2) {
+        if (req.arg[i] == 0 || req.arg[i] > OFFLOAD_RESIZE_MAX_WIDTH ||
+            req.arg[i] % OFFLOAD_RESIZE_PIXELS_PER_CLOCK != 0 ||
+            req.arg[i + 1] == 0 || req.arg[i + 1] > OFFLOAD_RESIZE_MAX_HEIGHT) {
+            return false;
+        }
+    }
+    if (req.arg[2] > req.arg[4] * OFFLOAD_RESIZE_MAX_DOWN_SCALE ||
+        req.arg[3] > req.arg[5] * OFFLOAD_RESIZE_MAX_DOWN_SCALE) {
+        return false;
+    }
+    size_t in_bytes  = req.arg[2] * req.arg[3] * 3;
+    size_t out_bytes = req.arg[4] * req.arg[5] * 3;
+    if (!s.contains(req.arg[0], in_bytes) || !s.contains(req.arg[1], out_bytes)) {
+        return false;
+    }
+
+    ResizeSlot *slot = acquire_resize_slot();
+    try {
+        memcpy(slot->in->host_ptr(), s.region + req.arg[0], in_bytes);
+
+        // Only move the whole pages in use
+        BufferHandle in  = dev.create_sub_buffer(slot->in, 0, std::min((in_bytes + 4095) / 4096 * 4096, slot->in->size()));
+        BufferHandle out = dev.create_sub_buffer(slot->out, 0, std::min((out_bytes + 4095) / 4096 * 4096, slot->out->size()));
+
+        KernelArgs args;
+        args.set(0, in).set(1, out);
+        args.set(2, (int)req.arg[2]).set(3, (int)req.arg[3]).set(4, (int)req.arg[4]).set(5, (int)req.arg[5]);
+
+        EventHandle to_dev = dev.migrate({in}, MigrateDirection::ToDevice);
+        EventHandle run    = dev.run_kernel("resize_accel_rgb", args, {to_dev});
+        EventHandle done   = dev.migrate({out}, MigrateDirection::ToHost, {run});
+
+        uint8_t *dst = s.region + req.arg[1];
+        job.wait     = [this, slot, done, dst, out_bytes]() {
+            try {
+                done->wait();
+                memcpy(dst, slot->out->host_ptr(), out_bytes);
+            }
+            catch (...) {
+                release_resize_slot(slot);
+                throw;
+            }
+            release_resize_slot(slot);
+        };
+    }
+    catch (...) {
+        release_resize_slot(slot);
+        throw;
+    }
+    return true;
+}
+
+void OffloadServer::push(Session &s, Job &job)
+{
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.pending.push_back(std::move(job));
+    }
+    s.cv.notify_all();
+}
+
+OffloadServer::ResizeSlot *OffloadServer::acquire_resize_slot()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        for (auto &slot : resize_slots) {
+            if (!slot.busy) {
+                slot.busy = true;
+                return &slot;
+            }
+        }
+        resize_cv.wait(lock);
+    }
+}
+
+void OffloadServer::release_resize_slot(ResizeSlot *slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        slot->busy = false;
+    }
+    resize_cv.notify_one();
+}
+
+// Answers the client's requests in the order they arrived
+void OffloadServer::completer_main(Session &s)
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(s.mutex);
+            s.cv.wait(lock, [&] { return s.closed || !s.pending.empty(); });
+            if (s.pending.empty()) {
+                break;
+            }
+            job = std::move(s.pending.front());
+            s.pending.pop_front();
+        }
+        s.cv.notify_all();
+
+        OffloadReply reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.type   = OFFLOAD_REPLY;
+        reply.tag    = job.tag;
+        reply.status = job.status;
+
+        if (job.wait) {
+            try {
+                job.wait();
+            }
+            catch (std::exception &e) {
+                std::cout << "Offload client " << s.name << ": " << e.what() << std::endl;
+                reply.status = OFFLOAD_FAILED;
+            }
+        }
+
+        if (job.type == OFFLOAD_VADD || job.type == OFFLOAD_RESIZE) {
+            if (reply.status == OFFLOAD_OK) {
+                auto elapsed = std::chrono::steady_clock::now() - job.received;
+                s.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+            else {
+                s.failed++;
+            }
+        }
+        else if (job.type == OFFLOAD_STATS) {
+            reply.stat[0] = s.latency.count();
+            reply.stat[1] = s.failed;
+            reply.stat[2] = (uint64_t)s.latency.mean();
+            reply.stat[3] = s.latency.value_at_percentile(50.0);
+            reply.stat[4] = s.latency.value_at_percentile(99.0);
+            reply.stat[5] = s.latency.max();
+        }
+
+        // A client that has gone away still has its remaining jobs waited
+        // for, so no buffer is released while the device may be using it
+        try {
+            send_fd_message(s.sock, &reply, sizeof(reply));
+        }
+        catch (std::exception &) {
+        }
+    }
+
+    close_session(s);
+}
+
+void OffloadServer::close_session(Session &s)
+{
+    // Connections that never attached, such as shutdown requests, are not
+    // clients worth reporting
+    bool attached = s.region != nullptr;
+    if (attached) {
+        munmap(s.region, s.region_bytes);
+        s.region = nullptr;
+
+        std::ios_base::fmtflags flags(std::cout.flags());
+        std::cout << "Offload client " << s.name << " (pid " << s.pid << ") disconnected after "
+                  << s.latency.count() << " jobs; latency p50 " << std::fixed << std::setprecision(1)
+                  << s.latency.value_at_percentile(50.0) / 1000.0 << " us, p99 "
+                  << s.latency.value_at_percentile(99.0) / 1000.0 << " us" << std::endl;
+        std::cout.flags(flags);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    close(s.sock);
+    s.sock = -1;
+
+    if (attached) {
+        ClientReport report;
+        report.name    = s.name;
+        report.pid     = s.pid;
+        report.failed  = s.failed;
+        report.latency = s.latency;
+        reports.push_back(report);
+    }
+    s.finished = true;
+}
+
+void OffloadServer::print_stats(std::ostream &os)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ios_base::fmtflags flags(os.flags());
+    os << std::left << std::setw(20) << "Client" << std::right << std::setw(8) << "PID"
+       << std::setw(8) << "Jobs" << std::setw(8) << "Failed" << std::setw(12) << "Mean (us)"
+       << std::setw(12) << "p50 (us)" << std::setw(12) << "p99 (us)" << std::setw(12) << "Max (us)" << std::endl;
+    os << std::fixed << std::setprecision(1);
+    for (auto &r : reports) {
+        os << std::left << std::setw(20) << r.name << std::right << std::setw(8) << r.pid
+           << std::setw(8) << r.latency.count() << std::setw(8) << r.failed
+           << std::setw(12) << r.latency.mean() / 1000.0
+           << std::setw(12) << r.latency.value_at_percentile(50.0) / 1000.0
+           << std::setw(12) << r.latency.value_at_percentile(99.0) / 1000.0
+           << std::setw(12) << r.latency.max() / 1000.0 << std::endl;
+    }
+    os.flags(flags);
+
+    CoalescerStats c = coalescer.get_stats();
+    os << "vadd requests: " << c.requests << " in " << c.batches << " wide_vadd runs" << std::endl;
+}
+} // namespace example_utils
+} // namespace xilinx
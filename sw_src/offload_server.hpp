@@ -0,0 +1,120 @@
+#ifndef OFFLOAD_SERVER_HPP__
+#define OFFLOAD_SERVER_HPP__
+
+#pragma once
+
+#include "coalescer.hpp"
+#include "device_backend.hpp"
+#include "latency_histogram.hpp"
+#include "offload_protocol.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+struct OffloadServerConfig
+{
+    // vadd jobs go through a VaddCoalescer; larger jobs are split into
+    // batches of this many elements
+    size_t vadd_batch_elems               = 4 * 1024 * 1024;
+    std::chrono::microseconds vadd_window = std::chrono::microseconds(100);
+    unsigned int vadd_depth               = 4;
+
+    // Buffer pairs for resize jobs, each sized for the largest image the
+    // resize_accel_rgb kernel accepts
+    unsigned int resize_slots = 2;
+
+    // Requests a client may have outstanding before the daemon stops
+    // reading its socket
+    unsigned int max_outstanding = 64;
+};
+
+// Creates a SOCK_SEQPACKET UNIX socket listening at 'path', replacing a
+// stale socket file left by an earlier daemon
+int offload_listen(const std::string &path);
+
+// Long-running owner of a device that runs vadd and resize jobs for other
+// processes, so none of them pays for programming the card and all of them
+// share its compute units.
+//
+// Each client connection gets a reader thread, which validates requests
+// and submits them, and a completer thread, which waits for them in order
+// and replies. vadd jobs from every client are merged by one VaddCoalescer,
+// so many small requests become a few wide_vadd runs, with up to
+// 'vadd_depth' batches in flight across the compute units. Resize jobs run
+// on a pool of preallocated buffer pairs. Payloads are copied between the
+// client's shared memory and the pooled device buffers; nothing is
+// allocated on the device per job.
+//
+// Latency is measured per client from receiving a request to sending its
+// reply, and reported when the client disconnects and by print_stats().
+class OffloadServer
+{
+private:
+    struct Job;
+    struct Session;
+
+    struct ResizeSlot
+    {
+        BufferHandle in, out;
+        bool busy = false;
+    };
+
+    struct ClientReport
+    {
+        std::string name;
+        int pid;
+        uint64_t failed;
+        LatencyHistogram latency;
+    };
+
+    DeviceBackend &dev;
+    int listen_fd;
+    OffloadServerConfig config;
+    VaddCoalescer coalescer;
+
+    std::mutex mutex;
+    std::condition_variable resize_cv;
+    std::vector<ResizeSlot> resize_slots;
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<ClientReport> reports;
+    std::atomic<bool> stopping;
+
+    void reader_main(Session &s);
+    void completer_main(Session &s);
+    void attach(Session &s, const OffloadRequest &req, const std::vector<int> &fds, Job &job);
+    void submit(Session &s, const OffloadRequest &req, Job &job);
+    bool submit_vadd(Session &s, const OffloadRequest &req, Job &job);
+    bool submit_resize(Session &s, const OffloadRequest &req, Job &job);
+    void push(Session &s, Job &job);
+    void close_session(Session &s);
+    ResizeSlot *acquire_resize_slot();
+    void release_resize_slot(ResizeSlot *slot);
+    void reap_sessions();
+
+public:
+    // Serves connections accepted on 'listen_fd', which the server closes
+    OffloadServer(DeviceBackend &dev, int listen_fd, const OffloadServerConfig &config = OffloadServerConfig());
+    ~OffloadServer();
+
+    OffloadServer(const OffloadServer &) = delete;
+    OffloadServer &operator=(const OffloadServer &) = delete;
+
+    // Accepts clients until one sends OFFLOAD_SHUTDOWN, then disconnects
+    // the others once their outstanding jobs have been answered
+    void run();
+
+    // One line per client seen so far
+    void print_stats(std::ostream &os);
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // OFFLOAD_SERVER_HPP__
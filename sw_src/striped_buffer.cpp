@@ -0,0 +1,77 @@
+#include "striped_buffer.hpp"
+
+namespace xilinx {
+namespace example_utils {
+StripedBuffer::StripedBuffer(XilinxOclHelper &xocl,
+                             size_t size,
+                             unsigned int num_stripes,
+                             cl_mem_flags flags,
+                             const HostAllocPolicy &policy)
+    : policy(policy), host(nullptr), bytes(size)
+{
+    if (num_stripes == 0 || size == 0) {
+        throw_lineexception("Striped buffer needs a size and at least one stripe");
+    }
+
+    // Page-sized stripes keep every slice usable with CL_MEM_USE_HOST_PTR
+    stripe_size = (size + num_stripes - 1) / num_stripes;
+    stripe_size = (stripe_size + 4095) / 4096 * 4096;
+
+    host = host_alloc(stripe_size * num_stripes, policy);
+    try {
+        for (unsigned int k = 0; k < num_stripes; k++) {
+            stripes.push_back(xocl.create_buffer_from_host_ptr((char *)host + k * stripe_size, stripe_size, flags));
+        }
+    }
+    catch (...) {
+        stripes.clear();
+        host_free(host, stripe_size * num_stripes, policy);
+        throw;
+    }
+}
+
+StripedBuffer::~StripedBuffer()
+{
+    size_t total = stripe_size * stripes.size();
+    stripes.clear();
+    host_free(host, total, policy);
+}
+
+void StripedBuffer::bind(cl::Kernel &krnl, unsigned int first_arg)
+{
+    for (unsigned int k = 0; k < stripes.size(); k++) {
+        krnl.setArg(first_arg + k, stripes[k]);
+    }
+}
+
+void *StripedBuffer::data()
+{
+    return host;
+}
+
+size_t StripedBuffer::size() const
+{
+    return bytes;
+}
+
+size_t StripedBuffer::stripe_bytes() const
+{
+    return stripe_size;
+}
+
+unsigned int StripedBuffer::num_stripes() const
+{
+    return stripes.size();
+}
+
+const std::vector<cl::Buffer> &StripedBuffer::get_buffers() const
+{
+    return stripes;
+}
+
+std::vector<cl::Memory> StripedBuffer::memory_objects() const
+{
+    return std::vector<cl::Memory>(stripes.begin(), stripes.end());
+}
+} // namespace example_utils
+} // namespace xilinx
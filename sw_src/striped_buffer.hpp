@@ -0,0 +1,65 @@
+#ifndef STRIPED_BUFFER_HPP__
+#define STRIPED_BUFFER_HPP__
+
+#pragma once
+
+#include "host_memory.hpp"
+#include "xilinx_ocl_helper.hpp"
+
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Stripes per operand of the striped_vadd kernel
+#define STRIPED_VADD_STRIPES 4
+
+// One logical vector split into contiguous stripes, each its own cl::Buffer
+// so that each can be placed in a different memory channel (e.g. an HBM
+// pseudo-channel) and streamed by its own AXI master.
+//
+// All stripes wrap consecutive slices of a single host allocation with
+// CL_MEM_USE_HOST_PTR, so on the host the vector is one linear array at
+// data() and needs no scatter or gather copies. Stripe k holds elements
+// [k * stripe_bytes(), (k + 1) * stripe_bytes()); the last stripes may be
+// partly or entirely past size().
+class StripedBuffer
+{
+private:
+    std::vector<cl::Buffer> stripes;
+    HostAllocPolicy policy;
+    void *host;
+    size_t bytes;
+    size_t stripe_size;
+
+public:
+    StripedBuffer(XilinxOclHelper &xocl,
+                  size_t size,
+                  unsigned int num_stripes,
+                  cl_mem_flags flags,
+                  const HostAllocPolicy &policy = HostAllocPolicy());
+    ~StripedBuffer();
+
+    StripedBuffer(const StripedBuffer &) = delete;
+    StripedBuffer &operator=(const StripedBuffer &) = delete;
+
+    // Sets stripe k as argument first_arg + k of 'krnl'. Call before the
+    // first migration so XRT places each stripe in the bank its argument is
+    // connected to.
+    void bind(cl::Kernel &krnl, unsigned int first_arg);
+
+    void *data();
+    size_t size() const;
+
+    // Bytes per stripe, a multiple of 4 KiB
+    size_t stripe_bytes() const;
+    unsigned int num_stripes() const;
+
+    const std::vector<cl::Buffer> &get_buffers() const;
+
+    // The stripes as a list for enqueueMigrateMemObjects()
+    std::vector<cl::Memory> memory_objects() const;
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // STRIPED_BUFFER_HPP__
@@ -0,0 +1,227 @@
+#include "verify.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace xilinx {
+namespace example_utils {
+// Digests are computed over fixed blocks so they do not depend on options
+#define HASH_BLOCK_ELEMS (64 * 1024)
+
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+
+static unsigned int thread_count(const VerifyOptions &opts, size_t num_chunks)
+{
+    unsigned int n = opts.threads ? opts.threads : std::thread::hardware_concurrency();
+    n              = std::max(1u, n);
+    return (unsigned int)std::min<size_t>(n, std::max<size_t>(1, num_chunks));
+}
+
+// Runs fn(chunk_index, first, count) for every chunk, with chunks handed out
+// dynamically to the worker threads
+static void for_each_chunk(size_t total,
+                           size_t chunk,
+                           unsigned int threads,
+                           const std::function<void(size_t, size_t, size_t)> &fn)
+{
+    size_t num_chunks = (total + chunk - 1) / chunk;
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for (size_t k = next++; k < num_chunks; k = next++) {
+            size_t first = k * chunk;
+            fn(k, first, std::min(chunk, total - first));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : pool) {
+        t.join();
+    }
+}
+
+// True if a[0..n) == b[0..n)
+static bool block_equal(const uint32_t *a, const uint32_t *b, size_t n)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i diff = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        diff      = _mm_or_si128(diff, _mm_xor_si128(x, y));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(diff, _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+#endif
+    uint32_t rest = 0;
+    for (; i < n; i++) {
+        rest |= a[i] ^ b[i];
+    }
+    return rest == 0;
+}
+
+struct ChunkResult
+{
+    size_t mismatches = 0;
+    std::vector<VerifyRange> ranges;
+};
+
+VerifyResult verify_buffer(const uint32_t *actual,
+                           size_t count,
+                           const ExpectedGenerator &expected,
+                           const VerifyOptions &opts)
+{
+    size_t chunk      = std::max<size_t>(opts.chunk_elems, 1);
+    size_t num_chunks = (count + chunk - 1) / chunk;
+    std::vector<ChunkResult> results(num_chunks);
+
+    // The mostly-matching case is compared in sub-blocks with SIMD; only
+    // sub-blocks that differ are scanned element by element
+    const size_t sub = 256;
+
+    for_each_chunk(count, chunk, thread_count(opts, num_chunks), [&](size_t k, size_t first, size_t n) {
+        thread_local std::vector<uint32_t> exp;
+        exp.resize(chunk);
+        expected(first, n, exp.data());
+
+        ChunkResult &r = results[k];
+        for (size_t s = 0; s < n; s += sub) {
+            size_t len = std::min(sub, n - s);
+            if (block_equal(actual + first + s, exp.data() + s, len)) {
+                continue;
+            }
+            for (size_t i = s; i < s + len; i++) {
+                if (actual[first + i] == exp[i]) {
+                    continue;
+                }
+                r.mismatches++;
+                size_t idx = first + i;
+                if (!r.ranges.empty() && r.ranges.back().last + 1 == idx) {
+                    r.ranges.back().last = idx;
+                }
+                else if (r.ranges.size() <= opts.max_ranges) {
+                    r.ranges.push_back({idx, idx});
+                }
+            }
+        }
+    });
+
+    // Merge in order, joining runs that straddle chunk boundaries
+    VerifyResult result;
+    result.checked = count;
+    for (auto &r : results) {
+        result.mismatches += r.mismatches;
+        for (auto &range : r.ranges) {
+            if (!result.ranges.empty() && result.ranges.back().last + 1 == range.first) {
+                result.ranges.back().last = range.last;
+            }
+            else if (result.ranges.size() < opts.max_ranges) {
+                result.ranges.push_back(range);
+            }
+            else {
+                result.ranges_truncated = true;
+            }
+        }
+    }
+    return result;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Four independent lanes keep the multiplier pipeline busy
+static uint64_t hash_block(const uint32_t *p, size_t n, uint64_t seed)
+{
+    uint64_t lane[4] = {seed + PRIME1, seed + PRIME2, seed, seed - PRIME1};
+    size_t i         = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int j = 0; j < 4; j++) {
+            uint64_t w;
+            memcpy(&w, p + i + 2 * j, sizeof(w));
+            lane[j] = rotl64(lane[j] + w * PRIME2, 31) * PRIME1;
+        }
+    }
+    uint64_t h = rotl64(lane[0], 1) + rotl64(lane[1], 7) + rotl64(lane[2], 12) + rotl64(lane[3], 18);
+    for (; i < n; i++) {
+        h = rotl64(h ^ (p[i] * PRIME1), 23) * PRIME2;
+    }
+    return fmix64(h ^ n);
+}
+
+static uint64_t combine_blocks(const std::vector<uint64_t> &blocks, size_t count)
+{
+    uint64_t h = PRIME3;
+    for (auto b : blocks) {
+        h = rotl64(h ^ b, 27) * PRIME1 + PRIME2;
+    }
+    return fmix64(h ^ count);
+}
+
+uint64_t hash_buffer(const uint32_t *data, size_t count, const VerifyOptions &opts)
+{
+    size_t num_blocks = (count + HASH_BLOCK_ELEMS - 1) / HASH_BLOCK_ELEMS;
+    std::vector<uint64_t> blocks(num_blocks);
+
+    for_each_chunk(count, HASH_BLOCK_ELEMS, thread_count(opts, num_blocks), [&](size_t k, size_t first, size_t n) {
+        blocks[k] = hash_block(data + first, n, k);
+    });
+    return combine_blocks(blocks, count);
+}
+
+void vadd_expected(size_t first, size_t count, uint32_t *out)
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (uint32_t)(3 * (first + i));
+    }
+}
+
+void print_verify_result(std::ostream &os, const VerifyResult &result)
+{
+    os << result.mismatches << " of " << result.checked << " elements mismatched";
+    if (result.ranges.empty()) {
+        os << std::endl;
+        return;
+    }
+    os << " in " << (result.ranges_truncated ? "more than " : "") << result.ranges.size()
+       << " range(s):";
+    for (auto &r : result.ranges) {
+        if (r.first == r.last) {
+            os << " [" << r.first << "]";
+        }
+        else {
+            os << " [" << r.first << ", " << r.last << "]";
+        }
+    }
+    if (result.ranges_truncated) {
+        os << " ...";
+    }
+    os << std::endl;
+}
+} // namespace example_utils
+} // namespace xilinx
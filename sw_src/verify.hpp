@@ -0,0 +1,75 @@
+#ifndef VERIFY_HPP__
+#define VERIFY_HPP__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace xilinx {
+namespace example_utils {
+// Fills out[0..count) with the expected values of elements first..first+count-1.
+// Called concurrently from several threads on disjoint ranges.
+typedef std::function<void(size_t first, size_t count, uint32_t *out)> ExpectedGenerator;
+
+// Inclusive range of mismatching element indices
+struct VerifyRange
+{
+    size_t first;
+    size_t last;
+};
+
+struct VerifyResult
+{
+    size_t checked    = 0;
+    size_t mismatches = 0;
+
+    // The first 'max_ranges' runs of consecutive mismatches, in order
+    std::vector<VerifyRange> ranges;
+    bool ranges_truncated = false;
+
+    bool ok() const
+    {
+        return mismatches == 0;
+    }
+};
+
+struct VerifyOptions
+{
+    // Worker threads; 0 uses one per hardware thread
+    unsigned int threads = 0;
+
+    // Elements generated and compared at a time. The default keeps both the
+    // expected values and the data being checked in the L2 cache.
+    size_t chunk_elems = 32 * 1024;
+
+    size_t max_ranges = 16;
+};
+
+// Checks 'actual' against values produced chunk by chunk by 'expected', so no
+// full-size golden copy is ever allocated. Chunks are spread over threads and
+// compared with SIMD; unlike a first-mismatch loop, every element is checked
+// and all mismatches are counted.
+VerifyResult verify_buffer(const uint32_t *actual,
+                           size_t count,
+                           const ExpectedGenerator &expected,
+                           const VerifyOptions &opts = VerifyOptions());
+
+// Order-sensitive 64-bit digest of 'data', for comparing a result against a
+// digest recorded from a known-good run when no generator for the expected
+// values exists. The value does not depend on the thread count.
+uint64_t hash_buffer(const uint32_t *data, size_t count, const VerifyOptions &opts = VerifyOptions());
+
+// Expected output of the vadd kernels for the usual inputs a[i] = i and
+// b[i] = 2 * i
+void vadd_expected(size_t first, size_t count, uint32_t *out);
+
+// Prints e.g. "3 of 1048576 elements mismatched in 2 range(s): [10, 11] [900]"
+void print_verify_result(std::ostream &os, const VerifyResult &result);
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // VERIFY_HPP__
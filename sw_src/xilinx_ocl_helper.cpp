@@ -1,5 +1,8 @@
 #include "xilinx_ocl_helper.hpp"
 
+#include "numa_utils.hpp"
+
+#include <functional>
 #include <unistd.h>
 
 namespace xilinx {
@@ -29,6 +32,17 @@ std::vector<cl::Device> XilinxOclHelper::find_xilinx_devices()
 }
 
 void XilinxOclHelper::initialize(std::string xclbin_file_name)
+{
+    // Held while programming, so threads calling in meanwhile wait for the
+    // device instead of finding it uninitialized
+    std::lock_guard<std::mutex> lock(init_mutex);
+    if (is_initialized || init_future.valid()) {
+        throw_lineexception("OCL is already initialized or initializing");
+    }
+    program_device(xclbin_file_name);
+}
+
+void XilinxOclHelper::program_device(std::string xclbin_file_name)
 {
     // Find Xilinx OpenCL devices
     std::vector<cl::Device> devices = find_xilinx_devices();
@@ -73,9 +87,33 @@ void XilinxOclHelper::initialize(std::string xclbin_file_name)
     }
 }
 
+std::shared_future<void> XilinxOclHelper::initialize_async(std::string xclbin_file_name)
+{
+    std::lock_guard<std::mutex> lock(init_mutex);
+    if (is_initialized || init_future.valid()) {
+        throw_lineexception("OCL is already initialized or initializing");
+    }
+    auto program = [this, xclbin_file_name]() { program_device(xclbin_file_name); };
+    init_future  = std::async(std::launch::async, program).share();
+    return init_future;
+}
+
+bool XilinxOclHelper::wait_for_initialization()
+{
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(init_mutex);
+        pending = init_future;
+    }
+    if (pending.valid()) {
+        pending.get();
+    }
+    return is_initialized;
+}
+
 cl::Kernel XilinxOclHelper::get_kernel(std::string kernel_name)
 {
-    if (!is_initialized) {
+    if (!wait_for_initialization()) {
         throw_lineexception("Attempted to get kernel without initializing OCL");
     }
 
@@ -85,7 +123,32 @@ cl::Kernel XilinxOclHelper::get_kernel(std::string kernel_name)
 
 cl::CommandQueue XilinxOclHelper::get_command_queue(bool in_order, bool enable_profiling)
 {
-    if (!is_initialized) {
+    if (!wait_for_initialization()) {
+        throw_lineexception("Attempted to get command queue without initializing OCL");
+    }
+
+    cl_command_queue_properties props = 0;
+
+    if (!in_order) {
+        props |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+    }
+    if (enable_profiling) {
+        props |= CL_QUEUE_PROFILING_ENABLE;
+    }
+
+    cl::CommandQueue q(context, device, props);
+    return q;
+}
+
+XilinxOclHelper::ThreadResources &XilinxOclHelper::get_thread_resources()
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return thread_resources[std::this_thread::get_id()];
+}
+
+cl::CommandQueue XilinxOclHelper::get_thread_command_queue(bool in_order, bool enable_profiling)
+{
+    if (!wait_for_initialization()) {
         throw_lineexception("Attempted to get command queue without initializing OCL");
     }
 
@@ -98,13 +161,93 @@ cl::CommandQueue XilinxOclHelper::get_command_queue(bool in_order, bool enable_p
         props |= CL_QUEUE_PROFILING_ENABLE;
     }
 
+    ThreadResources &res = get_thread_resources();
+    auto it              = res.queues.find(props);
+    if (it != res.queues.end()) {
+        return it->second;
+    }
+
     cl::CommandQueue q(context, device, props);
+    res.queues[props] = q;
     return q;
 }
 
+cl::CommandQueue XilinxOclHelper::get_shared_command_queue(bool enable_profiling)
+{
+    if (!wait_for_initialization()) {
+        throw_lineexception("Attempted to get command queue without initializing OCL");
+    }
+
+    cl_command_queue_properties props = CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+    if (enable_profiling) {
+        props |= CL_QUEUE_PROFILING_ENABLE;
+    }
+
+    // Profiling and non-profiling queues live in separate halves of the pool
+    size_t shard = std::hash<std::thread::id>()(std::this_thread::get_id()) % shared_queue_count;
+    if (enable_profiling) {
+        shard += shared_queue_count;
+    }
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (shared_queues.empty()) {
+        shared_queues.resize(2 * shared_queue_count);
+    }
+    if (shared_queues[shard]() == NULL) {
+        shared_queues[shard] = cl::CommandQueue(context, device, props);
+    }
+    return shared_queues[shard];
+}
+
+void XilinxOclHelper::set_shared_queue_count(unsigned int count)
+{
+    if (count == 0) {
+        throw_lineexception("Shared queue pool must contain at least one queue");
+    }
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!shared_queues.empty()) {
+        throw_lineexception("Shared queue pool size must be set before first use");
+    }
+    shared_queue_count = count;
+}
+
+cl::Buffer XilinxOclHelper::acquire_cached_buffer(size_t size, cl_mem_flags flags)
+{
+    if (!wait_for_initialization()) {
+        throw_lineexception("Attempted to create buffer before initialization");
+    }
+
+    ThreadResources &res = get_thread_resources();
+    auto it              = res.free_buffers.find(std::make_pair(size, flags));
+    if (it != res.free_buffers.end()) {
+        cl::Buffer buf = it->second;
+        res.free_buffers.erase(it);
+        return buf;
+    }
+
+    cl::Buffer buf(context, flags, size, NULL, NULL);
+    return buf;
+}
+
+void XilinxOclHelper::release_cached_buffer(cl::Buffer buf)
+{
+    size_t size        = buf.getInfo<CL_MEM_SIZE>();
+    cl_mem_flags flags = buf.getInfo<CL_MEM_FLAGS>();
+
+    ThreadResources &res = get_thread_resources();
+    res.free_buffers.insert(std::make_pair(std::make_pair(size, flags), buf));
+}
+
+void XilinxOclHelper::release_thread_resources()
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    thread_resources.erase(std::this_thread::get_id());
+}
+
 cl::Buffer XilinxOclHelper::create_buffer(size_t size, cl_mem_flags flags)
 {
-    if (!is_initialized) {
+    if (!wait_for_initialization()) {
         throw_lineexception("Attempted to create buffer before initialization");
     }
 
@@ -114,7 +257,7 @@ cl::Buffer XilinxOclHelper::create_buffer(size_t size, cl_mem_flags flags)
 
 cl::Buffer XilinxOclHelper::create_buffer_in_bank(int bank, size_t size, cl_mem_flags flags)
 {
-    if (!is_initialized) {
+    if (!wait_for_initialization()) {
         throw_lineexception("Attempted to create buffer before initialization");
     }
 
@@ -127,31 +270,80 @@ cl::Buffer XilinxOclHelper::create_buffer_in_bank(int bank, size_t size, cl_mem_
     return buf;
 }
 
+cl::Buffer XilinxOclHelper::create_buffer_from_host_ptr(void *ptr, size_t size, cl_mem_flags flags)
+{
+    if (!wait_for_initialization()) {
+        throw_lineexception("Attempted to create buffer before initialization");
+    }
+    if (reinterpret_cast<uintptr_t>(ptr) % 4096 != 0) {
+        throw_lineexception("Host pointer for CL_MEM_USE_HOST_PTR must be 4 KiB aligned");
+    }
+
+    cl::Buffer buf(context, flags | CL_MEM_USE_HOST_PTR, size, ptr, NULL);
+    return buf;
+}
+
 int XilinxOclHelper::get_fd_for_buffer(cl::Buffer buf)
 {
-    int fd;
-    xclGetMemObjectFd(buf(), &fd);
+    int fd = -1;
+    if (xclGetMemObjectFd(buf(), &fd) != CL_SUCCESS) {
+        throw_lineexception("Unable to export buffer as a file descriptor");
+    }
     return fd;
 }
 
 cl::Buffer XilinxOclHelper::get_buffer_from_fd(int fd)
 {
+    wait_for_initialization();
     cl::Buffer buffer;
-    xclGetMemObjectFromFd(context(), device(), 0, fd, &buffer());
+    if (xclGetMemObjectFromFd(context(), device(), 0, fd, &buffer()) != CL_SUCCESS) {
+        throw_lineexception("Unable to import buffer from file descriptor");
+    }
     return buffer;
 }
 
 const cl::Context &XilinxOclHelper::get_context()
 {
+    wait_for_initialization();
     return context;
 }
 
-XilinxOclHelper::XilinxOclHelper()
+std::string XilinxOclHelper::get_device_bdf()
 {
+    if (!wait_for_initialization()) {
+        throw_lineexception("Attempted to query device before initialization");
+    }
+
+#ifdef CL_DEVICE_PCIE_BDF
+    char bdf[64] = {0};
+    if (clGetDeviceInfo(device(), CL_DEVICE_PCIE_BDF, sizeof(bdf) - 1, bdf, NULL) == CL_SUCCESS) {
+        return std::string(bdf);
+    }
+#endif
+    return std::string();
+}
+
+int XilinxOclHelper::get_numa_node()
+{
+    return get_pci_numa_node(get_device_bdf());
+}
+
+XilinxOclHelper::XilinxOclHelper() : is_initialized(false)
+{
+    shared_queue_count = 4;
 }
 
 XilinxOclHelper::~XilinxOclHelper()
 {
+    // Never tear down under a programming thread still using this object
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(init_mutex);
+        pending = init_future;
+    }
+    if (pending.valid()) {
+        pending.wait();
+    }
 }
 
 } // namespace example_utils
@@ -13,9 +13,15 @@
 
 #include <CL/cl2.hpp> //"/opt/intel/opencl-1.2-4.4.0.117/include/CL/cl.h"
 #include <CL/cl_ext_xilinx.h>
+#include <atomic>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 // When creating a buffer with user pointer (CL_MEM_USE_HOST_PTR), under the hood
 // User ptr is used if and only if it is properly aligned (page aligned). When not
@@ -45,15 +51,44 @@ struct aligned_allocator
 
 namespace xilinx {
 namespace example_utils {
+// Threading contract: the device is programmed once, by either initialize()
+// or initialize_async(), from any thread; further calls to either throw.
+// Once programming has finished, every public member of XilinxOclHelper may
+// be called concurrently from any number of host threads.
+// The underlying OpenCL context, device and program are shared. cl::Kernel
+// objects are NOT safe to share, because setArg() and enqueueTask() are not
+// atomic with respect to each other, so each thread should call get_kernel()
+// for itself.
 class XilinxOclHelper
 {
 private:
-    bool is_initialized = false;
+    // Resources owned by a single host thread. Only the owning thread touches
+    // the contents; the map holding them is guarded by pool_mutex.
+    struct ThreadResources
+    {
+        std::map<cl_command_queue_properties, cl::CommandQueue> queues;
+        std::multimap<std::pair<size_t, cl_mem_flags>, cl::Buffer> free_buffers;
+    };
+
+    std::atomic<bool> is_initialized;
+    std::mutex init_mutex;
+    std::shared_future<void> init_future;
     cl::Device device;
     cl::Context context;
     cl::Program program;
 
+    std::mutex pool_mutex;
+    std::map<std::thread::id, ThreadResources> thread_resources;
+    std::vector<cl::CommandQueue> shared_queues;
+    unsigned int shared_queue_count;
+
     std::vector<cl::Device> find_xilinx_devices();
+    void program_device(std::string xclbin_file_name);
+    ThreadResources &get_thread_resources();
+
+    // Waits for a pending initialize_async(), rethrowing its error if it
+    // failed, and returns whether the helper is initialized
+    bool wait_for_initialization();
 
 public:
     XilinxOclHelper();
@@ -61,14 +96,54 @@ public:
 
     void initialize(std::string xclbin_file_name);
 
+    // Programs the device on a background thread and returns at once, so
+    // image decode, buffer population in plain host memory and reference
+    // computations can overlap with the download of the bitstream. Every
+    // member below that needs the device waits for the programming to finish
+    // (and rethrows its error) implicitly; the future is only needed to wait
+    // or check for errors explicitly.
+    std::shared_future<void> initialize_async(std::string xclbin_file_name);
+
     cl::CommandQueue get_command_queue(bool in_order         = false,
                                        bool enable_profiling = false);
+
+    // Returns the calling thread's own command queue, creating it on first
+    // use. Repeated calls from the same thread return the same queue.
+    cl::CommandQueue get_thread_command_queue(bool in_order         = true,
+                                              bool enable_profiling = false);
+
+    // Returns one of a small pool of out-of-order queues shared by all
+    // threads. Threads are spread across the pool by thread ID.
+    cl::CommandQueue get_shared_command_queue(bool enable_profiling = false);
+    void set_shared_queue_count(unsigned int count);
+
+    // Per-thread buffer cache. Released buffers are kept on the calling
+    // thread's free list and handed back out for requests with the same size
+    // and flags, avoiding a clCreateBuffer per request.
+    cl::Buffer acquire_cached_buffer(size_t size, cl_mem_flags flags);
+    void release_cached_buffer(cl::Buffer buf);
+
+    // Drops the calling thread's queues and cached buffers. Call before a
+    // worker thread exits.
+    void release_thread_resources();
+
     cl::Kernel get_kernel(std::string kernel_name);
     cl::Buffer create_buffer(size_t size, cl_mem_flags flags);
     cl::Buffer create_buffer_in_bank(int bank, size_t size, cl_mem_flags flags);
+
+    // Wraps existing host memory with CL_MEM_USE_HOST_PTR. The pointer must be
+    // 4 KiB aligned (e.g. from aligned_allocator or host_alloc()), otherwise
+    // XRT would silently shadow-copy it, so unaligned pointers are rejected.
+    cl::Buffer create_buffer_from_host_ptr(void *ptr, size_t size, cl_mem_flags flags);
     int get_fd_for_buffer(cl::Buffer buf);
     cl::Buffer get_buffer_from_fd(int fd);
     const cl::Context &get_context();
+
+    // PCI address of the programmed device (e.g. "0000:65:00.1") and the NUMA
+    // node it is attached to, or an empty string / -1 if XRT does not report
+    // it. Host buffers and worker threads should live on this node.
+    std::string get_device_bdf();
+    int get_numa_node();
 };
 } // namespace example_utils
 } // namespace xilinx
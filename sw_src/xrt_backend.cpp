@@ -0,0 +1,306 @@
+#include "xrt_backend.hpp"
+
+#include "line_exception.hpp"
+
+#include <cstring>
+
+// Kernel runs that may be waited on at once. More runs than compute units
+// only queue up in XRT's scheduler, so a few threads are enough.
+#define XRT_RUN_THREADS 4
+
+namespace xilinx {
+namespace example_utils {
+class XrtBuffer : public BackendBuffer
+{
+private:
+    std::mutex mutex;
+    xrt::device device;
+    size_t bytes;
+    int group;
+    bool allocated;
+    void *mapped;
+
+    // Set for sub-buffers, which must not outlive their parent's BO
+    BufferHandle parent;
+
+public:
+    xrt::bo bo;
+
+    XrtBuffer(xrt::device device, size_t size)
+        : device(device), bytes(size), group(0), allocated(false), mapped(nullptr)
+    {
+    }
+
+    XrtBuffer(const BufferHandle &parent, xrt::bo sub, size_t size)
+        : bytes(size), group(0), allocated(true), mapped(nullptr), parent(parent), bo(sub)
+    {
+    }
+
+    size_t size() const override
+    {
+        return bytes;
+    }
+
+    void *host_ptr() override
+    {
+        xrt::bo &b = get_bo();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!mapped) {
+            mapped = b.map<void *>();
+        }
+        return mapped;
+    }
+
+    // Chooses the bank for a buffer that has not been allocated yet
+    void place(int memory_group)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!allocated) {
+            group = memory_group;
+        }
+    }
+
+    xrt::bo &get_bo()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!allocated) {
+            bo        = xrt::bo(device, bytes, xrt::bo::flags::normal, group);
+            allocated = true;
+        }
+        return bo;
+    }
+};
+
+namespace detail {
+// Reusable xrt::run objects for one kernel, each remembering the arguments
+// it was last started with
+class XrtRunPool
+{
+private:
+    struct Slot
+    {
+        xrt::run run;
+        KernelArgs applied;
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Slot>> idle;
+
+public:
+    xrt::kernel krnl;
+
+    XrtRunPool(xrt::kernel krnl) : krnl(krnl) {}
+
+    // Starts the kernel with 'args' on an idle run object and waits for it.
+    // Called from the compute engine's threads.
+    void execute(const KernelArgs &args)
+    {
+        std::unique_ptr<Slot> slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty()) {
+                slot = std::move(idle.back());
+                idle.pop_back();
+            }
+        }
+        if (!slot) {
+            slot.reset(new Slot{xrt::run(krnl), KernelArgs()});
+        }
+
+        for (unsigned int i = 0; i < args.count(); i++) {
+            if (!args.is_set(i) || args.same_as(i, slot->applied)) {
+                continue;
+            }
+            if (args.is_buffer(i)) {
+                slot->run.set_arg(i, XrtBackend::get_bo(args.buffer(i)));
+            }
+            else {
+                // set_arg() takes the value's size from its type
+                uint64_t value = 0;
+                memcpy(&value, args.scalar_data(i), args.scalar_size(i));
+                switch (args.scalar_size(i)) {
+                case 1:
+                    slot->run.set_arg(i, (uint8_t)value);
+                    break;
+                case 2:
+                    slot->run.set_arg(i, (uint16_t)value);
+                    break;
+                case 4:
+                    slot->run.set_arg(i, (uint32_t)value);
+                    break;
+                default:
+                    slot->run.set_arg(i, value);
+                    break;
+                }
+            }
+            slot->applied.set_from(i, args, i);
+        }
+
+        slot->run.start();
+        ert_cmd_state state = slot->run.wait();
+
+        // A failed run may have left the object unusable, so only successful
+        // ones go back to the pool
+        if (state != ERT_CMD_STATE_COMPLETED) {
+            throw_lineexception("Kernel run ended in state " + std::to_string((int)state));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(slot));
+    }
+};
+} // namespace detail
+
+// Keeps the arguments of its latest run, so like OclPreparedKernel each run
+// only changes the indices it sets; its own run pool means the fixed
+// arguments are applied to each run object once
+class XrtPreparedKernel : public PreparedKernel
+{
+private:
+    CommandTracker &tracker;
+    CommandEngine &engine;
+    std::shared_ptr<detail::XrtRunPool> pool;
+
+    std::mutex mutex;
+    KernelArgs current;
+
+public:
+    XrtPreparedKernel(CommandTracker &tracker,
+                      CommandEngine &engine,
+                      std::shared_ptr<detail::XrtRunPool> pool,
+                      const KernelArgs &fixed)
+        : tracker(tracker), engine(engine), pool(pool), current(fixed)
+    {
+    }
+
+    EventHandle run(const KernelArgs &args, const std::vector<EventHandle> &deps) override
+    {
+        KernelArgs merged;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned int i = 0; i < args.count(); i++) {
+                if (args.is_set(i)) {
+                    current.set_from(i, args, i);
+                }
+            }
+            merged = current;
+        }
+
+        std::shared_ptr<detail::XrtRunPool> p = pool;
+        return tracker.submit([p, merged]() { p->execute(merged); }, engine, deps);
+    }
+};
+
+XrtBackend::XrtBackend(const std::string &xclbin, unsigned int device_index)
+    : h2d_engine(1), d2h_engine(1), compute_engine(XRT_RUN_THREADS)
+{
+    device = xrt::device(device_index);
+    uuid   = device.load_xclbin(xclbin);
+}
+
+XrtBackend::~XrtBackend()
+{
+    finish();
+}
+
+const char *XrtBackend::name() const
+{
+    return "XRT native";
+}
+
+std::shared_ptr<detail::XrtRunPool> XrtBackend::get_pool(const std::string &kernel)
+{
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    auto it = kernels.find(kernel);
+    if (it == kernels.end()) {
+        auto pool = std::make_shared<detail::XrtRunPool>(xrt::kernel(device, uuid, kernel));
+        it        = kernels.insert(std::make_pair(kernel, pool)).first;
+    }
+    return it->second;
+}
+
+BufferHandle XrtBackend::create_buffer(size_t size, BufferAccess /*access*/)
+{
+    // BOs are always readable and writable by both sides; 'access' only
+    // matters to OpenCL
+    return std::make_shared<XrtBuffer>(device, size);
+}
+
+BufferHandle XrtBackend::create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size)
+{
+    if (offset % 4096 != 0 || offset + size > parent->size()) {
+        throw_lineexception("Sub-buffer must start on a 4 KiB boundary and fit in its parent");
+    }
+    return std::make_shared<XrtBuffer>(parent, xrt::bo(get_bo(parent), size, offset), size);
+}
+
+void XrtBackend::bind_kernel_args(const std::string &kernel, const KernelArgs &args)
+{
+    std::shared_ptr<detail::XrtRunPool> pool = get_pool(kernel);
+    for (unsigned int i = 0; i < args.count(); i++) {
+        if (args.is_set(i) && args.is_buffer(i)) {
+            XrtBuffer *b = dynamic_cast<XrtBuffer *>(args.buffer(i).get());
+            if (b == nullptr) {
+                throw_lineexception("Buffer was not created by an XrtBackend");
+            }
+            b->place(pool->krnl.group_id(i));
+        }
+    }
+}
+
+EventHandle XrtBackend::migrate(const std::vector<BufferHandle> &bufs,
+                                MigrateDirection direction,
+                                const std::vector<EventHandle> &deps)
+{
+    std::vector<BufferHandle> targets = bufs;
+    for (auto &buf : targets) {
+        get_bo(buf);
+    }
+
+    auto work = [targets, direction]() {
+        for (auto &buf : targets) {
+            get_bo(buf).sync(direction == MigrateDirection::ToDevice ? XCL_BO_SYNC_BO_TO_DEVICE
+                                                                     : XCL_BO_SYNC_BO_FROM_DEVICE);
+        }
+    };
+    return tracker.submit(work, direction == MigrateDirection::ToDevice ? h2d_engine : d2h_engine, deps);
+}
+
+EventHandle XrtBackend::run_kernel(const std::string &kernel,
+                                   const KernelArgs &args,
+                                   const std::vector<EventHandle> &deps)
+{
+    std::shared_ptr<detail::XrtRunPool> pool = get_pool(kernel);
+    for (unsigned int i = 0; i < args.count(); i++) {
+        if (args.is_set(i) && args.is_buffer(i)) {
+            get_bo(args.buffer(i));
+        }
+    }
+    return tracker.submit([pool, args]() { pool->execute(args); }, compute_engine, deps);
+}
+
+PreparedKernelHandle XrtBackend::prepare_kernel(const std::string &kernel, const KernelArgs &fixed)
+{
+    auto pool = std::make_shared<detail::XrtRunPool>(xrt::kernel(device, uuid, kernel));
+    return std::make_shared<XrtPreparedKernel>(tracker, compute_engine, pool, fixed);
+}
+
+void XrtBackend::finish()
+{
+    tracker.finish();
+}
+
+xrt::device &XrtBackend::get_device()
+{
+    return device;
+}
+
+xrt::bo &XrtBackend::get_bo(const BufferHandle &buf)
+{
+    XrtBuffer *b = dynamic_cast<XrtBuffer *>(buf.get());
+    if (b == nullptr) {
+        throw_lineexception("Buffer was not created by an XrtBackend");
+    }
+    return b->get_bo();
+}
+} // namespace example_utils
+} // namespace xilinx
@@ -0,0 +1,88 @@
+#ifndef XRT_BACKEND_HPP__
+#define XRT_BACKEND_HPP__
+
+#pragma once
+
+#include "command_engine.hpp"
+#include "device_backend.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <xrt/xrt_bo.h>
+#include <xrt/xrt_device.h>
+#include <xrt/xrt_kernel.h>
+
+namespace xilinx {
+namespace example_utils {
+namespace detail {
+class XrtRunPool;
+} // namespace detail
+
+// DeviceBackend on the native XRT C++ API (xrt::bo, xrt::kernel, xrt::run)
+// instead of OpenCL.
+//
+// XRT's native calls are synchronous or return a handle to wait on, so the
+// event graph is kept on the host, as in CpuBackend: migrations run as
+// bo.sync() on one thread per direction, and kernel runs as run.start() plus
+// run.wait() on a small pool of threads. xrt::run objects are kept per kernel
+// and reused; a run only sets the arguments that differ from the last launch
+// of the run object it is given, so a launch with unchanged arguments costs
+// just start() and wait().
+//
+// Buffers are created lazily in the memory bank of the first kernel argument
+// they are bound to (see bind_kernel_args()), or in bank 0 if they are used
+// before being bound.
+class XrtBackend : public DeviceBackend
+{
+private:
+    xrt::device device;
+    xrt::uuid uuid;
+
+    std::mutex kernel_mutex;
+    std::map<std::string, std::shared_ptr<detail::XrtRunPool>> kernels;
+
+    CommandTracker tracker;
+
+    // Declared last so the engines stop before anything they use goes away
+    CommandEngine h2d_engine;
+    CommandEngine d2h_engine;
+    CommandEngine compute_engine;
+
+    std::shared_ptr<detail::XrtRunPool> get_pool(const std::string &kernel);
+
+public:
+    // Programs device 'device_index' with 'xclbin'; throws if there is none
+    XrtBackend(const std::string &xclbin, unsigned int device_index = 0);
+    ~XrtBackend();
+
+    const char *name() const override;
+
+    BufferHandle create_buffer(size_t size, BufferAccess access) override;
+    BufferHandle create_sub_buffer(const BufferHandle &parent, size_t offset, size_t size) override;
+    void bind_kernel_args(const std::string &kernel, const KernelArgs &args) override;
+
+    EventHandle migrate(const std::vector<BufferHandle> &bufs,
+                        MigrateDirection direction,
+                        const std::vector<EventHandle> &deps = {}) override;
+
+    EventHandle run_kernel(const std::string &kernel,
+                           const KernelArgs &args,
+                           const std::vector<EventHandle> &deps = {}) override;
+
+    PreparedKernelHandle prepare_kernel(const std::string &kernel, const KernelArgs &fixed) override;
+
+    void finish() override;
+
+    xrt::device &get_device();
+
+    // The buffer object behind a handle created by an XrtBackend, allocating
+    // it if it has not been used yet
+    static xrt::bo &get_bo(const BufferHandle &buf);
+};
+} // namespace example_utils
+} // namespace xilinx
+
+#endif // XRT_BACKEND_HPP__